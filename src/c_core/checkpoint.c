@@ -0,0 +1,415 @@
+#include "checkpoint.h"
+#include "policy.h"
+#include "scenario.h"
+#include <stdlib.h>
+#include <string.h>
+
+static bool write_resource(const FsmResource *res, FILE *out) {
+    CheckpointResource rec = {
+        .available = res->available,
+        .total = res->total,
+        .num_waiters = res->size,
+        .seq = res->seq,
+        .busy_us = res->busy_us,
+        .start = res->start,
+        .last_change = res->last_change,
+        .series = res->series
+    };
+    return fwrite(&rec, sizeof(rec), 1, out) == 1 &&
+           fwrite(res->waiters, sizeof(FsmWaiter), res->size, out) == (size_t)res->size;
+}
+
+/* Each phase and priority slot, merged over the recording threads. */
+static bool write_histograms(const PhaseTimers *timers, FILE *out) {
+    Histogram *h = (Histogram *)malloc(sizeof(Histogram));
+    bool ok = true;
+    for (int phase = 0; ok && phase < PHASE_COUNT; phase++) {
+        for (int slot = 0; ok && slot < PHASE_PRIORITY_SLOTS; slot++) {
+            phase_timers_merge(timers, (Phase)phase, slot, h);
+            CheckpointHistogram rec = { .total = h->total, .sum = h->sum, .max = h->max };
+            for (int i = 0; i < HIST_BUCKETS; i++) {
+                if (h->counts[i] != 0) rec.num_buckets++;
+            }
+            ok = fwrite(&rec, sizeof(rec), 1, out) == 1;
+            for (int i = 0; ok && i < HIST_BUCKETS; i++) {
+                if (h->counts[i] == 0) continue;
+                CheckpointBucket bucket = { .index = (uint32_t)i, .count = h->counts[i] };
+                ok = fwrite(&bucket, sizeof(bucket), 1, out) == 1;
+            }
+        }
+    }
+    free(h);
+    return ok;
+}
+
+static int task_index(Task *const *tasks, int count, const Task *task) {
+    for (int i = 0; i < count; i++) {
+        if (tasks[i] == task) return i;
+    }
+    return -1;
+}
+
+/* Saves the engine's state at the current virtual time, between events:
+ * the header, then locations (as in binary scenarios), charger positions,
+ * the live tasks (those on drones, then the queue in dispatch order),
+ * drones, counters, the loading bays and charging stations, the drones on
+ * chargers, pending events, phase histograms and the workload generator.
+ * The queue is emptied to read it in order and refilled as it was, so the
+ * run can go on afterwards. */
+bool checkpoint_write(DesEngine *des, FILE *out) {
+    Simulation *sim = des->sim;
+    DroneFsm *fsm = &des->fsm;
+    int capacity = sim->num_drones + pq_size(&sim->task_queue);
+    Task **tasks = (Task **)malloc(sizeof(Task *) * (capacity > 0 ? capacity : 1));
+    int *drone_task = (int *)malloc(sizeof(int) * (sim->num_drones > 0 ? sim->num_drones : 1));
+    int num_tasks = 0;
+
+    for (int i = 0; i < sim->num_drones; i++) {
+        drone_task[i] = -1;
+        if (sim->drones[i].current_task != NULL) {
+            drone_task[i] = num_tasks;
+            tasks[num_tasks++] = sim->drones[i].current_task;
+        }
+    }
+    int first_queued = num_tasks;
+    Task *task;
+    while (num_tasks < capacity && (task = dispatch_steal(sim)) != NULL) {
+        tasks[num_tasks++] = task;
+    }
+    for (int i = first_queued; i < num_tasks; i++) {
+        dispatch_requeue(sim, tasks[i]);
+    }
+
+    CheckpointHeader header = {
+        .seed = sim->seed,
+        .virtual_time = sim->virtual_time,
+        .deterministic = sim->deterministic,
+        .full_charge = sim->full_charge,
+        .num_charging = sim->num_charging_stations,
+        .num_loading = sim->num_loading_bays,
+        .num_locations = lt_count(&sim->locations),
+        .num_chargers = sim->num_chargers,
+        .num_drones = sim->num_drones,
+        .num_tasks = num_tasks,
+        .num_queued = num_tasks - first_queued,
+        .num_events = des->queue.size,
+        .has_workload = sim->workload != NULL
+    };
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    strncpy(header.policy, sim->policy->name, CHECKPOINT_POLICY_LEN - 1);
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+
+    for (int i = 0; ok && i < header.num_locations; i++) {
+        const char *name = lt_name(&sim->locations, i);
+        ScenarioFileLocation loc = { .name_len = (uint32_t)strlen(name) };
+        loc.placed = lt_position(&sim->locations, i, &loc.position);
+        ok = fwrite(&loc, sizeof(loc), 1, out) == 1 && fwrite(name, 1, loc.name_len, out) == loc.name_len;
+    }
+    if (sim->num_chargers > 0) {
+        ok = ok && fwrite(sim->chargers, sizeof(Point), sim->num_chargers, out) == (size_t)sim->num_chargers;
+    }
+
+    for (int i = 0; ok && i < num_tasks; i++) {
+        const Task *t = tasks[i];
+        CheckpointTask rec = {
+            .task_id = t->task_id,
+            .assigned_drone = t->assigned_drone,
+            .source = t->source,
+            .destination = t->destination,
+            .estimated_time = t->estimated_time,
+            .start_time = t->start_time,
+            .end_time = t->end_time,
+            .priority = t->priority,
+            .state = t->state,
+            .located = t->located,
+            .created_at = t->created_at,
+            .enqueued_at = t->enqueued_at,
+            .assigned_at = t->assigned_at
+        };
+        ok = fwrite(&rec, sizeof(rec), 1, out) == 1;
+    }
+
+    for (int i = 0; ok && i < sim->num_drones; i++) {
+        const Drone *drone = &sim->drones[i];
+        const FsmDroneState *ds = &fsm->drones[i];
+        CheckpointDrone rec = {
+            .state = drone->state,
+            .battery = drone->battery_level,
+            .speed = drone->speed,
+            .task = drone_task[i],
+            .active = drone->active,
+            .tasks_completed = drone->tasks_completed,
+            .preempted_count = drone->preempted_count,
+            .generation = ds->generation,
+            .position = drone->position,
+            .wait_start = ds->wait_start,
+            .phase_start = ds->phase_start,
+            .phase_battery = ds->phase_battery,
+            .phase_ticks = ds->phase_ticks
+        };
+        ok = fwrite(&rec, sizeof(rec), 1, out) == 1;
+    }
+
+    CheckpointState state = {
+        .total_tasks = sim->stats.total_tasks,
+        .completed_tasks = sim->stats.completed_tasks,
+        .total_preemptions = sim->stats.total_preemptions,
+        .charging_station_uses = sim->stats.charging_station_uses,
+        .loading_bay_uses = sim->stats.loading_bay_uses,
+        .num_on_charger = fsm->num_on_charger,
+        .backlog = task_index(tasks + first_queued, num_tasks - first_queued, fsm->backlog),
+        .scheduler_pending = des->scheduler_pending,
+        .total_delivery_time = sim->stats.total_delivery_time,
+        .last_assignment = des->last_assignment,
+        .events_processed = des->events_processed,
+        .next_seq = des->queue.next_seq
+    };
+    if (state.backlog >= 0) state.backlog += first_queued;
+    ok = ok && fwrite(&state, sizeof(state), 1, out) == 1 &&
+         write_resource(&fsm->loading_bays, out) &&
+         write_resource(&fsm->charging_stations, out) &&
+         fwrite(fsm->on_charger, sizeof(int), fsm->num_on_charger, out) == (size_t)fsm->num_on_charger &&
+         fwrite(des->queue.events, sizeof(SimEvent), des->queue.size, out) == (size_t)des->queue.size &&
+         write_histograms(&sim->stats.phases, out);
+
+    if (ok && sim->workload != NULL) {
+        CheckpointWorkload wl = {
+            .opts = sim->workload->opts,
+            .rng = sim->workload->rng,
+            .next_arrival = sim->workload->next_arrival,
+            .generated = sim->workload->generated
+        };
+        ok = fwrite(&wl, sizeof(wl), 1, out) == 1;
+    }
+
+    free(tasks);
+    free(drone_task);
+    return ok;
+}
+
+/* Reads and checks the header; the caller builds the simulation from it
+ * (stations, policy, seed) before checkpoint_restore() reads the rest. */
+bool checkpoint_read_header(FILE *in, CheckpointHeader *header) {
+    return fread(header, sizeof(*header), 1, in) == 1 &&
+           memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic)) == 0 &&
+           header->num_locations >= 0 && header->num_chargers >= 0 && header->num_drones >= 0 &&
+           header->num_tasks >= 0 && header->num_queued >= 0 && header->num_queued <= header->num_tasks &&
+           header->num_events >= 0 && header->virtual_time >= 0 &&
+           memchr(header->policy, '\0', sizeof(header->policy)) != NULL;
+}
+
+static bool read_resource(FsmResource *res, int num_drones, FILE *in) {
+    CheckpointResource rec;
+    if (fread(&rec, sizeof(rec), 1, in) != 1 || rec.num_waiters < 0 || rec.available < 0 ||
+        rec.available > rec.total || rec.total != res->total || rec.series.window_us <= 0) {
+        return false;
+    }
+    if (rec.num_waiters > res->capacity) {
+        res->capacity = rec.num_waiters;
+        res->waiters = (FsmWaiter *)realloc(res->waiters, sizeof(FsmWaiter) * res->capacity);
+    }
+    if (fread(res->waiters, sizeof(FsmWaiter), rec.num_waiters, in) != (size_t)rec.num_waiters) return false;
+    for (int i = 0; i < rec.num_waiters; i++) {
+        if (res->waiters[i].drone < 0 || res->waiters[i].drone >= num_drones) return false;
+    }
+    res->size = rec.num_waiters;
+    res->seq = rec.seq;
+    res->available = rec.available;
+    res->busy_us = rec.busy_us;
+    res->start = rec.start;
+    res->last_change = rec.last_change;
+    res->series = rec.series;
+    metrics_gauge_add(&res->gauge->in_use, res->total - res->available);
+    metrics_gauge_add(&res->gauge->queued, res->size);
+    return true;
+}
+
+static bool read_histograms(PhaseTimers *timers, FILE *in) {
+    Histogram *h = (Histogram *)malloc(sizeof(Histogram));
+    bool ok = true;
+    for (int phase = 0; ok && phase < PHASE_COUNT; phase++) {
+        for (int slot = 0; ok && slot < PHASE_PRIORITY_SLOTS; slot++) {
+            CheckpointHistogram rec;
+            ok = fread(&rec, sizeof(rec), 1, in) == 1 && rec.num_buckets <= HIST_BUCKETS;
+            hist_clear(h);
+            for (uint32_t i = 0; ok && i < rec.num_buckets; i++) {
+                CheckpointBucket bucket;
+                ok = fread(&bucket, sizeof(bucket), 1, in) == 1 && bucket.index < HIST_BUCKETS;
+                if (ok) h->counts[bucket.index] = bucket.count;
+            }
+            if (ok && rec.total > 0) {
+                h->total = rec.total;
+                h->sum = rec.sum;
+                h->max = rec.max;
+                phase_timers_add(timers, (Phase)phase, slot, h);
+            }
+        }
+    }
+    free(h);
+    return ok;
+}
+
+/* Gives up on a half-restored engine, leaving a stopped simulation. */
+static bool checkpoint_abort(DesEngine *des, Simulation *sim) {
+    sim->fsm = NULL;
+    sim->simulation_running = false;
+    fsm_destroy(&des->fsm);
+    eq_destroy(&des->queue);
+    return false;
+}
+
+/* Restores the sections after the header into `sim`, which was set up
+ * from the header and has no drones or tasks yet, and resumes `des` on it
+ * at the saved virtual time; des_run_until() carries on from there. A
+ * checkpoint of a run with generated load restarts the generator in
+ * `workload`. On failure `sim` is left stopped and only needs
+ * destroy_simulation() and free_simulation(). */
+bool checkpoint_restore(DesEngine *des, Simulation *sim, Workload *workload, FILE *in,
+                        const CheckpointHeader *header, int duration) {
+    for (int i = 0; i < header->num_locations; i++) {
+        ScenarioFileLocation loc;
+        char name[MAX_LOCATION_LEN];
+        if (fread(&loc, sizeof(loc), 1, in) != 1 || loc.name_len >= MAX_LOCATION_LEN ||
+            fread(name, 1, loc.name_len, in) != loc.name_len) {
+            return false;
+        }
+        LocationId id = lt_intern(&sim->locations, name, loc.name_len);
+        if (id != (LocationId)i) return false;
+        if (loc.placed) lt_place(&sim->locations, id, loc.position);
+    }
+    for (int i = 0; i < header->num_chargers; i++) {
+        Point position;
+        if (fread(&position, sizeof(position), 1, in) != 1) return false;
+        add_charger(sim, position);
+    }
+
+    Task **tasks = (Task **)malloc(sizeof(Task *) * (header->num_tasks > 0 ? header->num_tasks : 1));
+    CheckpointDrone *drones = (CheckpointDrone *)malloc(sizeof(CheckpointDrone) *
+                                                       (header->num_drones > 0 ? header->num_drones : 1));
+    SimEvent *events = (SimEvent *)malloc(sizeof(SimEvent) * (header->num_events > 0 ? header->num_events : 1));
+    bool ok = true;
+
+    for (int i = 0; ok && i < header->num_tasks; i++) {
+        CheckpointTask rec;
+        ok = fread(&rec, sizeof(rec), 1, in) == 1 &&
+             rec.source < (uint32_t)header->num_locations && rec.destination < (uint32_t)header->num_locations &&
+             (tasks[i] = task_pool_alloc(&sim->task_pool)) != NULL;
+        if (!ok) break;
+        Task *task = tasks[i];
+        task->task_id = rec.task_id;
+        task->assigned_drone = rec.assigned_drone;
+        task->source = rec.source;
+        task->destination = rec.destination;
+        task->estimated_time = rec.estimated_time;
+        task->start_time = rec.start_time;
+        task->end_time = rec.end_time;
+        task->priority = rec.priority;
+        task->state = rec.state;
+        task->located = rec.located;
+        task->created_at = rec.created_at;
+        task->enqueued_at = rec.enqueued_at;
+        task->assigned_at = rec.assigned_at;
+    }
+    ok = ok && fread(drones, sizeof(CheckpointDrone), header->num_drones, in) == (size_t)header->num_drones;
+
+    int in_flight = header->num_tasks - header->num_queued;
+    for (int i = 0; ok && i < header->num_drones; i++) {
+        ok = drones[i].state >= DRONE_IDLE && drones[i].state <= DRONE_PREEMPTED &&
+             drones[i].task >= -1 && drones[i].task < in_flight && drones[i].speed > 0;
+    }
+    CheckpointState state;
+    ok = ok && fread(&state, sizeof(state), 1, in) == 1 &&
+         state.num_on_charger >= 0 && state.num_on_charger <= header->num_charging &&
+         state.backlog >= -1 && state.backlog < header->num_tasks;
+    if (!ok) {
+        free(tasks);
+        free(drones);
+        free(events);
+        return false;
+    }
+
+    if (header->num_drones > sim->drone_capacity) {
+        sim->drones = (Drone *)realloc(sim->drones, sizeof(Drone) * header->num_drones);
+        sim->drone_capacity = header->num_drones;
+    }
+    for (int i = 0; i < header->num_drones; i++) {
+        Drone *drone = &sim->drones[i];
+        drone->drone_id = i + 1;
+        drone->state = (DroneState)drones[i].state;
+        metrics_gauge_add(&sim->metrics.drones[drone->state], 1);
+        drone->battery_level = drones[i].battery;
+        drone->speed = drones[i].speed;
+        drone->current_task = drones[i].task >= 0 ? tasks[drones[i].task] : NULL;
+        drone->active = drones[i].active;
+        drone->tasks_completed = drones[i].tasks_completed;
+        drone->preempted_count = drones[i].preempted_count;
+        drone->position = drones[i].position;
+    }
+    sim->num_drones = header->num_drones;
+    sim->stats.total_tasks = state.total_tasks;
+    sim->stats.completed_tasks = state.completed_tasks;
+    sim->stats.total_preemptions = state.total_preemptions;
+    sim->stats.charging_station_uses = state.charging_station_uses;
+    sim->stats.loading_bay_uses = state.loading_bay_uses;
+    sim->stats.total_delivery_time = state.total_delivery_time;
+    sim->virtual_time = header->virtual_time;
+
+    des_resume(des, sim, duration);
+    DroneFsm *fsm = &des->fsm;
+    for (int i = 0; i < header->num_drones; i++) {
+        FsmDroneState *ds = &fsm->drones[i];
+        ds->generation = drones[i].generation;
+        ds->wait_start = drones[i].wait_start;
+        ds->phase_start = drones[i].phase_start;
+        ds->phase_battery = drones[i].phase_battery;
+        ds->phase_ticks = drones[i].phase_ticks;
+    }
+    fsm->backlog = state.backlog >= 0 ? tasks[state.backlog] : NULL;
+    fsm->num_on_charger = state.num_on_charger;
+    des->scheduler_pending = state.scheduler_pending;
+    des->last_assignment = state.last_assignment;
+    des->events_processed = state.events_processed;
+
+    ok = read_resource(&fsm->loading_bays, header->num_drones, in) &&
+         read_resource(&fsm->charging_stations, header->num_drones, in) &&
+         fread(fsm->on_charger, sizeof(int), state.num_on_charger, in) == (size_t)state.num_on_charger &&
+         fread(events, sizeof(SimEvent), header->num_events, in) == (size_t)header->num_events;
+    for (int i = 0; ok && i < state.num_on_charger; i++) {
+        ok = fsm->on_charger[i] >= 0 && fsm->on_charger[i] < header->num_drones;
+    }
+    for (int i = 0; ok && i < header->num_events; i++) {
+        ok = events[i].drone >= -1 && events[i].drone < header->num_drones;
+    }
+    ok = ok && read_histograms(&sim->stats.phases, in);
+
+    CheckpointWorkload wl;
+    if (ok && header->has_workload) {
+        ok = fread(&wl, sizeof(wl), 1, in) == 1 && wl.opts.warehouses > 0 && wl.opts.customers > 0;
+    }
+    if (!ok) {
+        free(tasks);
+        free(drones);
+        free(events);
+        return checkpoint_abort(des, sim);
+    }
+
+    eq_restore(&des->queue, events, header->num_events, state.next_seq);
+    for (int i = in_flight; i < header->num_tasks; i++) {
+        dispatch_requeue(sim, tasks[i]);
+    }
+    for (int i = 0; i < sim->num_drones; i++) {
+        fleet_update_locked(sim, i);
+    }
+    if (header->has_workload) {
+        workload_init(workload, sim, &wl.opts);
+        workload->rng = wl.rng;
+        workload->next_arrival = wl.next_arrival;
+        workload->generated = wl.generated;
+        sim->workload = workload;
+    }
+
+    free(tasks);
+    free(drones);
+    free(events);
+    return true;
+}
@@ -0,0 +1,129 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "des_engine.h"
+#include "workload.h"
+
+#define CHECKPOINT_MAGIC "DRNCKP1"
+#define CHECKPOINT_POLICY_LEN 16
+
+/* A checkpoint file is this header followed by the sections listed at
+ * checkpoint_write(). It holds the discrete-event engine's whole state at
+ * one virtual instant, so a run restored from it carries on exactly as the
+ * original would have. Fields are in host byte order, as in traces. */
+typedef struct {
+    char magic[8];
+    uint64_t seed;
+    int64_t virtual_time;
+    int32_t deterministic;
+    int32_t full_charge;
+    int32_t num_charging;
+    int32_t num_loading;
+    int32_t num_locations;
+    int32_t num_chargers;
+    int32_t num_drones;
+    int32_t num_tasks;
+    int32_t num_queued;
+    int32_t num_events;
+    int32_t has_workload;
+    int32_t reserved;
+    char policy[CHECKPOINT_POLICY_LEN];
+} CheckpointHeader;
+
+/* A live task. Tasks that are done are only counted in the statistics, so
+ * the file grows with the backlog, not with the length of the run. */
+typedef struct {
+    int32_t task_id;
+    int32_t assigned_drone;
+    uint32_t source;
+    uint32_t destination;
+    int32_t estimated_time;
+    int32_t start_time;
+    int32_t end_time;
+    uint8_t priority;
+    uint8_t state;
+    uint8_t located;
+    uint8_t reserved;
+    int64_t created_at;
+    int64_t enqueued_at;
+    int64_t assigned_at;
+} CheckpointTask;
+
+/* A drone and its state-machine phase; `task` indexes the task section. */
+typedef struct {
+    int32_t state;
+    int32_t battery;
+    int32_t speed;
+    int32_t task;
+    int32_t active;
+    int32_t tasks_completed;
+    int32_t preempted_count;
+    uint32_t generation;
+    Point position;
+    int64_t wait_start;
+    int64_t phase_start;
+    int32_t phase_battery;
+    int32_t phase_ticks;
+} CheckpointDrone;
+
+/* A station pool; its waiters follow as FsmWaiter records in heap order. */
+typedef struct {
+    int32_t available;
+    int32_t total;
+    int32_t num_waiters;
+    int32_t reserved;
+    uint64_t seq;
+    int64_t busy_us;
+    int64_t start;
+    int64_t last_change;
+    UtilizationSeries series;
+} CheckpointResource;
+
+/* Statistics counters and the engine's own bookkeeping. `backlog` indexes
+ * the task section (-1 for none). */
+typedef struct {
+    int32_t total_tasks;
+    int32_t completed_tasks;
+    int32_t total_preemptions;
+    int32_t charging_station_uses;
+    int32_t loading_bay_uses;
+    int32_t num_on_charger;
+    int32_t backlog;
+    int32_t scheduler_pending;
+    double total_delivery_time;
+    int64_t last_assignment;
+    uint64_t events_processed;
+    uint64_t next_seq;
+} CheckpointState;
+
+/* One phase histogram, stored as its non-empty buckets. */
+typedef struct {
+    uint32_t num_buckets;
+    uint32_t reserved;
+    uint64_t total;
+    int64_t sum;
+    int64_t max;
+} CheckpointHistogram;
+
+typedef struct {
+    uint32_t index;
+    uint32_t reserved;
+    uint64_t count;
+} CheckpointBucket;
+
+typedef struct {
+    WorkloadOptions opts;
+    uint64_t rng;
+    double next_arrival;
+    uint64_t generated;
+} CheckpointWorkload;
+
+bool checkpoint_write(DesEngine *des, FILE *out);
+bool checkpoint_read_header(FILE *in, CheckpointHeader *header);
+bool checkpoint_restore(DesEngine *des, Simulation *sim, Workload *workload, FILE *in,
+                        const CheckpointHeader *header, int duration);
+
+#endif
@@ -0,0 +1,158 @@
+#include "des_engine.h"
+#include "trace.h"
+#include "workload.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void des_schedule(void *ctx, int drone, SimEventType type, unsigned int generation, long long delay_us) {
+    DesEngine *des = (DesEngine *)ctx;
+    eq_push(&des->queue, des->sim->virtual_time + delay_us / SIM_SECOND_US, type, drone, generation);
+}
+
+static void des_wake_scheduler(void *ctx) {
+    DesEngine *des = (DesEngine *)ctx;
+    if (des->scheduler_pending) return;
+
+    long long now = des->sim->virtual_time;
+    long long when = (des->last_assignment == now) ? now + 1 : now;
+    eq_push(&des->queue, when, EV_SCHEDULER_TICK, -1, 0);
+    des->scheduler_pending = true;
+}
+
+/* The dispatcher hands its matches to the state machine, which queues the
+ * assignment events; all that is left here is pacing the next pass. */
+static void des_on_scheduler_tick(DesEngine *des) {
+    Simulation *sim = des->sim;
+    des->scheduler_pending = false;
+
+    int count = dispatch_pending_tasks(sim);
+    if (count == 0) return;
+
+    des->last_assignment = sim->virtual_time;
+    if (!pq_is_empty(&sim->task_queue)) {
+        des_wake_scheduler(des);
+    }
+}
+
+static void des_schedule_arrival(DesEngine *des) {
+    eq_push(&des->queue, (long long)workload_next_arrival(des->sim->workload), EV_TASK_ARRIVAL, -1, 0);
+}
+
+/* The virtual clock moves in whole seconds, so one event releases every
+ * arrival due before the next second. */
+static void des_on_arrival(DesEngine *des) {
+    Simulation *sim = des->sim;
+    if (workload_advance(sim->workload, sim->virtual_time + 1) > 0) {
+        des_wake_scheduler(des);
+    }
+    des_schedule_arrival(des);
+}
+
+static void des_attach(DesEngine *des, Simulation *sim) {
+    des->sim = sim;
+    des->scheduler_pending = false;
+    des->last_assignment = -1;
+    des->events_processed = 0;
+    eq_init(&des->queue);
+    if (sim->deterministic) eq_seed(&des->queue, sim->seed);
+
+    sim->engine = ENGINE_DES;
+    sim->simulation_running = true;
+
+    FsmHooks hooks = { des, des_schedule, des_wake_scheduler };
+    fsm_init(&des->fsm, sim, hooks);
+    sim->fsm = &des->fsm;
+    clock_gettime(CLOCK_MONOTONIC, &des->wall_start);
+
+    log_event(sim, "\n" ANSI_COLOR_MAGENTA "════════════ STARTING SIMULATION ════════════" ANSI_COLOR_RESET);
+}
+
+/* Sets up the engine and queues the first events; nothing runs until
+ * des_run_until(). */
+void des_start(DesEngine *des, Simulation *sim, int duration) {
+    sim->virtual_time = 0;
+    des_attach(des, sim);
+    log_event(sim, ANSI_COLOR_MAGENTA "[Engine] Discrete-event mode: %d drones, %d virtual seconds" ANSI_COLOR_RESET,
+             sim->num_drones, duration);
+
+    fsm_start(&des->fsm);
+    des_wake_scheduler(des);
+    if (sim->workload != NULL) des_schedule_arrival(des);
+}
+
+/* Sets up the engine around a simulation whose drones, tasks and clock
+ * were restored from a checkpoint. The event queue and the state machine
+ * come back empty for the caller to refill (see checkpoint.c). */
+void des_resume(DesEngine *des, Simulation *sim, int duration) {
+    des_attach(des, sim);
+    log_event(sim, ANSI_COLOR_MAGENTA "[Engine] Discrete-event mode: %d drones, resumed at %lld of %d virtual seconds"
+              ANSI_COLOR_RESET, sim->num_drones, sim->virtual_time, duration);
+}
+
+/* Processes every event due before `until` and leaves the clock there, so
+ * a run can be advanced in slices with outside work between them. */
+void des_run_until(DesEngine *des, long long until) {
+    Simulation *sim = des->sim;
+    const SimEvent *next;
+
+    while ((next = eq_peek(&des->queue)) != NULL && next->time < until) {
+        SimEvent ev;
+        eq_pop(&des->queue, &ev);
+        if (ev.drone >= 0 && !fsm_is_current(&des->fsm, ev.drone, ev.generation)) continue;
+
+        sim->virtual_time = ev.time;
+        des->events_processed++;
+        if (sim->trace != NULL) trace_event(sim->trace, &ev);
+
+        if (ev.type == EV_SCHEDULER_TICK) {
+            des_on_scheduler_tick(des);
+        } else if (ev.type == EV_TASK_ARRIVAL) {
+            des_on_arrival(des);
+        } else {
+            fsm_handle(&des->fsm, ev.drone, ev.type);
+        }
+    }
+    sim->virtual_time = until;
+}
+
+/* Tasks were queued from outside the event loop; schedules a dispatch pass
+ * at the current time. */
+void des_notify(DesEngine *des) {
+    des_wake_scheduler(des);
+}
+
+/* Ends the run at `duration`: settles the drones, reports and releases the
+ * engine. The simulation's statistics stay readable until it is freed. */
+void des_finish(DesEngine *des, int duration) {
+    Simulation *sim = des->sim;
+
+    sim->virtual_time = duration;
+    fsm_settle(&des->fsm);
+    sim->simulation_running = false;
+
+    struct timespec wall_end;
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+    double wall_ms = (wall_end.tv_sec - des->wall_start.tv_sec) * 1000.0 +
+                     (wall_end.tv_nsec - des->wall_start.tv_nsec) / 1e6;
+
+    log_event(sim, "\n" ANSI_COLOR_YELLOW "════════════ STOPPING SIMULATION ════════════" ANSI_COLOR_RESET);
+    if (sim->deterministic) {
+        log_event(sim, "[Engine] Processed %llu events (seed %llu)", des->events_processed, sim->seed);
+    } else {
+        log_event(sim, "[Engine] Processed %llu events in %.3f ms wall time", des->events_processed, wall_ms);
+    }
+    if (sim->workload != NULL) workload_report(sim->workload, duration);
+
+    sim->fsm = NULL;
+    fsm_destroy(&des->fsm);
+    eq_destroy(&des->queue);
+    destroy_simulation(sim);
+}
+
+void des_run_simulation(Simulation *sim, int duration) {
+    DesEngine des;
+    des_start(&des, sim, duration);
+    des_run_until(&des, duration);
+    des_finish(&des, duration);
+}
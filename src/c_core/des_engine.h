@@ -0,0 +1,25 @@
+#ifndef DES_ENGINE_H
+#define DES_ENGINE_H
+
+#include "drone_scheduler.h"
+#include "drone_fsm.h"
+#include "event_queue.h"
+
+typedef struct {
+    Simulation *sim;
+    EventQueue queue;
+    DroneFsm fsm;
+    bool scheduler_pending;
+    long long last_assignment;
+    unsigned long long events_processed;
+    struct timespec wall_start;
+} DesEngine;
+
+void des_start(DesEngine *des, Simulation *sim, int duration);
+void des_resume(DesEngine *des, Simulation *sim, int duration);
+void des_run_until(DesEngine *des, long long until);
+void des_notify(DesEngine *des);
+void des_finish(DesEngine *des, int duration);
+void des_run_simulation(Simulation *sim, int duration);
+
+#endif
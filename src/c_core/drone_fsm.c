@@ -0,0 +1,545 @@
+#include "drone_fsm.h"
+#include "event_log.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void fsm_resource_init(FsmResource *res, int available, long long now, ResourceGauge *gauge) {
+    res->capacity = 16;
+    res->size = 0;
+    res->seq = 0;
+    res->available = available;
+    res->total = available;
+    res->busy_us = 0;
+    res->start = now;
+    res->last_change = now;
+    memset(&res->series, 0, sizeof(res->series));
+    res->series.window_us = SIM_SECOND_US;
+    res->gauge = gauge;
+    res->waiters = (FsmWaiter *)malloc(sizeof(FsmWaiter) * res->capacity);
+}
+
+static void fsm_resource_destroy(FsmResource *res) {
+    free(res->waiters);
+}
+
+static bool fsm_waiter_before(const FsmWaiter *a, const FsmWaiter *b) {
+    return a->key < b->key || (a->key == b->key && a->seq < b->seq);
+}
+
+/* Queues a drone for the next free unit; smaller keys go first. */
+static void fsm_resource_enqueue(FsmResource *res, int drone, unsigned int generation, long long key) {
+    if (res->size == res->capacity) {
+        res->capacity *= 2;
+        res->waiters = (FsmWaiter *)realloc(res->waiters, sizeof(FsmWaiter) * res->capacity);
+    }
+
+    FsmWaiter waiter = { drone, generation, key, res->seq++ };
+    int i = res->size++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!fsm_waiter_before(&waiter, &res->waiters[parent])) break;
+        res->waiters[i] = res->waiters[parent];
+        i = parent;
+    }
+    res->waiters[i] = waiter;
+    metrics_gauge_add(&res->gauge->queued, 1);
+}
+
+static FsmWaiter fsm_resource_dequeue(FsmResource *res) {
+    FsmWaiter top = res->waiters[0];
+    FsmWaiter last = res->waiters[--res->size];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= res->size) break;
+        if (child + 1 < res->size && fsm_waiter_before(&res->waiters[child + 1], &res->waiters[child])) child++;
+        if (!fsm_waiter_before(&res->waiters[child], &last)) break;
+        res->waiters[i] = res->waiters[child];
+        i = child;
+    }
+    if (res->size > 0) res->waiters[i] = last;
+    metrics_gauge_add(&res->gauge->queued, -1);
+    return top;
+}
+
+/* Doubles the window width, merging pairs, until `span` fits. */
+static void fsm_series_widen(UtilizationSeries *series, long long span) {
+    while ((span - 1) / series->window_us >= UTIL_MAX_WINDOWS) {
+        for (int i = 0; i < UTIL_MAX_WINDOWS / 2; i++) {
+            series->busy_us[i] = series->busy_us[2 * i] + series->busy_us[2 * i + 1];
+        }
+        memset(&series->busy_us[UTIL_MAX_WINDOWS / 2], 0, sizeof(long long) * (UTIL_MAX_WINDOWS / 2));
+        series->window_us *= 2;
+    }
+}
+
+/* Adds `units` in use over [from, to) to the windows that span covers. */
+static void fsm_series_add(UtilizationSeries *series, long long start, long long from, long long to, int units) {
+    if (units == 0 || to <= from) return;
+    fsm_series_widen(series, to - start);
+    while (from < to) {
+        int w = (int)((from - start) / series->window_us);
+        long long window_end = start + (w + 1) * series->window_us;
+        long long until = to < window_end ? to : window_end;
+        series->busy_us[w] += units * (until - from);
+        from = until;
+    }
+}
+
+/* Integrates units-in-use over time up to now; called before every change
+ * to `available`. */
+static void fsm_resource_account(DroneFsm *fsm, FsmResource *res) {
+    long long now = sim_clock_us(fsm->sim);
+    int units = res->total - res->available;
+    res->busy_us += (long long)units * (now - res->last_change);
+    fsm_series_add(&res->series, res->start, res->last_change, now, units);
+    res->last_change = now;
+}
+
+static bool fsm_resource_try_acquire(DroneFsm *fsm, FsmResource *res) {
+    if (res->available == 0) return false;
+    fsm_resource_account(fsm, res);
+    res->available--;
+    metrics_gauge_add(&res->gauge->in_use, 1);
+    return true;
+}
+
+/* Hands the released unit to the first waiter that is still current, or
+ * returns it to the pool. */
+static int fsm_resource_release(DroneFsm *fsm, FsmResource *res) {
+    while (res->size > 0) {
+        FsmWaiter waiter = fsm_resource_dequeue(res);
+        if (fsm->drones[waiter.drone].generation == waiter.generation) {
+            return waiter.drone;
+        }
+    }
+    fsm_resource_account(fsm, res);
+    res->available++;
+    metrics_gauge_add(&res->gauge->in_use, -1);
+    return -1;
+}
+
+static void fsm_reserve(DroneFsm *fsm, int num_drones) {
+    if (num_drones <= fsm->capacity) return;
+
+    int new_capacity = fsm->capacity > 0 ? fsm->capacity : 16;
+    while (new_capacity < num_drones) new_capacity *= 2;
+    fsm->drones = (FsmDroneState *)realloc(fsm->drones, sizeof(FsmDroneState) * new_capacity);
+    memset(&fsm->drones[fsm->capacity], 0, sizeof(FsmDroneState) * (new_capacity - fsm->capacity));
+    fsm->capacity = new_capacity;
+}
+
+void fsm_init(DroneFsm *fsm, Simulation *sim, FsmHooks hooks) {
+    fsm->sim = sim;
+    fsm->hooks = hooks;
+    fsm->drones = NULL;
+    fsm->capacity = 0;
+    fsm_resource_init(&fsm->loading_bays, sim->num_loading_bays, sim_clock_us(sim), &sim->metrics.loading_bays);
+    fsm_resource_init(&fsm->charging_stations, sim->num_charging_stations, sim_clock_us(sim),
+                      &sim->metrics.charging_stations);
+    fsm->backlog = NULL;
+    fsm->on_charger = (int *)malloc(sizeof(int) * (sim->num_charging_stations > 0 ? sim->num_charging_stations : 1));
+    fsm->num_on_charger = 0;
+    fsm_reserve(fsm, sim->num_drones);
+}
+
+void fsm_destroy(DroneFsm *fsm) {
+    fsm_resource_destroy(&fsm->loading_bays);
+    fsm_resource_destroy(&fsm->charging_stations);
+    free(fsm->on_charger);
+    fsm->on_charger = NULL;
+    free(fsm->drones);
+    fsm->drones = NULL;
+    fsm->capacity = 0;
+}
+
+bool fsm_is_current(const DroneFsm *fsm, int drone, unsigned int generation) {
+    return drone >= 0 && drone < fsm->capacity && fsm->drones[drone].generation == generation;
+}
+
+static void fsm_arm(DroneFsm *fsm, int idx, SimEventType type, int ticks) {
+    FsmDroneState *ds = &fsm->drones[idx];
+    ds->phase_start = sim_clock_us(fsm->sim);
+    ds->phase_battery = fsm->sim->drones[idx].battery_level;
+    ds->phase_ticks = ticks;
+    fsm->hooks.schedule(fsm->hooks.ctx, idx, type, ds->generation, ticks * SIM_SECOND_US);
+}
+
+/* Whole simulated seconds spent in the current phase, capped at the number
+ * the phase was armed for. */
+static int fsm_elapsed_ticks(DroneFsm *fsm, int idx) {
+    FsmDroneState *ds = &fsm->drones[idx];
+    long long elapsed = (sim_clock_us(fsm->sim) - ds->phase_start) / SIM_SECOND_US;
+    if (elapsed < 0) elapsed = 0;
+    if (elapsed > ds->phase_ticks) elapsed = ds->phase_ticks;
+    return (int)elapsed;
+}
+
+/* Seconds from load-complete to drop-off. A located task is flown from the
+ * drone's position via the pickup to the drop-off (the leg to the pickup is
+ * folded into the delivery phase); others use the configured estimate. */
+static int fsm_flight_time(const Simulation *sim, const Drone *drone, const Task *task) {
+    int seconds;
+    if (task->located) {
+        Point pickup, dropoff;
+        lt_position(&sim->locations, task->source, &pickup);
+        lt_position(&sim->locations, task->destination, &dropoff);
+        double metres = point_distance(drone->position, pickup) + point_distance(pickup, dropoff);
+        seconds = (int)ceil(metres / (FLIGHT_METRES_PER_SECOND * drone->speed));
+    } else {
+        seconds = task->estimated_time / drone->speed;
+    }
+    return seconds < 1 ? 1 : seconds;
+}
+
+static void fsm_start_loading(DroneFsm *fsm, int idx) {
+    Simulation *sim = fsm->sim;
+    Drone *drone = &sim->drones[idx];
+    Task *task = drone->current_task;
+
+    phase_record(&sim->stats.phases, PHASE_BAY_WAIT, task->priority, sim_clock_us(sim) - fsm->drones[idx].wait_start);
+    pthread_mutex_lock(&sim->stats.mutex);
+    sim->stats.loading_bay_uses++;
+    pthread_mutex_unlock(&sim->stats.mutex);
+
+    set_drone_state(sim, drone, DRONE_LOADING);
+    log_record(sim, &(LogRecord){ .type = LOG_LOADING, .drone_id = drone->drone_id, .task_id = task->task_id,
+                                  .priority = task->priority, .ref = task });
+
+    fsm_arm(fsm, idx, EV_LOAD_COMPLETE, 1);
+}
+
+/* Drones charge at the nearest configured station; the approach flight is
+ * not timed. Without CHARGER positions they stay where they are. */
+static void fsm_move_to_charger(Simulation *sim, Drone *drone) {
+    int best = -1;
+    double best_dist = 0;
+    for (int i = 0; i < sim->num_chargers; i++) {
+        double d = point_distance(drone->position, sim->chargers[i]);
+        if (best < 0 || d < best_dist) {
+            best = i;
+            best_dist = d;
+        }
+    }
+    if (best >= 0) drone->position = sim->chargers[best];
+}
+
+/* Battery a drone needs at the start of `task` to finish it above the
+ * low-battery cut-off. */
+static int fsm_level_for(const Simulation *sim, const Drone *drone, const Task *task) {
+    int level = BATTERY_LOW_THRESHOLD + fsm_flight_time(sim, drone, task) * BATTERY_DRAIN_RATE;
+    return level > 100 ? 100 : level;
+}
+
+/* Charging tops a drone up to what the backlog task needs while work is
+ * waiting, and fills it otherwise (or always, with `full_charge`). */
+static int fsm_charge_target(const DroneFsm *fsm, const Drone *drone) {
+    if (fsm->sim->full_charge || fsm->backlog == NULL) return 100;
+    return fsm_level_for(fsm->sim, drone, fsm->backlog);
+}
+
+static int fsm_charge_ticks(int battery, int target) {
+    int ticks = (target - battery + BATTERY_CHARGE_RATE - 1) / BATTERY_CHARGE_RATE;
+    return ticks < 0 ? 0 : ticks;
+}
+
+static void fsm_start_charging(DroneFsm *fsm, int idx) {
+    Simulation *sim = fsm->sim;
+    Drone *drone = &sim->drones[idx];
+
+    phase_record(&sim->stats.phases, PHASE_CHARGER_WAIT, 0, sim_clock_us(sim) - fsm->drones[idx].wait_start);
+    pthread_mutex_lock(&sim->stats.mutex);
+    sim->stats.charging_station_uses++;
+    pthread_mutex_unlock(&sim->stats.mutex);
+
+    set_drone_state(sim, drone, DRONE_CHARGING);
+    fsm_move_to_charger(sim, drone);
+    log_record(sim, &(LogRecord){ .type = LOG_CHARGE_START, .drone_id = drone->drone_id,
+                                  .battery = drone->battery_level });
+
+    fsm->on_charger[fsm->num_on_charger++] = idx;
+    fsm_arm(fsm, idx, EV_CHARGE_COMPLETE, fsm_charge_ticks(drone->battery_level, fsm_charge_target(fsm, drone)));
+}
+
+/* Waiting drones are served in the order they would be back in service
+ * (request time plus charge to their target), so a short top-up does not
+ * sit behind a full charge; `full_charge` keeps the queue FIFO. */
+static void fsm_request_charging(DroneFsm *fsm, int idx) {
+    Simulation *sim = fsm->sim;
+    Drone *drone = &sim->drones[idx];
+    long long now = sim_clock_us(sim);
+
+    fsm->drones[idx].wait_start = now;
+    log_record(sim, &(LogRecord){ .type = LOG_CHARGE_REQUEST, .drone_id = drone->drone_id });
+    if (fsm_resource_try_acquire(fsm, &fsm->charging_stations)) {
+        fsm_start_charging(fsm, idx);
+    } else {
+        long long key = 0;
+        if (!sim->full_charge) {
+            key = now + fsm_charge_ticks(drone->battery_level, fsm_charge_target(fsm, drone)) * SIM_SECOND_US;
+        }
+        fsm_resource_enqueue(&fsm->charging_stations, idx, fsm->drones[idx].generation, key);
+    }
+}
+
+static void fsm_release_loading_bay(DroneFsm *fsm) {
+    int next = fsm_resource_release(fsm, &fsm->loading_bays);
+    if (next >= 0) fsm_start_loading(fsm, next);
+}
+
+static void fsm_on_assignment(DroneFsm *fsm, int idx) {
+    Simulation *sim = fsm->sim;
+    Drone *drone = &sim->drones[idx];
+    long long now = sim_clock_us(sim);
+
+    phase_record(&sim->stats.phases, PHASE_PICKUP, drone->current_task->priority, now - drone->current_task->assigned_at);
+    fsm->drones[idx].wait_start = now;
+
+    log_record(sim, &(LogRecord){ .type = LOG_WAIT_BAY, .drone_id = drone->drone_id });
+    if (fsm_resource_try_acquire(fsm, &fsm->loading_bays)) {
+        fsm_start_loading(fsm, idx);
+    } else {
+        fsm_resource_enqueue(&fsm->loading_bays, idx, fsm->drones[idx].generation, 0);
+    }
+}
+
+static void fsm_on_load_complete(DroneFsm *fsm, int idx) {
+    Simulation *sim = fsm->sim;
+    Drone *drone = &sim->drones[idx];
+    Task *task = drone->current_task;
+
+    fsm_release_loading_bay(fsm);
+    log_record(sim, &(LogRecord){ .type = LOG_BAY_RELEASED, .drone_id = drone->drone_id });
+
+    set_drone_state(sim, drone, DRONE_DELIVERING);
+    task->state = TASK_IN_PROGRESS;
+    task->start_time = (int)(sim_clock_us(sim) / SIM_SECOND_US);
+
+    /* Battery drains one BATTERY_DRAIN_RATE step per simulated second; rather
+     * than waking every second, jump straight to whichever comes first: the
+     * end of the delivery or the second that crosses the low threshold. */
+    int delivery_time = fsm_flight_time(sim, drone, task);
+    int critical_ticks = (drone->battery_level - BATTERY_LOW_THRESHOLD + BATTERY_DRAIN_RATE - 1) / BATTERY_DRAIN_RATE;
+    if (critical_ticks < 1) critical_ticks = 1;
+    int ticks = (critical_ticks < delivery_time) ? critical_ticks : delivery_time;
+    log_record(sim, &(LogRecord){ .type = LOG_DELIVERY_START, .drone_id = drone->drone_id, .task_id = task->task_id,
+                                  .priority = task->priority, .battery = drone->battery_level,
+                                  .value = ticks, .aux = BATTERY_DRAIN_RATE });
+
+    fsm_arm(fsm, idx, EV_DELIVERY_END, ticks);
+}
+
+static void fsm_on_delivery_end(DroneFsm *fsm, int idx) {
+    Simulation *sim = fsm->sim;
+    Drone *drone = &sim->drones[idx];
+    FsmDroneState *ds = &fsm->drones[idx];
+    Task *task = drone->current_task;
+
+    drone->battery_level = ds->phase_battery - ds->phase_ticks * BATTERY_DRAIN_RATE;
+    if (drone->battery_level <= BATTERY_LOW_THRESHOLD) {
+        log_record(sim, &(LogRecord){ .type = LOG_BATTERY_CRITICAL, .drone_id = drone->drone_id,
+                                      .battery = drone->battery_level });
+    }
+
+    task->state = TASK_COMPLETED;
+    task->end_time = task->start_time + ds->phase_ticks;
+    double elapsed = (double)ds->phase_ticks;
+
+    long long now = sim_clock_us(sim);
+    phase_record(&sim->stats.phases, PHASE_FLIGHT, task->priority, now - ds->phase_start);
+    phase_record(&sim->stats.phases, PHASE_DELIVERY, task->priority, now - task->created_at);
+    pthread_mutex_lock(&sim->stats.mutex);
+    sim->stats.completed_tasks++;
+    sim->stats.total_delivery_time += elapsed;
+    pthread_mutex_unlock(&sim->stats.mutex);
+    metrics_count(&sim->metrics.tasks_completed, 1);
+
+    log_record(sim, &(LogRecord){ .type = LOG_TASK_COMPLETED, .drone_id = drone->drone_id, .task_id = task->task_id,
+                                  .priority = task->priority, .battery = drone->battery_level,
+                                  .value = ds->phase_ticks });
+
+    if (task->located) lt_position(&sim->locations, task->destination, &drone->position);
+    drone->tasks_completed++;
+    drone->current_task = NULL;
+    set_drone_state(sim, drone, DRONE_IDLE);
+    fleet_update_locked(sim, idx);
+
+    if (drone->battery_level <= BATTERY_LOW_THRESHOLD) {
+        fsm_request_charging(fsm, idx);
+    } else {
+        fsm->hooks.wake_scheduler(fsm->hooks.ctx);
+    }
+}
+
+static void fsm_on_charge_complete(DroneFsm *fsm, int idx) {
+    Simulation *sim = fsm->sim;
+    Drone *drone = &sim->drones[idx];
+    FsmDroneState *ds = &fsm->drones[idx];
+
+    drone->battery_level = ds->phase_battery + ds->phase_ticks * BATTERY_CHARGE_RATE;
+    if (drone->battery_level > 100) drone->battery_level = 100;
+    log_record(sim, &(LogRecord){ .type = LOG_CHARGE_END, .drone_id = drone->drone_id,
+                                  .battery = drone->battery_level });
+
+    for (int i = 0; i < fsm->num_on_charger; i++) {
+        if (fsm->on_charger[i] == idx) {
+            fsm->on_charger[i] = fsm->on_charger[--fsm->num_on_charger];
+            break;
+        }
+    }
+
+    int next = fsm_resource_release(fsm, &fsm->charging_stations);
+    if (next >= 0) fsm_start_charging(fsm, next);
+
+    set_drone_state(sim, drone, DRONE_IDLE);
+    fleet_update_locked(sim, idx);
+    fsm->hooks.wake_scheduler(fsm->hooks.ctx);
+}
+
+void fsm_handle(DroneFsm *fsm, int idx, SimEventType type) {
+    Drone *drone = &fsm->sim->drones[idx];
+
+    switch (type) {
+        case EV_ASSIGNMENT:
+            if (drone->state == DRONE_IDLE && drone->current_task != NULL) fsm_on_assignment(fsm, idx);
+            break;
+        case EV_LOAD_COMPLETE:
+            if (drone->state == DRONE_LOADING) fsm_on_load_complete(fsm, idx);
+            break;
+        case EV_DELIVERY_END:
+            if (drone->state == DRONE_DELIVERING) fsm_on_delivery_end(fsm, idx);
+            break;
+        case EV_CHARGE_COMPLETE:
+            if (drone->state == DRONE_CHARGING) fsm_on_charge_complete(fsm, idx);
+            break;
+        case EV_SCHEDULER_TICK:
+        case EV_TASK_ARRIVAL:
+            break;
+    }
+}
+
+/* Sends drones that start at or below the threshold to charge and files the
+ * rest in the scheduler's indexes. */
+void fsm_start(DroneFsm *fsm) {
+    Simulation *sim = fsm->sim;
+    fsm_reserve(fsm, sim->num_drones);
+
+    for (int i = 0; i < sim->num_drones; i++) {
+        fleet_update_locked(sim, i);
+        if (sim->drones[i].battery_level <= BATTERY_LOW_THRESHOLD) {
+            fsm_request_charging(fsm, i);
+        }
+    }
+}
+
+/* Brings a drone added mid-run into the state machine the way fsm_start()
+ * does for the initial fleet. Caller holds fleet_mutex. */
+void fsm_add_drone(DroneFsm *fsm, int idx) {
+    Simulation *sim = fsm->sim;
+    fsm_reserve(fsm, idx + 1);
+    fleet_update_locked(sim, idx);
+    if (sim->drones[idx].battery_level <= BATTERY_LOW_THRESHOLD) {
+        fsm_request_charging(fsm, idx);
+    }
+}
+
+/* Turns the scheduler's matches into drone activity. The dispatcher has
+ * already requeued any victim's task; this undoes the engine-side half of
+ * whatever phase the victim was in and kicks every matched drone. */
+void fsm_apply_dispatch(DroneFsm *fsm, int count) {
+    Simulation *sim = fsm->sim;
+
+    for (int i = 0; i < count; i++) {
+        DispatchRecord *rec = &sim->dispatch_records[i];
+        int idx = rec->drone;
+        FsmDroneState *ds = &fsm->drones[idx];
+
+        if (rec->preempted != NULL) {
+            if (rec->preempted_state == DRONE_DELIVERING) {
+                sim->drones[idx].battery_level = ds->phase_battery - fsm_elapsed_ticks(fsm, idx) * BATTERY_DRAIN_RATE;
+                fleet_update_locked(sim, idx);
+            } else if (rec->preempted_state == DRONE_LOADING) {
+                fsm_release_loading_bay(fsm);
+            }
+            /* Invalidates the drone's pending timer and any wait-queue entry. */
+            ds->generation++;
+        }
+        fsm->hooks.schedule(fsm->hooks.ctx, idx, EV_ASSIGNMENT, ds->generation, 0);
+    }
+}
+
+/* Records the task the dispatcher is stuck on (NULL once the queue has
+ * drained) with `queued` tasks waiting. While work waits, up to `queued`
+ * charging drones that already hold enough for that task are released
+ * early instead of finishing their charge. */
+void fsm_set_backlog(DroneFsm *fsm, const Task *head, int queued) {
+    Simulation *sim = fsm->sim;
+
+    fsm->backlog = head;
+    if (head == NULL || sim->full_charge) return;
+    for (int i = 0; i < fsm->num_on_charger && queued > 0; i++) {
+        int idx = fsm->on_charger[i];
+        Drone *drone = &sim->drones[idx];
+        FsmDroneState *ds = &fsm->drones[idx];
+        int elapsed = fsm_elapsed_ticks(fsm, idx);
+
+        if (elapsed >= ds->phase_ticks) continue;
+        int level = ds->phase_battery + elapsed * BATTERY_CHARGE_RATE;
+        if (level < fsm_level_for(sim, drone, head)) continue;
+        drone->battery_level = level;
+        ds->generation++;
+        fsm_arm(fsm, idx, EV_CHARGE_COMPLETE, 0);
+        queued--;
+    }
+}
+
+/* The battery level the per-second model shows for a drone now, without
+ * settling it; for callers that inspect a run between slices. */
+int fsm_battery(DroneFsm *fsm, int idx) {
+    const Drone *drone = &fsm->sim->drones[idx];
+    const FsmDroneState *ds = &fsm->drones[idx];
+    if (drone->state == DRONE_DELIVERING) {
+        int level = ds->phase_battery - fsm_elapsed_ticks(fsm, idx) * BATTERY_DRAIN_RATE;
+        return level < 0 ? 0 : level;
+    }
+    if (drone->state == DRONE_CHARGING) {
+        int level = ds->phase_battery + fsm_elapsed_ticks(fsm, idx) * BATTERY_CHARGE_RATE;
+        return level > 100 ? 100 : level;
+    }
+    return drone->battery_level;
+}
+
+/* A pool's busy unit-time up to now, leaving its accounting untouched. */
+long long fsm_busy_us(const DroneFsm *fsm, const FsmResource *res) {
+    long long now = sim_clock_us(fsm->sim);
+    return res->busy_us + (long long)(res->total - res->available) * (now - res->last_change);
+}
+
+/* Brings drones caught mid-phase when the run ends up to the battery level
+ * the per-second model would show, and closes the resource busy time. */
+void fsm_settle(DroneFsm *fsm) {
+    Simulation *sim = fsm->sim;
+    fsm_resource_account(fsm, &fsm->loading_bays);
+    fsm_resource_account(fsm, &fsm->charging_stations);
+    pthread_mutex_lock(&sim->stats.mutex);
+    sim->stats.loading_busy_us = fsm->loading_bays.busy_us;
+    sim->stats.charging_busy_us = fsm->charging_stations.busy_us;
+    sim->stats.span_us = sim_clock_us(sim) - fsm->charging_stations.start;
+    fsm_series_widen(&fsm->charging_stations.series, sim->stats.span_us);
+    sim->stats.charging_series = fsm->charging_stations.series;
+    pthread_mutex_unlock(&sim->stats.mutex);
+
+    for (int i = 0; i < sim->num_drones; i++) {
+        Drone *drone = &sim->drones[i];
+        FsmDroneState *ds = &fsm->drones[i];
+
+        if (drone->state == DRONE_DELIVERING) {
+            drone->battery_level = ds->phase_battery - fsm_elapsed_ticks(fsm, i) * BATTERY_DRAIN_RATE;
+        } else if (drone->state == DRONE_CHARGING) {
+            drone->battery_level = ds->phase_battery + fsm_elapsed_ticks(fsm, i) * BATTERY_CHARGE_RATE;
+            if (drone->battery_level > 100) drone->battery_level = 100;
+        }
+    }
+}
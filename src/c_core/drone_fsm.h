@@ -0,0 +1,90 @@
+#ifndef DRONE_FSM_H
+#define DRONE_FSM_H
+
+#include "drone_scheduler.h"
+#include "event_queue.h"
+
+#define SIM_SECOND_US 1000000LL
+
+typedef struct {
+    int drone;
+    unsigned int generation;
+    long long key;
+    unsigned long long seq;
+} FsmWaiter;
+
+/* A loading bay or charging station pool: free units plus a min-heap of
+ * waiting drones on (key, arrival), so equal keys are served FIFO. Entries
+ * carry the drone's generation so waiters that were preempted while queued
+ * are skipped on hand-off. `busy_us` and `series` integrate the units in
+ * use over simulated time for utilization, and `gauge` mirrors the units
+ * in use and the queue length for the live metrics. */
+typedef struct {
+    FsmWaiter *waiters;
+    int size;
+    int capacity;
+    unsigned long long seq;
+    int available;
+    int total;
+    long long busy_us;
+    long long start;
+    long long last_change;
+    UtilizationSeries series;
+    ResourceGauge *gauge;
+} FsmResource;
+
+/* `wait_start` is when the drone began waiting for a bay or a charger. */
+typedef struct {
+    unsigned int generation;
+    long long wait_start;
+    long long phase_start;
+    int phase_battery;
+    int phase_ticks;
+} FsmDroneState;
+
+/* How the owning engine keeps time: `schedule` arms a one-shot timer that
+ * must come back through fsm_handle() after `delay_us`, and
+ * `wake_scheduler` asks for a dispatch pass. */
+typedef struct {
+    void *ctx;
+    void (*schedule)(void *ctx, int drone, SimEventType type, unsigned int generation, long long delay_us);
+    void (*wake_scheduler)(void *ctx);
+} FsmHooks;
+
+/* Per-drone delivery state machine shared by both engines:
+ *
+ *   IDLE --assignment--> (wait bay) --> LOADING --1s--> DELIVERING
+ *   DELIVERING --done or battery low--> IDLE or (wait charger) --> CHARGING
+ *   CHARGING --target level--> IDLE
+ *
+ * `backlog` is the task the dispatcher last could not place; while there
+ * is one, chargers top drones up to what it needs rather than to 100%.
+ * `on_charger` lists the drones holding a charging station.
+ *
+ * The caller serializes access: the discrete-event engine is single
+ * threaded, the worker pool holds fleet_mutex around every call. */
+typedef struct DroneFsm {
+    Simulation *sim;
+    FsmHooks hooks;
+    FsmResource loading_bays;
+    FsmResource charging_stations;
+    FsmDroneState *drones;
+    int capacity;
+    const Task *backlog;
+    int *on_charger;
+    int num_on_charger;
+} DroneFsm;
+
+void fsm_init(DroneFsm *fsm, Simulation *sim, FsmHooks hooks);
+void fsm_start(DroneFsm *fsm);
+void fsm_add_drone(DroneFsm *fsm, int idx);
+bool fsm_is_current(const DroneFsm *fsm, int drone, unsigned int generation);
+void fsm_handle(DroneFsm *fsm, int drone, SimEventType type);
+void fsm_apply_dispatch(DroneFsm *fsm, int count);
+void fsm_set_backlog(DroneFsm *fsm, const Task *head, int queued);
+int fsm_battery(DroneFsm *fsm, int idx);
+long long fsm_busy_us(const DroneFsm *fsm, const FsmResource *res);
+void fsm_settle(DroneFsm *fsm);
+void fsm_destroy(DroneFsm *fsm);
+
+#endif
@@ -0,0 +1,111 @@
+#include "drone_index.h"
+#include <stdlib.h>
+
+void di_init(DroneIndex *di) {
+    di->heap = NULL;
+    di->pos = NULL;
+    di->key = NULL;
+    di->size = 0;
+    di->capacity = 0;
+}
+
+void di_reserve(DroneIndex *di, int num_drones) {
+    if (num_drones <= di->capacity) return;
+
+    int new_capacity = di->capacity > 0 ? di->capacity : 16;
+    while (new_capacity < num_drones) new_capacity *= 2;
+
+    di->heap = (int *)realloc(di->heap, sizeof(int) * new_capacity);
+    di->pos = (int *)realloc(di->pos, sizeof(int) * new_capacity);
+    di->key = (int *)realloc(di->key, sizeof(int) * new_capacity);
+    for (int i = di->capacity; i < new_capacity; i++) {
+        di->pos[i] = -1;
+    }
+    di->capacity = new_capacity;
+}
+
+static bool di_above(const DroneIndex *di, int a, int b) {
+    if (di->key[a] != di->key[b]) return di->key[a] > di->key[b];
+    return a < b;
+}
+
+static void di_place(DroneIndex *di, int slot, int drone) {
+    di->heap[slot] = drone;
+    di->pos[drone] = slot;
+}
+
+static void di_sift_up(DroneIndex *di, int slot) {
+    int drone = di->heap[slot];
+    while (slot > 0) {
+        int parent = (slot - 1) / 2;
+        if (!di_above(di, drone, di->heap[parent])) break;
+        di_place(di, slot, di->heap[parent]);
+        slot = parent;
+    }
+    di_place(di, slot, drone);
+}
+
+static void di_sift_down(DroneIndex *di, int slot) {
+    int drone = di->heap[slot];
+    while (true) {
+        int child = 2 * slot + 1;
+        if (child >= di->size) break;
+        if (child + 1 < di->size && di_above(di, di->heap[child + 1], di->heap[child])) {
+            child++;
+        }
+        if (!di_above(di, di->heap[child], drone)) break;
+        di_place(di, slot, di->heap[child]);
+        slot = child;
+    }
+    di_place(di, slot, drone);
+}
+
+void di_update(DroneIndex *di, int drone, int key) {
+    di_reserve(di, drone + 1);
+
+    int slot = di->pos[drone];
+    if (slot < 0) {
+        di->key[drone] = key;
+        slot = di->size++;
+        di_place(di, slot, drone);
+        di_sift_up(di, slot);
+        return;
+    }
+
+    int old_key = di->key[drone];
+    di->key[drone] = key;
+    if (key > old_key) {
+        di_sift_up(di, slot);
+    } else if (key < old_key) {
+        di_sift_down(di, slot);
+    }
+}
+
+void di_remove(DroneIndex *di, int drone) {
+    if (!di_contains(di, drone)) return;
+
+    int slot = di->pos[drone];
+    di->pos[drone] = -1;
+    di->size--;
+    if (slot == di->size) return;
+
+    int moved = di->heap[di->size];
+    di_place(di, slot, moved);
+    di_sift_up(di, slot);
+    if (di->pos[moved] == slot) di_sift_down(di, slot);
+}
+
+bool di_contains(const DroneIndex *di, int drone) {
+    return drone >= 0 && drone < di->capacity && di->pos[drone] >= 0;
+}
+
+int di_top(const DroneIndex *di) {
+    return di->size > 0 ? di->heap[0] : -1;
+}
+
+void di_destroy(DroneIndex *di) {
+    free(di->heap);
+    free(di->pos);
+    free(di->key);
+    di_init(di);
+}
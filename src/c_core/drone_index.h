@@ -0,0 +1,25 @@
+#ifndef DRONE_INDEX_H
+#define DRONE_INDEX_H
+
+#include <stdbool.h>
+
+/* Indexed binary max-heap over drone slots. Each member carries an integer
+ * key; the top is the member with the largest key, ties going to the lowest
+ * drone index. A position map makes update and remove O(log N). */
+typedef struct {
+    int *heap;
+    int *pos;
+    int *key;
+    int size;
+    int capacity;
+} DroneIndex;
+
+void di_init(DroneIndex *di);
+void di_reserve(DroneIndex *di, int num_drones);
+void di_update(DroneIndex *di, int drone, int key);
+void di_remove(DroneIndex *di, int drone);
+bool di_contains(const DroneIndex *di, int drone);
+int di_top(const DroneIndex *di);
+void di_destroy(DroneIndex *di);
+
+#endif
@@ -1,240 +1,447 @@
 #include "drone_scheduler.h"
+#include "drone_fsm.h"
+#include "event_log.h"
+#include "workload.h"
+#include "policy.h"
+#include "pool_engine.h"
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
-#include <stdarg.h>
 
-#define ANSI_COLOR_RED     "\x1b[31m"
-#define ANSI_COLOR_GREEN   "\x1b[32m"
-#define ANSI_COLOR_YELLOW  "\x1b[33m"
-#define ANSI_COLOR_BLUE    "\x1b[34m"
-#define ANSI_COLOR_MAGENTA "\x1b[35m"
-#define ANSI_COLOR_CYAN    "\x1b[36m"
-#define ANSI_COLOR_RESET   "\x1b[0m"
+#define task_of(l) ((Task *)((char *)(l) - offsetof(Task, link)))
 
-static Simulation *global_sim = NULL;
+static void lane_push(TaskLane *lane, QueueLink *link) {
+    atomic_store_explicit(&link->next, NULL, memory_order_relaxed);
+    QueueLink *prev = atomic_exchange_explicit(&lane->head, link, memory_order_acq_rel);
+    atomic_store_explicit(&prev->next, link, memory_order_release);
+}
 
-void log_event(Simulation *sim, const char *format, ...) {
-    pthread_mutex_lock(&sim->log_mutex);
-    
-    time_t now = time(NULL);
-    struct tm *t = localtime(&now);
-    printf("[%02d:%02d:%02d] ", t->tm_hour, t->tm_min, t->tm_sec);
-    
-    va_list args;
-    va_start(args, format);
-    vprintf(format, args);
-    va_end(args);
-    
-    printf("\n");
-    fflush(stdout);
-    
-    pthread_mutex_unlock(&sim->log_mutex);
+/* Consumer side. Returns the oldest fully linked entry without removing it,
+ * stepping over the stub if it is at the front. */
+static QueueLink *lane_peek(TaskLane *lane) {
+    QueueLink *tail = lane->tail;
+    if (tail == &lane->stub) {
+        QueueLink *next = atomic_load_explicit(&tail->next, memory_order_acquire);
+        if (next == NULL) return NULL;
+        lane->tail = next;
+        tail = next;
+    }
+    return tail;
+}
+
+/* Consumer side. May return NULL while a producer is between its exchange
+ * and its link; that producer notifies the scheduler once it is done. */
+static QueueLink *lane_pop(TaskLane *lane) {
+    QueueLink *tail = lane_peek(lane);
+    if (tail == NULL) return NULL;
+    
+    QueueLink *next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    if (next == NULL) {
+        if (tail != atomic_load_explicit(&lane->head, memory_order_acquire)) return NULL;
+        lane_push(lane, &lane->stub);
+        next = atomic_load_explicit(&tail->next, memory_order_acquire);
+        if (next == NULL) return NULL;
+    }
+    lane->tail = next;
+    return tail;
+}
+
+static TaskLane *pq_lane(PriorityQueue *pq, int priority) {
+    if (priority < 1) priority = 1;
+    if (priority > PQ_PRIORITY_LEVELS) priority = PQ_PRIORITY_LEVELS;
+    return &pq->lanes[priority - 1];
 }
 
 void pq_init(PriorityQueue *pq) {
-    pq->size = 0;
+    for (int i = 0; i < PQ_PRIORITY_LEVELS; i++) {
+        TaskLane *lane = &pq->lanes[i];
+        atomic_init(&lane->stub.next, NULL);
+        atomic_init(&lane->head, &lane->stub);
+        atomic_init(&lane->size, 0);
+        lane->tail = &lane->stub;
+    }
     pthread_mutex_init(&pq->mutex, NULL);
+    pq->ready = NULL;
+    pq->ready_count = 0;
+    pq->ready_capacity = 0;
+    pq->ready_seq = 0;
 }
 
+/* Lock-free: any number of threads may push concurrently with the consumer.
+ * Tasks of equal priority come out in push order. */
 void pq_push(PriorityQueue *pq, Task *task) {
-    pthread_mutex_lock(&pq->mutex);
-    
-    if (pq->size >= MAX_TASKS) {
-        pthread_mutex_unlock(&pq->mutex);
-        return;
+    TaskLane *lane = pq_lane(pq, task->priority);
+    atomic_fetch_add_explicit(&lane->size, 1, memory_order_relaxed);
+    lane_push(lane, &task->link);
+}
+
+/* Caller holds pq->mutex. */
+static Task *pq_peek_locked(PriorityQueue *pq) {
+    for (int i = 0; i < PQ_PRIORITY_LEVELS; i++) {
+        QueueLink *link = lane_peek(&pq->lanes[i]);
+        if (link != NULL) return task_of(link);
     }
-    
-    int i = pq->size;
-    pq->tasks[i] = task;
-    pq->size++;
-    
-    while (i > 0) {
-        int parent = (i - 1) / 2;
-        if (pq->tasks[i]->priority < pq->tasks[parent]->priority) {
-            Task *temp = pq->tasks[i];
-            pq->tasks[i] = pq->tasks[parent];
-            pq->tasks[parent] = temp;
-            i = parent;
-        } else {
-            break;
-        }
+    return NULL;
+}
+
+/* Caller holds pq->mutex. */
+static Task *pq_pop_locked(PriorityQueue *pq) {
+    for (int i = 0; i < PQ_PRIORITY_LEVELS; i++) {
+        TaskLane *lane = &pq->lanes[i];
+        if (lane_peek(lane) == NULL) continue;
+        QueueLink *link = lane_pop(lane);
+        if (link == NULL) return NULL;
+        atomic_fetch_sub_explicit(&lane->size, 1, memory_order_relaxed);
+        return task_of(link);
     }
-    
-    pthread_mutex_unlock(&pq->mutex);
+    return NULL;
 }
 
 Task *pq_pop(PriorityQueue *pq) {
     pthread_mutex_lock(&pq->mutex);
-    
-    if (pq->size == 0) {
-        pthread_mutex_unlock(&pq->mutex);
-        return NULL;
-    }
-    
-    Task *result = pq->tasks[0];
-    pq->size--;
-    
-    if (pq->size > 0) {
-        pq->tasks[0] = pq->tasks[pq->size];
-        
-        int i = 0;
-        while (true) {
-            int left = 2 * i + 1;
-            int right = 2 * i + 2;
-            int smallest = i;
-            
-            if (left < pq->size && pq->tasks[left]->priority < pq->tasks[smallest]->priority) {
-                smallest = left;
-            }
-            if (right < pq->size && pq->tasks[right]->priority < pq->tasks[smallest]->priority) {
-                smallest = right;
-            }
-            
-            if (smallest != i) {
-                Task *temp = pq->tasks[i];
-                pq->tasks[i] = pq->tasks[smallest];
-                pq->tasks[smallest] = temp;
-                i = smallest;
-            } else {
-                break;
-            }
-        }
-    }
-    
+    Task *result = pq_pop_locked(pq);
     pthread_mutex_unlock(&pq->mutex);
     return result;
 }
 
 Task *pq_peek(PriorityQueue *pq) {
     pthread_mutex_lock(&pq->mutex);
-    Task *result = (pq->size > 0) ? pq->tasks[0] : NULL;
+    Task *result = pq_peek_locked(pq);
     pthread_mutex_unlock(&pq->mutex);
     return result;
 }
 
+int pq_size(PriorityQueue *pq) {
+    int size = 0;
+    for (int i = 0; i < PQ_PRIORITY_LEVELS; i++) {
+        size += atomic_load_explicit(&pq->lanes[i].size, memory_order_relaxed);
+    }
+    return size;
+}
+
 bool pq_is_empty(PriorityQueue *pq) {
-    pthread_mutex_lock(&pq->mutex);
-    bool empty = (pq->size == 0);
-    pthread_mutex_unlock(&pq->mutex);
-    return empty;
+    return pq_size(pq) == 0;
 }
 
 void pq_destroy(PriorityQueue *pq) {
+    free(pq->ready);
+    pq->ready = NULL;
     pthread_mutex_destroy(&pq->mutex);
 }
 
-void *drone_thread_func(void *arg) {
-    Drone *drone = (Drone *)arg;
-    Simulation *sim = global_sim;
-    
-    log_event(sim, ANSI_COLOR_CYAN "[Drone %d] Thread started (Speed: %d, Battery: %d%%)" ANSI_COLOR_RESET,
-              drone->drone_id, drone->speed, drone->battery_level);
-    
-    while (sim->simulation_running && drone->active) {
-        if (drone->current_task != NULL && drone->state != DRONE_PREEMPTED) {
-            Task *task = drone->current_task;
-            
-            if (drone->state == DRONE_IDLE || drone->state == DRONE_LOADING) {
-                log_event(sim, ANSI_COLOR_BLUE "[Drone %d] Waiting for loading bay..." ANSI_COLOR_RESET, 
-                         drone->drone_id);
-                sem_wait(&sim->loading_bays);
-                
-                pthread_mutex_lock(&sim->stats.mutex);
-                sim->stats.loading_bay_uses++;
-                pthread_mutex_unlock(&sim->stats.mutex);
-                
-                drone->state = DRONE_LOADING;
-                const char *priority_color = (task->priority == 1) ? ANSI_COLOR_RED : 
-                                             (task->priority == 2) ? ANSI_COLOR_YELLOW : ANSI_COLOR_GREEN;
-                log_event(sim, "%s[Drone %d] Acquired loading bay - Loading task T%d (Priority %d: %s -> %s)" ANSI_COLOR_RESET,
-                         priority_color, drone->drone_id, task->task_id, task->priority, 
-                         task->source, task->destination);
-                
-                sleep(1);
-                sem_post(&sim->loading_bays);
-                log_event(sim, "[Drone %d] Released loading bay", drone->drone_id);
-                
-                drone->state = DRONE_DELIVERING;
-                task->state = TASK_IN_PROGRESS;
-                task->start_time = time(NULL);
-            }
-            
-            if (drone->state == DRONE_DELIVERING && drone->battery_level > BATTERY_LOW_THRESHOLD) {
-                int delivery_time = task->estimated_time / drone->speed;
-                if (delivery_time < 1) delivery_time = 1;
-                
-                for (int i = 0; i < delivery_time && drone->state == DRONE_DELIVERING; i++) {
-                    sleep(1);
-                    drone->battery_level -= BATTERY_DRAIN_RATE;
-                    
-                    if (drone->battery_level <= BATTERY_LOW_THRESHOLD) {
-                        log_event(sim, ANSI_COLOR_YELLOW "[Drone %d] Battery critical (%d%%), must charge!" ANSI_COLOR_RESET,
-                                 drone->drone_id, drone->battery_level);
-                        break;
-                    }
-                }
-                
-                if (drone->state == DRONE_DELIVERING) {
-                    task->state = TASK_COMPLETED;
-                    task->end_time = time(NULL);
-                    double elapsed = difftime(task->end_time, task->start_time);
-                    
-                    pthread_mutex_lock(&sim->stats.mutex);
-                    sim->stats.completed_tasks++;
-                    sim->stats.total_delivery_time += elapsed;
-                    pthread_mutex_unlock(&sim->stats.mutex);
-                    
-                    log_event(sim, ANSI_COLOR_GREEN "[Drone %d] ✓ Completed task T%d (%.0f seconds, Battery: %d%%)" ANSI_COLOR_RESET,
-                             drone->drone_id, task->task_id, elapsed, drone->battery_level);
-                    
-                    drone->tasks_completed++;
-                    drone->current_task = NULL;
-                    drone->state = DRONE_IDLE;
-                }
-            }
+static bool ready_before(const ReadyEntry *a, const ReadyEntry *b) {
+    return a->key < b->key || (a->key == b->key && a->seq < b->seq);
+}
+
+static void ready_push(PriorityQueue *pq, long long key, Task *task) {
+    if (pq->ready_count == pq->ready_capacity) {
+        pq->ready_capacity = pq->ready_capacity > 0 ? pq->ready_capacity * 2 : 256;
+        pq->ready = (ReadyEntry *)realloc(pq->ready, sizeof(ReadyEntry) * pq->ready_capacity);
+    }
+    int i = pq->ready_count++;
+    ReadyEntry entry = { key, pq->ready_seq++, task };
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!ready_before(&entry, &pq->ready[parent])) break;
+        pq->ready[i] = pq->ready[parent];
+        i = parent;
+    }
+    pq->ready[i] = entry;
+}
+
+static Task *ready_pop(PriorityQueue *pq) {
+    Task *task = pq->ready[0].task;
+    ReadyEntry last = pq->ready[--pq->ready_count];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= pq->ready_count) break;
+        if (child + 1 < pq->ready_count && ready_before(&pq->ready[child + 1], &pq->ready[child])) child++;
+        if (!ready_before(&pq->ready[child], &last)) break;
+        pq->ready[i] = pq->ready[child];
+        i = child;
+    }
+    if (pq->ready_count > 0) pq->ready[i] = last;
+    atomic_fetch_sub_explicit(&pq_lane(pq, task->priority)->size, 1, memory_order_relaxed);
+    return task;
+}
+
+/* Caller holds pq->mutex. Keys everything pushed since the last pass into
+ * the ready heap, most urgent lane first so equal keys keep priority and
+ * then arrival order. */
+static void ready_collect(Simulation *sim) {
+    PriorityQueue *pq = &sim->task_queue;
+    for (int i = 0; i < PQ_PRIORITY_LEVELS; i++) {
+        QueueLink *link;
+        while ((link = lane_pop(&pq->lanes[i])) != NULL) {
+            Task *task = task_of(link);
+            ready_push(pq, sim->policy->task_key(sim, task), task);
         }
+    }
+}
+
+/* The next task the policy would dispatch; caller holds task_queue.mutex. */
+static Task *dispatch_peek(Simulation *sim) {
+    if (sim->policy->task_key == NULL) return pq_peek_locked(&sim->task_queue);
+    ready_collect(sim);
+    return sim->task_queue.ready_count > 0 ? sim->task_queue.ready[0].task : NULL;
+}
+
+static Task *dispatch_pop(Simulation *sim) {
+    if (sim->policy->task_key == NULL) return pq_pop_locked(&sim->task_queue);
+    return sim->task_queue.ready_count > 0 ? ready_pop(&sim->task_queue) : NULL;
+}
+
+/* Takes the task the dispatcher would hand out next so another hub can run
+ * it; NULL when nothing is queued. The task stays in this simulation's
+ * pool and totals but is never dispatched here. */
+Task *dispatch_steal(Simulation *sim) {
+    pthread_mutex_lock(&sim->task_queue.mutex);
+    Task *task = dispatch_peek(sim) != NULL ? dispatch_pop(sim) : NULL;
+    pthread_mutex_unlock(&sim->task_queue.mutex);
+    return task;
+}
+
+/* Queues `task` behind everything waiting in dispatch order, leaving its
+ * times alone: putting back tasks taken with dispatch_steal() in the order
+ * they came out restores the queue exactly. */
+void dispatch_requeue(Simulation *sim, Task *task) {
+    if (sim->policy->task_key == NULL) {
+        pq_push(&sim->task_queue, task);
+        return;
+    }
+    pthread_mutex_lock(&sim->task_queue.mutex);
+    atomic_fetch_add_explicit(&pq_lane(&sim->task_queue, task->priority)->size, 1, memory_order_relaxed);
+    ready_push(&sim->task_queue, sim->policy->task_key(sim, task), task);
+    pthread_mutex_unlock(&sim->task_queue.mutex);
+}
+
+void task_pool_init(TaskPool *pool) {
+    pool->slabs = NULL;
+    pool->allocated = 0;
+    pthread_mutex_init(&pool->mutex, NULL);
+}
+
+/* Tasks live until the simulation is destroyed, so they are carved out of
+ * fixed-size slabs and released all at once instead of malloc'd one by one. */
+Task *task_pool_alloc(TaskPool *pool) {
+    pthread_mutex_lock(&pool->mutex);
+    
+    if (pool->slabs == NULL || pool->slabs->used == TASK_SLAB_SIZE) {
+        TaskSlab *slab = (TaskSlab *)malloc(sizeof(TaskSlab));
+        if (slab == NULL) {
+            pthread_mutex_unlock(&pool->mutex);
+            return NULL;
+        }
+        slab->next = pool->slabs;
+        slab->used = 0;
+        pool->slabs = slab;
+    }
+    
+    Task *task = &pool->slabs->tasks[pool->slabs->used++];
+    pool->allocated++;
+    
+    pthread_mutex_unlock(&pool->mutex);
+    return task;
+}
+
+void task_pool_destroy(TaskPool *pool) {
+    TaskSlab *slab = pool->slabs;
+    while (slab != NULL) {
+        TaskSlab *next = slab->next;
+        free(slab);
+        slab = next;
+    }
+    pool->slabs = NULL;
+    pool->allocated = 0;
+    pthread_mutex_destroy(&pool->mutex);
+}
+
+/* Re-files a drone in the scheduler's indexes after any change to its state,
+ * task, battery or position: the idle pool is keyed by battery so the best
+ * candidate is at the top and mirrored in a spatial index for located
+ * tasks, and the preemptible pool is keyed by task priority so the least
+ * urgent running task is the first victim. Caller holds fleet_mutex. */
+void fleet_update_locked(Simulation *sim, int idx) {
+    Drone *drone = &sim->drones[idx];
+    bool charged = drone->active && drone->battery_level > BATTERY_LOW_THRESHOLD;
+    
+    if (charged && drone->state == DRONE_IDLE && drone->current_task == NULL) {
+        di_update(&sim->idle_drones, idx, drone->battery_level);
+        si_update(&sim->idle_positions, idx, drone->position);
+    } else {
+        di_remove(&sim->idle_drones, idx);
+        si_remove(&sim->idle_positions, idx);
+    }
+    
+    if (charged && drone->current_task != NULL && drone->current_task->priority > 1) {
+        di_update(&sim->preemptible_drones, idx, drone->current_task->priority);
+    } else {
+        di_remove(&sim->preemptible_drones, idx);
+    }
+}
+
+/* Every state change goes through here to keep the live drone gauges. */
+void set_drone_state(Simulation *sim, Drone *drone, DroneState state) {
+    metrics_gauge_add(&sim->metrics.drones[drone->state], -1);
+    metrics_gauge_add(&sim->metrics.drones[state], 1);
+    drone->state = state;
+}
+
+void fleet_update(Simulation *sim, int drone_index) {
+    pthread_mutex_lock(&sim->fleet_mutex);
+    fleet_update_locked(sim, drone_index);
+    pthread_mutex_unlock(&sim->fleet_mutex);
+}
+
+long long sim_clock_us(Simulation *sim) {
+    if (sim->engine == ENGINE_DES) {
+        return sim->virtual_time * 1000000LL;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+/* Wakes the scheduler thread; a no-op for the discrete-event engine, which
+ * schedules its own ticks. */
+void scheduler_notify(Simulation *sim) {
+    if (sim->engine != ENGINE_THREADS) return;
+    
+    pthread_mutex_lock(&sim->scheduler_mutex);
+    sim->scheduler_signaled = true;
+    pthread_cond_signal(&sim->scheduler_wakeup);
+    pthread_mutex_unlock(&sim->scheduler_mutex);
+}
+
+void enqueue_task(Simulation *sim, Task *task) {
+    task->created_at = sim_clock_us(sim);
+    task->enqueued_at = task->created_at;
+    pq_push(&sim->task_queue, task);
+    scheduler_notify(sim);
+}
+
+static void dispatch_record(Simulation *sim, int count, int drone, Task *task, Task *preempted, DroneState preempted_state) {
+    if (count == sim->dispatch_records_capacity) {
+        int new_capacity = sim->dispatch_records_capacity > 0 ? sim->dispatch_records_capacity * 2 : 64;
+        sim->dispatch_records = (DispatchRecord *)realloc(sim->dispatch_records, sizeof(DispatchRecord) * new_capacity);
+        sim->dispatch_records_capacity = new_capacity;
+    }
+    DispatchRecord *rec = &sim->dispatch_records[count];
+    rec->drone = drone;
+    rec->task = task;
+    rec->preempted = preempted;
+    rec->preempted_state = preempted_state;
+}
+
+/* Matches as many queued tasks to drones as possible in one pass, holding
+ * the consumer lock once for the whole batch. Preemption is the fallback for
+ * urgent tasks once no idle drone is left. The matches are handed to the
+ * drone state machine before the fleet lock is released, so no timer of a
+ * preempted drone can fire in between; returns the count. */
+int dispatch_pending_tasks(Simulation *sim) {
+    int count = 0;
+    long long now = sim_clock_us(sim);
+    Task *blocked = NULL;
+    
+    pthread_mutex_lock(&sim->task_queue.mutex);
+    pthread_mutex_lock(&sim->fleet_mutex);
+    
+    while (true) {
+        Task *head = dispatch_peek(sim);
+        if (head == NULL) break;
         
-        if (drone->battery_level <= BATTERY_LOW_THRESHOLD && drone->state != DRONE_CHARGING) {
-            if (drone->current_task != NULL && drone->state != DRONE_PREEMPTED) {
-                log_event(sim, ANSI_COLOR_MAGENTA "[Scheduler] Pausing Drone %d task T%d due to low battery" ANSI_COLOR_RESET,
-                         drone->drone_id, drone->current_task->task_id);
-                drone->current_task->state = TASK_PENDING;
-                pq_push(&sim->task_queue, drone->current_task);
-                drone->current_task = NULL;
-            }
-            
-            log_event(sim, "[Drone %d] Requesting charging station...", drone->drone_id);
-            sem_wait(&sim->charging_stations);
-            
-            pthread_mutex_lock(&sim->stats.mutex);
-            sim->stats.charging_station_uses++;
-            pthread_mutex_unlock(&sim->stats.mutex);
-            
-            drone->state = DRONE_CHARGING;
-            log_event(sim, ANSI_COLOR_YELLOW "[Drone %d] Acquired charging station (Battery: %d%%)" ANSI_COLOR_RESET,
-                     drone->drone_id, drone->battery_level);
-            
-            while (drone->battery_level < 100) {
-                sleep(1);
-                drone->battery_level += BATTERY_CHARGE_RATE;
-                if (drone->battery_level > 100) drone->battery_level = 100;
-            }
-            
-            log_event(sim, ANSI_COLOR_GREEN "[Drone %d] Fully charged (100%%), releasing charging station" ANSI_COLOR_RESET,
-                     drone->drone_id);
-            sem_post(&sim->charging_stations);
-            drone->state = DRONE_IDLE;
+        int best_idx;
+        if (head->located) {
+            Point pickup;
+            lt_position(&sim->locations, head->source, &pickup);
+            best_idx = si_nearest(&sim->idle_positions, pickup);
+        } else {
+            best_idx = di_top(&sim->idle_drones);
+        }
+        bool preempt = false;
+        if (best_idx < 0 && head->priority == 1 && sim->policy->preempt) {
+            best_idx = di_top(&sim->preemptible_drones);
+            preempt = true;
         }
+        if (best_idx < 0) {
+            blocked = head;
+            break;
+        }
+        
+        Task *task = dispatch_pop(sim);
+        if (task == NULL) break;
         
-        if (drone->state == DRONE_IDLE && drone->current_task == NULL) {
-            sleep(1);
+        Task *preempted = NULL;
+        DroneState preempted_state = DRONE_IDLE;
+        if (preempt) {
+            Drone *victim = &sim->drones[best_idx];
+            preempted = victim->current_task;
+            preempted_state = victim->state;
+            preempted->state = TASK_PREEMPTED;
+            preempted->enqueued_at = now;
+            victim->current_task = NULL;
+            set_drone_state(sim, victim, DRONE_PREEMPTED);
+            victim->preempted_count++;
+            pq_push(&sim->task_queue, preempted);
         }
+        
+        Drone *drone = &sim->drones[best_idx];
+        task->state = TASK_ASSIGNED;
+        task->assigned_drone = drone->drone_id;
+        task->assigned_at = now;
+        drone->current_task = task;
+        set_drone_state(sim, drone, DRONE_IDLE);
+        fleet_update_locked(sim, best_idx);
+        
+        dispatch_record(sim, count++, best_idx, task, preempted, preempted_state);
     }
     
-    log_event(sim, "[Drone %d] Thread terminated", drone->drone_id);
-    return NULL;
+    if (sim->fsm != NULL) {
+        if (count > 0) fsm_apply_dispatch(sim->fsm, count);
+        fsm_set_backlog(sim->fsm, blocked, blocked != NULL ? pq_size(&sim->task_queue) : 0);
+    }
+    
+    pthread_mutex_unlock(&sim->fleet_mutex);
+    pthread_mutex_unlock(&sim->task_queue.mutex);
+    
+    if (count == 0) return 0;
+    
+    int preemptions = 0;
+    for (int i = 0; i < count; i++) {
+        DispatchRecord *rec = &sim->dispatch_records[i];
+        phase_record(&sim->stats.phases, PHASE_QUEUE_WAIT, rec->task->priority, now - rec->task->enqueued_at);
+        if (rec->preempted != NULL) preemptions++;
+    }
+    metrics_count(&sim->metrics.tasks_assigned, count);
+    if (preemptions > 0) {
+        metrics_count(&sim->metrics.preemptions, preemptions);
+        pthread_mutex_lock(&sim->stats.mutex);
+        sim->stats.total_preemptions += preemptions;
+        pthread_mutex_unlock(&sim->stats.mutex);
+    }
+    
+    /* Drone ids are slot + 1; the fleet array itself may be growing by now. */
+    for (int i = 0; i < count; i++) {
+        DispatchRecord *rec = &sim->dispatch_records[i];
+        int drone_id = rec->drone + 1;
+        Task *task = rec->task;
+        
+        if (rec->preempted != NULL) {
+            log_record(sim, &(LogRecord){ .type = LOG_PREEMPTION, .drone_id = drone_id,
+                                          .task_id = rec->preempted->task_id,
+                                          .priority = rec->preempted->priority, .aux = task->task_id });
+        }
+        log_record(sim, &(LogRecord){ .type = LOG_ASSIGNED, .drone_id = drone_id,
+                                      .task_id = task->task_id, .priority = task->priority });
+    }
+    if (count > 1) {
+        log_record(sim, &(LogRecord){ .type = LOG_DISPATCH_BATCH, .value = count });
+    }
+    
+    return count;
 }
 
 void *scheduler_thread_func(void *arg) {
@@ -245,69 +452,14 @@ void *scheduler_thread_func(void *arg) {
     log_event(sim, ANSI_COLOR_MAGENTA "══════════════════════════════════════" ANSI_COLOR_RESET);
     
     while (sim->simulation_running) {
-        if (!pq_is_empty(&sim->task_queue)) {
-            Task *highest_priority_task = pq_peek(&sim->task_queue);
-            
-            if (highest_priority_task != NULL) {
-                Drone *best_drone = NULL;
-                
-                for (int i = 0; i < sim->num_drones; i++) {
-                    if (sim->drones[i].active && sim->drones[i].battery_level > BATTERY_LOW_THRESHOLD) {
-                        if (sim->drones[i].state == DRONE_IDLE && sim->drones[i].current_task == NULL) {
-                            if (best_drone == NULL || sim->drones[i].battery_level > best_drone->battery_level) {
-                                best_drone = &sim->drones[i];
-                            }
-                        }
-                    }
-                }
-                
-                if (highest_priority_task->priority == 1) {
-                    for (int i = 0; i < sim->num_drones; i++) {
-                        if (sim->drones[i].active && 
-                            sim->drones[i].current_task != NULL && 
-                            sim->drones[i].current_task->priority > 1 &&
-                            sim->drones[i].battery_level > BATTERY_LOW_THRESHOLD) {
-                            
-                            log_event(sim, ANSI_COLOR_RED "[Scheduler] ⚠ PREEMPTION: Interrupting Drone %d (Task T%d, Priority %d) for urgent task T%d" ANSI_COLOR_RESET,
-                                     sim->drones[i].drone_id, 
-                                     sim->drones[i].current_task->task_id,
-                                     sim->drones[i].current_task->priority,
-                                     highest_priority_task->task_id);
-                            
-                            sim->drones[i].current_task->state = TASK_PREEMPTED;
-                            pq_push(&sim->task_queue, sim->drones[i].current_task);
-                            sim->drones[i].current_task = NULL;
-                            sim->drones[i].state = DRONE_PREEMPTED;
-                            sim->drones[i].preempted_count++;
-                            
-                            pthread_mutex_lock(&sim->stats.mutex);
-                            sim->stats.total_preemptions++;
-                            pthread_mutex_unlock(&sim->stats.mutex);
-                            
-                            best_drone = &sim->drones[i];
-                            break;
-                        }
-                    }
-                }
-                
-                if (best_drone != NULL) {
-                    Task *task = pq_pop(&sim->task_queue);
-                    if (task != NULL) {
-                        task->state = TASK_ASSIGNED;
-                        task->assigned_drone = best_drone->drone_id;
-                        best_drone->current_task = task;
-                        best_drone->state = DRONE_IDLE;
-                        
-                        const char *priority_color = (task->priority == 1) ? ANSI_COLOR_RED : 
-                                                     (task->priority == 2) ? ANSI_COLOR_YELLOW : ANSI_COLOR_GREEN;
-                        log_event(sim, "%s[Scheduler] Assigned task T%d (Priority %d) to Drone %d" ANSI_COLOR_RESET,
-                                 priority_color, task->task_id, task->priority, best_drone->drone_id);
-                    }
-                }
-            }
-        }
+        dispatch_pending_tasks(sim);
         
-        sleep(1);
+        pthread_mutex_lock(&sim->scheduler_mutex);
+        while (sim->simulation_running && !sim->scheduler_signaled) {
+            pthread_cond_wait(&sim->scheduler_wakeup, &sim->scheduler_mutex);
+        }
+        sim->scheduler_signaled = false;
+        pthread_mutex_unlock(&sim->scheduler_mutex);
     }
     
     log_event(sim, ANSI_COLOR_MAGENTA "[Scheduler] Thread terminated" ANSI_COLOR_RESET);
@@ -315,13 +467,55 @@ void *scheduler_thread_func(void *arg) {
 }
 
 void init_simulation(Simulation *sim, int num_drones, int num_charging, int num_loading) {
-    global_sim = sim;
+    SimOptions options = {
+        .num_drones = num_drones,
+        .num_charging = num_charging,
+        .num_loading = num_loading,
+        .engine = ENGINE_THREADS,
+        .output = OUTPUT_TEXT
+    };
+    init_simulation_with_options(sim, &options);
+}
+
+/* The engine and format have to be known before the banner below is
+ * logged: they decide its timestamp and encoding. */
+void init_simulation_with_options(Simulation *sim, const SimOptions *options) {
+    int num_charging = options->num_charging;
+    int num_loading = options->num_loading;
+    
+    lt_init(&sim->locations);
+    sim->log = (EventLog *)malloc(sizeof(EventLog));
+    event_log_start(sim->log, options->out != NULL ? options->out : stdout, options->output, &sim->locations);
+    
     sim->num_drones = 0;
+    sim->drone_capacity = (options->num_drones > INITIAL_DRONE_CAPACITY) ? options->num_drones : INITIAL_DRONE_CAPACITY;
+    sim->drones = (Drone *)malloc(sizeof(Drone) * sim->drone_capacity);
     sim->simulation_running = false;
     sim->num_charging_stations = num_charging;
     sim->num_loading_bays = num_loading;
+    sim->engine = options->deterministic ? ENGINE_DES : options->engine;
+    sim->virtual_time = 0;
+    sim->deterministic = options->deterministic;
+    sim->seed = options->seed;
+    sim->quiet_setup = options->quiet_setup;
+    sim->trace = NULL;
+    sim->workload = NULL;
+    sim->policy = options->policy != NULL ? options->policy : policy_default();
+    sim->full_charge = options->full_charge;
     
     pq_init(&sim->task_queue);
+    task_pool_init(&sim->task_pool);
+    di_init(&sim->idle_drones);
+    di_init(&sim->preemptible_drones);
+    si_init(&sim->idle_positions, SPATIAL_CELL_SIZE);
+    sim->chargers = NULL;
+    sim->num_chargers = 0;
+    pthread_mutex_init(&sim->fleet_mutex, NULL);
+    sim->dispatch_records = NULL;
+    sim->dispatch_records_capacity = 0;
+    sim->fsm = NULL;
+    sim->pool = NULL;
+    sim->num_workers = 0;
     
     pthread_mutex_init(&sim->stats.mutex, NULL);
     sim->stats.total_tasks = 0;
@@ -330,59 +524,130 @@ void init_simulation(Simulation *sim, int num_drones, int num_charging, int num_
     sim->stats.total_delivery_time = 0.0;
     sim->stats.charging_station_uses = 0;
     sim->stats.loading_bay_uses = 0;
+    phase_timers_init(&sim->stats.phases);
+    metrics_init(&sim->metrics);
+    sim->stats.loading_busy_us = 0;
+    sim->stats.charging_busy_us = 0;
+    memset(&sim->stats.charging_series, 0, sizeof(UtilizationSeries));
+    sim->stats.charging_series.window_us = SIM_SECOND_US;
+    sim->stats.span_us = 0;
     
-    sem_init(&sim->charging_stations, 0, num_charging);
-    sem_init(&sim->loading_bays, 0, num_loading);
-    pthread_mutex_init(&sim->log_mutex, NULL);
+    pthread_mutex_init(&sim->scheduler_mutex, NULL);
+    pthread_cond_init(&sim->scheduler_wakeup, NULL);
+    sim->scheduler_signaled = false;
     
-    printf("\n");
+    
+    log_blank(sim);
     log_event(sim, ANSI_COLOR_CYAN "╔════════════════════════════════════════════════════════╗" ANSI_COLOR_RESET);
     log_event(sim, ANSI_COLOR_CYAN "║   AUTONOMOUS DELIVERY DRONE SCHEDULER SIMULATION       ║" ANSI_COLOR_RESET);
     log_event(sim, ANSI_COLOR_CYAN "╚════════════════════════════════════════════════════════╝" ANSI_COLOR_RESET);
     log_event(sim, "Charging Stations: %d | Loading Bays: %d", num_charging, num_loading);
+    if (sim->policy != policy_default()) {
+        log_event(sim, "Scheduling Policy: %s (%s)", sim->policy->name, sim->policy->description);
+    }
 }
 
 void add_drone(Simulation *sim, int speed, int battery) {
-    if (sim->num_drones >= MAX_DRONES) {
-        log_event(sim, "Cannot add more drones (max: %d)", MAX_DRONES);
-        return;
+    add_drone_at(sim, speed, battery, (Point){ 0, 0 });
+}
+
+/* Drones without a configured position start at the origin (the hub). A
+ * drone added while the simulation runs joins under fleet_mutex, since
+ * the fleet array may move, and is filed with the scheduler at once. */
+void add_drone_at(Simulation *sim, int speed, int battery, Point position) {
+    bool running = sim->simulation_running;
+    if (running) pthread_mutex_lock(&sim->fleet_mutex);
+    
+    if (sim->num_drones == sim->drone_capacity) {
+        int new_capacity = sim->drone_capacity * 2;
+        Drone *grown = (Drone *)realloc(sim->drones, sizeof(Drone) * new_capacity);
+        if (grown == NULL) {
+            if (running) pthread_mutex_unlock(&sim->fleet_mutex);
+            log_event(sim, "Cannot add more drones (out of memory at %d)", sim->num_drones);
+            return;
+        }
+        sim->drones = grown;
+        sim->drone_capacity = new_capacity;
     }
     
-    Drone *drone = &sim->drones[sim->num_drones];
-    drone->drone_id = sim->num_drones + 1;
+    int idx = sim->num_drones;
+    Drone *drone = &sim->drones[idx];
+    drone->drone_id = idx + 1;
     drone->state = DRONE_IDLE;
+    metrics_gauge_add(&sim->metrics.drones[DRONE_IDLE], 1);
     drone->battery_level = battery;
     drone->speed = speed;
     drone->current_task = NULL;
     drone->active = true;
     drone->tasks_completed = 0;
     drone->preempted_count = 0;
+    drone->position = position;
     
     sim->num_drones++;
-    log_event(sim, ANSI_COLOR_GREEN "[Setup] Added Drone %d (Speed: %d, Battery: %d%%)" ANSI_COLOR_RESET,
-             drone->drone_id, speed, battery);
+    if (running) {
+        if (sim->fsm != NULL) fsm_add_drone(sim->fsm, idx);
+        pthread_mutex_unlock(&sim->fleet_mutex);
+        scheduler_notify(sim);
+    }
+    if (sim->quiet_setup && !running) return;
+    log_record(sim, &(LogRecord){ .type = LOG_DRONE_ADDED, .drone_id = idx + 1,
+                                  .battery = battery, .value = speed });
 }
 
-void add_task(Simulation *sim, const char *source, const char *dest, int priority, int est_time) {
-    Task *task = (Task *)malloc(sizeof(Task));
-    task->task_id = sim->stats.total_tasks + 1;
-    strncpy(task->source, source, MAX_LOCATION_LEN - 1);
-    strncpy(task->destination, dest, MAX_LOCATION_LEN - 1);
-    task->priority = priority;
+/* Queues a task between two interned locations. It is flown by distance,
+ * and goes to the idle drone nearest its pickup, when both locations have
+ * coordinates; otherwise by `est_time`. */
+Task *add_task_between(Simulation *sim, LocationId source, LocationId dest, int priority, int est_time) {
+    Task *task = task_pool_alloc(&sim->task_pool);
+    if (task == NULL) {
+        fprintf(stderr, "Error: Out of memory allocating task\n");
+        return NULL;
+    }
+    pthread_mutex_lock(&sim->stats.mutex);
+    task->task_id = ++sim->stats.total_tasks;
+    pthread_mutex_unlock(&sim->stats.mutex);
+    metrics_count(&sim->metrics.tasks_added, 1);
+    task->source = source;
+    task->destination = dest;
+    task->priority = (unsigned char)priority;
     task->estimated_time = est_time;
     task->state = TASK_PENDING;
     task->assigned_drone = -1;
+    task->located = lt_position(&sim->locations, source, NULL) && lt_position(&sim->locations, dest, NULL);
     
-    pq_push(&sim->task_queue, task);
-    
-    pthread_mutex_lock(&sim->stats.mutex);
-    sim->stats.total_tasks++;
-    pthread_mutex_unlock(&sim->stats.mutex);
+    enqueue_task(sim, task);
     
-    const char *priority_color = (priority == 1) ? ANSI_COLOR_RED : 
-                                 (priority == 2) ? ANSI_COLOR_YELLOW : ANSI_COLOR_GREEN;
-    log_event(sim, "%s[Setup] Added task T%d: %s → %s (Priority: %d, Est. Time: %ds)" ANSI_COLOR_RESET,
-             priority_color, task->task_id, source, dest, priority, est_time);
+    if (sim->quiet_setup && !sim->simulation_running) return task;
+    log_record(sim, &(LogRecord){ .type = LOG_TASK_ADDED, .task_id = task->task_id,
+                                  .priority = priority, .value = est_time, .ref = task });
+    return task;
+}
+
+static LocationId intern_location(Simulation *sim, const char *name) {
+    return lt_intern(&sim->locations, name, strnlen(name, MAX_LOCATION_LEN - 1));
+}
+
+void add_task(Simulation *sim, const char *source, const char *dest, int priority, int est_time) {
+    add_task_between(sim, intern_location(sim, source), intern_location(sim, dest), priority, est_time);
+}
+
+/* Places `source` at `pickup` and `dest` at `dropoff`, then queues a task
+ * between them. */
+void add_located_task(Simulation *sim, const char *source, const char *dest, int priority, int est_time,
+                      Point pickup, Point dropoff) {
+    LocationId from = intern_location(sim, source);
+    LocationId to = intern_location(sim, dest);
+    lt_place(&sim->locations, from, pickup);
+    lt_place(&sim->locations, to, dropoff);
+    add_task_between(sim, from, to, priority, est_time);
+}
+
+void add_charger(Simulation *sim, Point position) {
+    bool running = sim->simulation_running;
+    if (running) pthread_mutex_lock(&sim->fleet_mutex);
+    sim->chargers = (Point *)realloc(sim->chargers, sizeof(Point) * (sim->num_chargers + 1));
+    sim->chargers[sim->num_chargers++] = position;
+    if (running) pthread_mutex_unlock(&sim->fleet_mutex);
 }
 
 void start_simulation(Simulation *sim) {
@@ -390,32 +655,132 @@ void start_simulation(Simulation *sim) {
     
     log_event(sim, "\n" ANSI_COLOR_MAGENTA "════════════ STARTING SIMULATION ════════════" ANSI_COLOR_RESET);
     
-    for (int i = 0; i < sim->num_drones; i++) {
-        pthread_create(&sim->drones[i].thread, NULL, drone_thread_func, &sim->drones[i]);
-    }
+    int workers = sim->num_workers;
+    if (workers < 1) workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
     
+    sim->pool = (PoolEngine *)malloc(sizeof(PoolEngine));
+    pool_engine_start(sim->pool, sim, workers);
     pthread_create(&sim->scheduler_thread, NULL, scheduler_thread_func, sim);
+    if (sim->workload != NULL) workload_start(sim->workload);
 }
 
 void stop_simulation(Simulation *sim) {
+    if (sim->workload != NULL) workload_stop(sim->workload);
     log_event(sim, "\n" ANSI_COLOR_YELLOW "════════════ STOPPING SIMULATION ════════════" ANSI_COLOR_RESET);
+    
+    pthread_mutex_lock(&sim->fleet_mutex);
     sim->simulation_running = false;
+    pthread_mutex_unlock(&sim->fleet_mutex);
+    
+    pthread_mutex_lock(&sim->scheduler_mutex);
+    pthread_cond_broadcast(&sim->scheduler_wakeup);
+    pthread_mutex_unlock(&sim->scheduler_mutex);
     
     pthread_join(sim->scheduler_thread, NULL);
     
-    for (int i = 0; i < sim->num_drones; i++) {
-        pthread_join(sim->drones[i].thread, NULL);
-    }
+    pool_engine_stop(sim->pool);
+    free(sim->pool);
+    sim->pool = NULL;
     
-    sem_destroy(&sim->charging_stations);
-    sem_destroy(&sim->loading_bays);
-    pthread_mutex_destroy(&sim->log_mutex);
+    destroy_simulation(sim);
+}
+
+void destroy_simulation(Simulation *sim) {
     pthread_mutex_destroy(&sim->stats.mutex);
+    pthread_mutex_destroy(&sim->fleet_mutex);
+    pthread_mutex_destroy(&sim->scheduler_mutex);
+    pthread_cond_destroy(&sim->scheduler_wakeup);
     pq_destroy(&sim->task_queue);
 }
 
+void free_simulation(Simulation *sim) {
+    event_log_stop(sim->log);
+    free(sim->log);
+    sim->log = NULL;
+    task_pool_destroy(&sim->task_pool);
+    di_destroy(&sim->idle_drones);
+    di_destroy(&sim->preemptible_drones);
+    si_destroy(&sim->idle_positions);
+    lt_destroy(&sim->locations);
+    free(sim->chargers);
+    sim->chargers = NULL;
+    sim->num_chargers = 0;
+    free(sim->dispatch_records);
+    sim->dispatch_records = NULL;
+    phase_timers_destroy(&sim->stats.phases);
+    free(sim->drones);
+    sim->drones = NULL;
+    sim->num_drones = 0;
+    sim->drone_capacity = 0;
+}
+
+static void format_latency(char *buf, size_t len, long long us) {
+    if (us < 1000) {
+        snprintf(buf, len, "%lldus", us);
+    } else if (us < 1000000) {
+        snprintf(buf, len, "%.2fms", us / 1000.0);
+    } else {
+        snprintf(buf, len, "%.2fs", us / 1000000.0);
+    }
+}
+
+static void print_histogram(Simulation *sim, const char *label, const Histogram *h) {
+    if (h->total == 0) return;
+    
+    char p50[32], p90[32], p99[32], max[32];
+    format_latency(p50, sizeof(p50), hist_percentile(h, 50));
+    format_latency(p90, sizeof(p90), hist_percentile(h, 90));
+    format_latency(p99, sizeof(p99), hist_percentile(h, 99));
+    format_latency(max, sizeof(max), h->max);
+    log_event(sim, "%s (%llu samples): p50 %s | p90 %s | p99 %s | max %s",
+              label, (unsigned long long)h->total, p50, p90, p99, max);
+}
+
+/* One line per phase over all priorities, then one per priority when the
+ * phase saw more than one. Call after the engine has stopped. */
+static void print_phase(Simulation *sim, const char *label, Phase phase) {
+    Histogram *h = (Histogram *)malloc(sizeof(Histogram));
+    phase_timers_merge(&sim->stats.phases, phase, -1, h);
+    print_histogram(sim, label, h);
+    uint64_t total = h->total;
+    
+    for (int priority = 1; priority < PHASE_PRIORITY_SLOTS; priority++) {
+        phase_timers_merge(&sim->stats.phases, phase, priority, h);
+        if (h->total == 0 || h->total == total) continue;
+        char sub_label[64];
+        snprintf(sub_label, sizeof(sub_label), "  priority %d", priority);
+        print_histogram(sim, sub_label, h);
+    }
+    free(h);
+}
+
+/* Station-time in use over station-time available, for the whole run and
+ * for each window of the run (the windows widen as the run grows). */
+static void print_charging_utilization(Simulation *sim) {
+    const UtilizationSeries *series = &sim->stats.charging_series;
+    long long span_us = sim->stats.span_us;
+    int stations = sim->num_charging_stations;
+    
+    log_event(sim, "Charging Station Utilization: %.2f%%",
+              sim->stats.charging_busy_us * 100.0 / ((double)stations * span_us));
+    
+    int windows = (int)((span_us + series->window_us - 1) / series->window_us);
+    if (windows > UTIL_MAX_WINDOWS) windows = UTIL_MAX_WINDOWS;
+    if (windows < 2) return;
+    char line[UTIL_MAX_WINDOWS * 5 + 1];
+    int used = 0;
+    for (int w = 0; w < windows; w++) {
+        long long length = span_us - w * series->window_us;
+        if (length > series->window_us) length = series->window_us;
+        int pct = (int)(series->busy_us[w] * 100 / ((long long)stations * length));
+        used += snprintf(line + used, sizeof(line) - used, " %d", pct);
+    }
+    log_event(sim, "Charging Station Utilization over time (%% per %llds):%s",
+              series->window_us / SIM_SECOND_US, line);
+}
+
 void print_statistics(Simulation *sim) {
-    printf("\n");
+    log_blank(sim);
     log_event(sim, ANSI_COLOR_CYAN "╔════════════════════════════════════════════════════════╗" ANSI_COLOR_RESET);
     log_event(sim, ANSI_COLOR_CYAN "║              SIMULATION STATISTICS                      ║" ANSI_COLOR_RESET);
     log_event(sim, ANSI_COLOR_CYAN "╚════════════════════════════════════════════════════════╝" ANSI_COLOR_RESET);
@@ -428,20 +793,26 @@ void print_statistics(Simulation *sim) {
         log_event(sim, "Average Delivery Time: %.2f seconds", avg_time);
     }
     
+    print_phase(sim, "Dispatch Latency (enqueue→assign)", PHASE_QUEUE_WAIT);
+    print_phase(sim, "Pickup Latency (assign→drone)", PHASE_PICKUP);
+    print_phase(sim, "Loading Bay Wait", PHASE_BAY_WAIT);
+    print_phase(sim, "Charging Station Wait", PHASE_CHARGER_WAIT);
+    print_phase(sim, "Flight Time (load→drop-off)", PHASE_FLIGHT);
+    print_phase(sim, "Completion Latency (enqueue→done)", PHASE_DELIVERY);
+    
     log_event(sim, "Charging Station Uses: %d", sim->stats.charging_station_uses);
     log_event(sim, "Loading Bay Uses: %d", sim->stats.loading_bay_uses);
     
-    if (sim->num_charging_stations > 0 && sim->stats.charging_station_uses > 0) {
-        double charging_util = (sim->stats.charging_station_uses * 100.0) / (sim->num_charging_stations * sim->stats.total_tasks);
-        log_event(sim, "Charging Station Utilization: %.2f%%", charging_util);
+    if (sim->num_charging_stations > 0 && sim->stats.charging_station_uses > 0 && sim->stats.span_us > 0) {
+        print_charging_utilization(sim);
     }
     
-    printf("\n");
+    log_blank(sim);
     log_event(sim, ANSI_COLOR_CYAN "─────────────── DRONE SUMMARY ───────────────" ANSI_COLOR_RESET);
     for (int i = 0; i < sim->num_drones; i++) {
         log_event(sim, "Drone %d: %d tasks completed, %d preemptions, Battery: %d%%",
                  sim->drones[i].drone_id, sim->drones[i].tasks_completed, 
                  sim->drones[i].preempted_count, sim->drones[i].battery_level);
     }
-    printf("\n");
+    log_blank(sim);
 }
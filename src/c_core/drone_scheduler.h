@@ -2,18 +2,37 @@
 #define DRONE_SCHEDULER_H
 
 #include <pthread.h>
-#include <semaphore.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <time.h>
+#include "drone_index.h"
+#include "histogram.h"
+#include "location_table.h"
+#include "metrics.h"
+#include "spatial_index.h"
 
-#define MAX_DRONES 50
-#define MAX_TASKS 200
+#define INITIAL_DRONE_CAPACITY 16
+#define TASK_SLAB_SIZE 4096
+#define PQ_PRIORITY_LEVELS 3
+#define CACHE_LINE_SIZE 64
 #define MAX_CHARGING_STATIONS 3
 #define MAX_LOADING_BAYS 5
 #define BATTERY_LOW_THRESHOLD 20
 #define BATTERY_DRAIN_RATE 5
 #define BATTERY_CHARGE_RATE 10
 #define MAX_LOCATION_LEN 50
+#define SPATIAL_CELL_SIZE 100.0
+#define FLIGHT_METRES_PER_SECOND 10.0
+#define UTIL_MAX_WINDOWS 32
+
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_YELLOW  "\x1b[33m"
+#define ANSI_COLOR_BLUE    "\x1b[34m"
+#define ANSI_COLOR_MAGENTA "\x1b[35m"
+#define ANSI_COLOR_CYAN    "\x1b[36m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
 
 typedef enum {
     DRONE_IDLE,
@@ -23,6 +42,39 @@ typedef enum {
     DRONE_PREEMPTED
 } DroneState;
 
+typedef enum {
+    ENGINE_THREADS,
+    ENGINE_DES
+} SimEngine;
+
+typedef enum {
+    OUTPUT_TEXT,
+    OUTPUT_JSONL,
+    OUTPUT_BINARY,
+    OUTPUT_NONE
+} SimOutput;
+
+/* Everything init_simulation_with_options() needs before the first record
+ * is logged. `deterministic` runs are seeded and print nothing wall-clock
+ * dependent, so equal inputs give byte-identical output. `quiet_setup`
+ * drops the per-drone and per-task setup records, which dominate the
+ * output of bulk scenarios. A NULL `policy` is strict priority.
+ * `full_charge` restores first-come charging to 100% (see drone_fsm.c).
+ * `out` receives the event stream; NULL is stdout. */
+typedef struct {
+    int num_drones;
+    int num_charging;
+    int num_loading;
+    SimEngine engine;
+    SimOutput output;
+    bool deterministic;
+    unsigned long long seed;
+    bool quiet_setup;
+    const struct SchedPolicy *policy;
+    bool full_charge;
+    FILE *out;
+} SimOptions;
+
 typedef enum {
     TASK_PENDING,
     TASK_ASSIGNED,
@@ -31,16 +83,28 @@ typedef enum {
     TASK_PREEMPTED
 } TaskState;
 
+typedef struct QueueLink {
+    struct QueueLink *_Atomic next;
+} QueueLink;
+
+/* Hot task record, one cache line: locations are LocationTable ids (their
+ * names and coordinates live in `sim->locations`) and the small enums are
+ * stored in bytes. Times are seconds on the simulation clock. */
 typedef struct {
+    QueueLink link;
     int task_id;
-    char source[MAX_LOCATION_LEN];
-    char destination[MAX_LOCATION_LEN];
-    int priority;
-    int estimated_time;
-    TaskState state;
     int assigned_drone;
-    time_t start_time;
-    time_t end_time;
+    LocationId source;
+    LocationId destination;
+    int estimated_time;
+    int start_time;
+    int end_time;
+    unsigned char priority;
+    unsigned char state;
+    bool located;
+    long long created_at;
+    long long enqueued_at;
+    long long assigned_at;
 } Task;
 
 typedef struct {
@@ -49,18 +113,63 @@ typedef struct {
     int battery_level;
     int speed;
     Task *current_task;
-    pthread_t thread;
     bool active;
     int tasks_completed;
     int preempted_count;
+    Point position;
 } Drone;
 
+/* Intrusive multi-producer single-consumer FIFO (Vyukov). Producers only
+ * exchange `head`; the consumer owns `tail`. The padding keeps the two on
+ * separate cache lines so pushes and pops do not bounce the same line. */
+typedef struct {
+    QueueLink *_Atomic head;
+    atomic_int size;
+    char pad[CACHE_LINE_SIZE];
+    QueueLink *tail;
+    QueueLink stub;
+} TaskLane;
+
 typedef struct {
-    Task *tasks[MAX_TASKS];
-    int size;
+    long long key;
+    unsigned long long seq;
+    Task *task;
+} ReadyEntry;
+
+/* Task queue with one lane per priority level: pushes are lock-free, and
+ * `mutex` only serialises consumers (the dispatcher). A policy that orders
+ * tasks by something other than priority has the dispatcher move them from
+ * the lanes into `ready`, a min-heap it owns. A lane's `size` counts its
+ * tasks until they are dispatched, wherever they sit. */
+typedef struct {
+    TaskLane lanes[PQ_PRIORITY_LEVELS];
     pthread_mutex_t mutex;
+    ReadyEntry *ready;
+    int ready_count;
+    int ready_capacity;
+    unsigned long long ready_seq;
 } PriorityQueue;
 
+typedef struct TaskSlab {
+    struct TaskSlab *next;
+    int used;
+    Task tasks[TASK_SLAB_SIZE];
+} TaskSlab;
+
+typedef struct {
+    TaskSlab *slabs;
+    size_t allocated;
+    pthread_mutex_t mutex;
+} TaskPool;
+
+/* Busy unit-time of a resource pool per window of the run. Windows start
+ * at one second and double, merging neighbours, whenever the run outgrows
+ * UTIL_MAX_WINDOWS of them, so any run length fits. */
+typedef struct {
+    long long window_us;
+    long long busy_us[UTIL_MAX_WINDOWS];
+} UtilizationSeries;
+
 typedef struct {
     int total_tasks;
     int completed_tasks;
@@ -68,30 +177,90 @@ typedef struct {
     double total_delivery_time;
     int charging_station_uses;
     int loading_bay_uses;
+    PhaseTimers phases;
+    long long loading_busy_us;
+    long long charging_busy_us;
+    UtilizationSeries charging_series;
+    long long span_us;
     pthread_mutex_t mutex;
 } Statistics;
 
 typedef struct {
-    Drone drones[MAX_DRONES];
+    int drone;
+    Task *task;
+    Task *preempted;
+    DroneState preempted_state;
+} DispatchRecord;
+
+struct DroneFsm;
+struct PoolEngine;
+struct EventLog;
+struct Trace;
+struct Workload;
+struct SchedPolicy;
+
+typedef struct {
+    Drone *drones;
     int num_drones;
+    int drone_capacity;
     PriorityQueue task_queue;
+    TaskPool task_pool;
+    DroneIndex idle_drones;
+    DroneIndex preemptible_drones;
+    SpatialIndex idle_positions;
+    LocationTable locations;
+    Point *chargers;
+    int num_chargers;
+    pthread_mutex_t fleet_mutex;
+    DispatchRecord *dispatch_records;
+    int dispatch_records_capacity;
     Statistics stats;
-    sem_t charging_stations;
-    sem_t loading_bays;
-    pthread_mutex_t log_mutex;
+    SimMetrics metrics;
+    struct DroneFsm *fsm;
+    struct PoolEngine *pool;
+    int num_workers;
+    struct EventLog *log;
     pthread_t scheduler_thread;
+    pthread_mutex_t scheduler_mutex;
+    pthread_cond_t scheduler_wakeup;
+    bool scheduler_signaled;
     bool simulation_running;
     int num_charging_stations;
     int num_loading_bays;
+    SimEngine engine;
+    long long virtual_time;
+    bool deterministic;
+    unsigned long long seed;
+    bool quiet_setup;
+    struct Trace *trace;
+    struct Workload *workload;
+    const struct SchedPolicy *policy;
+    bool full_charge;
 } Simulation;
 
 void init_simulation(Simulation *sim, int num_drones, int num_charging, int num_loading);
+void init_simulation_with_options(Simulation *sim, const SimOptions *options);
 void add_task(Simulation *sim, const char *source, const char *dest, int priority, int est_time);
 void add_drone(Simulation *sim, int speed, int battery);
+void add_drone_at(Simulation *sim, int speed, int battery, Point position);
+void add_located_task(Simulation *sim, const char *source, const char *dest, int priority, int est_time,
+                      Point pickup, Point dropoff);
+Task *add_task_between(Simulation *sim, LocationId source, LocationId dest, int priority, int est_time);
+void add_charger(Simulation *sim, Point position);
 void start_simulation(Simulation *sim);
 void stop_simulation(Simulation *sim);
+void destroy_simulation(Simulation *sim);
+void free_simulation(Simulation *sim);
 void print_statistics(Simulation *sim);
-void *drone_thread_func(void *arg);
+void fleet_update(Simulation *sim, int drone_index);
+void fleet_update_locked(Simulation *sim, int drone_index);
+void set_drone_state(Simulation *sim, Drone *drone, DroneState state);
+long long sim_clock_us(Simulation *sim);
+void enqueue_task(Simulation *sim, Task *task);
+void scheduler_notify(Simulation *sim);
+int dispatch_pending_tasks(Simulation *sim);
+Task *dispatch_steal(Simulation *sim);
+void dispatch_requeue(Simulation *sim, Task *task);
 void *scheduler_thread_func(void *arg);
 
 void pq_init(PriorityQueue *pq);
@@ -99,8 +268,13 @@ void pq_push(PriorityQueue *pq, Task *task);
 Task *pq_pop(PriorityQueue *pq);
 Task *pq_peek(PriorityQueue *pq);
 bool pq_is_empty(PriorityQueue *pq);
+int pq_size(PriorityQueue *pq);
 void pq_destroy(PriorityQueue *pq);
 
+void task_pool_init(TaskPool *pool);
+Task *task_pool_alloc(TaskPool *pool);
+void task_pool_destroy(TaskPool *pool);
+
 void log_event(Simulation *sim, const char *format, ...);
 
 #endif
@@ -0,0 +1,479 @@
+#include "dronesched.h"
+#include "checkpoint.h"
+#include "des_engine.h"
+#include "event_log.h"
+#include "policy.h"
+#include "scenario.h"
+#include "workload.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* A silent discrete-event simulation and its engine. The engine starts on
+ * the first call that moves the clock; until then drones and tasks are
+ * set up as a config file would. Events reach the caller through the
+ * log's sink, as data, and only once someone asked for them. */
+struct DschedSim {
+    Simulation sim;
+    DesEngine des;
+    Workload workload;
+    bool has_workload;
+    bool started;
+    bool finished;
+    DschedEventFn on_event;
+    void *event_ctx;
+    bool buffering;
+    DschedEvent *events;
+    int events_read;
+    int events_count;
+    int events_capacity;
+};
+
+/* Kept apart from LogEventType so the public numbering never moves. */
+static const int event_types[] = {
+    [LOG_DRONE_ADDED] = DSCHED_EVENT_DRONE_ADDED,
+    [LOG_TASK_ADDED] = DSCHED_EVENT_TASK_ADDED,
+    [LOG_ASSIGNED] = DSCHED_EVENT_ASSIGNED,
+    [LOG_PREEMPTION] = DSCHED_EVENT_PREEMPTION,
+    [LOG_DISPATCH_BATCH] = DSCHED_EVENT_DISPATCH_BATCH,
+    [LOG_WAIT_BAY] = DSCHED_EVENT_WAIT_BAY,
+    [LOG_LOADING] = DSCHED_EVENT_LOADING,
+    [LOG_BAY_RELEASED] = DSCHED_EVENT_BAY_RELEASED,
+    [LOG_BATTERY_CRITICAL] = DSCHED_EVENT_BATTERY_CRITICAL,
+    [LOG_TASK_COMPLETED] = DSCHED_EVENT_TASK_COMPLETED,
+    [LOG_CHARGE_REQUEST] = DSCHED_EVENT_CHARGE_REQUEST,
+    [LOG_CHARGE_START] = DSCHED_EVENT_CHARGE_START,
+    [LOG_CHARGE_END] = DSCHED_EVENT_CHARGE_END,
+    [LOG_DELIVERY_START] = DSCHED_EVENT_DELIVERY_START
+};
+
+static const char *const event_names[] = {
+    [DSCHED_EVENT_DRONE_ADDED] = "drone_added",
+    [DSCHED_EVENT_TASK_ADDED] = "task_added",
+    [DSCHED_EVENT_ASSIGNED] = "assigned",
+    [DSCHED_EVENT_PREEMPTION] = "preemption",
+    [DSCHED_EVENT_DISPATCH_BATCH] = "dispatch_batch",
+    [DSCHED_EVENT_WAIT_BAY] = "wait_bay",
+    [DSCHED_EVENT_LOADING] = "loading",
+    [DSCHED_EVENT_BAY_RELEASED] = "bay_released",
+    [DSCHED_EVENT_BATTERY_CRITICAL] = "battery_critical",
+    [DSCHED_EVENT_TASK_COMPLETED] = "task_completed",
+    [DSCHED_EVENT_CHARGE_REQUEST] = "charge_request",
+    [DSCHED_EVENT_CHARGE_START] = "charge_start",
+    [DSCHED_EVENT_CHARGE_END] = "charge_end",
+    [DSCHED_EVENT_DELIVERY_START] = "delivery_start"
+};
+
+int dsched_api_version(void) {
+    return DSCHED_API_VERSION;
+}
+
+const char *dsched_strerror(int status) {
+    switch (status) {
+        case DSCHED_OK: return "ok";
+        case DSCHED_EINVAL: return "invalid argument";
+        case DSCHED_ESTATE: return "not allowed at this point of the run";
+        case DSCHED_EIO: return "cannot read or write the checkpoint";
+        case DSCHED_ENOMEM: return "out of memory";
+        default: return "unknown error";
+    }
+}
+
+const char *dsched_event_name(int type) {
+    if (type < DSCHED_EVENT_DRONE_ADDED || type > DSCHED_EVENT_DELIVERY_START) return NULL;
+    return event_names[type];
+}
+
+static void dsched_buffer_push(DschedSim *s, const DschedEvent *ev) {
+    if (s->events_count == s->events_capacity) {
+        if (s->events_read > 0) {
+            memmove(s->events, s->events + s->events_read,
+                    sizeof(DschedEvent) * (s->events_count - s->events_read));
+            s->events_count -= s->events_read;
+            s->events_read = 0;
+        } else {
+            int capacity = s->events_capacity > 0 ? s->events_capacity * 2 : 1024;
+            DschedEvent *grown = (DschedEvent *)realloc(s->events, sizeof(DschedEvent) * capacity);
+            if (grown == NULL) return;
+            s->events = grown;
+            s->events_capacity = capacity;
+        }
+    }
+    s->events[s->events_count++] = *ev;
+}
+
+/* Runs inside the engine, on the caller's thread: the record is turned
+ * into a DschedEvent and handed over before the engine moves on. */
+static void dsched_sink(void *ctx, const LogRecord *rec) {
+    DschedSim *s = (DschedSim *)ctx;
+    if (rec->type >= sizeof(event_types) / sizeof(event_types[0]) || event_types[rec->type] == 0) return;
+
+    DschedEvent ev = {
+        .time = rec->time_us / SIM_SECOND_US,
+        .type = event_types[rec->type],
+        .drone = rec->drone_id,
+        .task = rec->task_id,
+        .priority = rec->priority,
+        .battery = rec->battery,
+        .value = rec->value,
+        .aux = rec->aux,
+        .source = -1,
+        .destination = -1
+    };
+    if ((rec->type == LOG_TASK_ADDED || rec->type == LOG_LOADING) && rec->ref != NULL) {
+        const Task *task = (const Task *)rec->ref;
+        ev.source = (int)task->source;
+        ev.destination = (int)task->destination;
+    }
+    if (s->on_event != NULL) {
+        s->on_event(s->event_ctx, &ev);
+    } else {
+        dsched_buffer_push(s, &ev);
+    }
+}
+
+static void dsched_update_sink(DschedSim *s) {
+    bool wanted = s->on_event != NULL || s->buffering;
+    event_log_set_sink(s->sim.log, wanted ? dsched_sink : NULL, s);
+}
+
+void dsched_options_init(DschedOptions *options) {
+    options->num_charging = MAX_CHARGING_STATIONS;
+    options->num_loading = MAX_LOADING_BAYS;
+    options->seed = 0;
+    options->policy = NULL;
+    options->full_charge = 0;
+}
+
+/* Library runs are always seeded, so equal calls give equal results. */
+static void dsched_init(DschedSim *s, const SimOptions *options) {
+    memset(s, 0, sizeof(*s));
+    init_simulation_with_options(&s->sim, options);
+}
+
+int dsched_create(const DschedOptions *options, DschedSim **out) {
+    DschedOptions defaults;
+    if (options == NULL) {
+        dsched_options_init(&defaults);
+        options = &defaults;
+    }
+    *out = NULL;
+    const SchedPolicy *policy = NULL;
+    if (options->policy != NULL && (policy = policy_find(options->policy)) == NULL) return DSCHED_EINVAL;
+    if (options->num_charging < 0 || options->num_loading < 0) return DSCHED_EINVAL;
+
+    DschedSim *s = (DschedSim *)malloc(sizeof(DschedSim));
+    if (s == NULL) return DSCHED_ENOMEM;
+    SimOptions sim_options = {
+        .num_charging = options->num_charging,
+        .num_loading = options->num_loading,
+        .engine = ENGINE_DES,
+        .output = OUTPUT_NONE,
+        .deterministic = true,
+        .seed = options->seed,
+        .policy = policy,
+        .full_charge = options->full_charge != 0
+    };
+    dsched_init(s, &sim_options);
+    *out = s;
+    return DSCHED_OK;
+}
+
+/* Resumes a checkpoint written by dsched_save() or `--checkpoint`. The
+ * stations, seed and workload come from the file; `options` (may be NULL)
+ * can only change the policy or turn on full charging, as `--restore`
+ * does. */
+int dsched_restore(const char *path, const DschedOptions *options, DschedSim **out) {
+    *out = NULL;
+    CheckpointHeader header;
+    FILE *in = fopen(path, "rb");
+    if (in == NULL || !checkpoint_read_header(in, &header)) {
+        if (in != NULL) fclose(in);
+        return DSCHED_EIO;
+    }
+    const char *name = (options != NULL && options->policy != NULL) ? options->policy : header.policy;
+    const SchedPolicy *policy = policy_find(name);
+    DschedSim *s = policy != NULL ? (DschedSim *)malloc(sizeof(DschedSim)) : NULL;
+    if (s == NULL) {
+        fclose(in);
+        return policy == NULL ? DSCHED_EINVAL : DSCHED_ENOMEM;
+    }
+
+    SimOptions sim_options = {
+        .num_drones = header.num_drones,
+        .num_charging = header.num_charging,
+        .num_loading = header.num_loading,
+        .engine = ENGINE_DES,
+        .output = OUTPUT_NONE,
+        .deterministic = true,
+        .seed = header.seed,
+        .policy = policy,
+        .full_charge = (options != NULL && options->full_charge) || header.full_charge
+    };
+    dsched_init(s, &sim_options);
+    bool ok = checkpoint_restore(&s->des, &s->sim, &s->workload, in, &header, (int)header.virtual_time);
+    fclose(in);
+    if (!ok) {
+        destroy_simulation(&s->sim);
+        free_simulation(&s->sim);
+        free(s);
+        return DSCHED_EIO;
+    }
+    s->has_workload = header.has_workload;
+    s->started = true;
+    *out = s;
+    return DSCHED_OK;
+}
+
+void dsched_destroy(DschedSim *s) {
+    if (s == NULL) return;
+    event_log_set_sink(s->sim.log, NULL, NULL);
+    if (!s->started) {
+        destroy_simulation(&s->sim);
+    } else if (!s->finished) {
+        des_finish(&s->des, (int)s->sim.virtual_time);
+    }
+    free_simulation(&s->sim);
+    if (s->has_workload) workload_destroy(&s->workload);
+    free(s->events);
+    free(s);
+}
+
+/* Once the engine runs, new drones and tasks need a dispatch pass at the
+ * current time, as `--restore` gives the ones from `--config`. */
+static void dsched_added(DschedSim *s) {
+    if (s->started) des_notify(&s->des);
+}
+
+/* Reads a text config (DRONE, TASK, WAREHOUSE, CUSTOMER and CHARGER lines)
+ * into the run; at any time before dsched_finish(). */
+int dsched_load_config(DschedSim *s, const char *text, size_t len) {
+    if (s->finished) return DSCHED_ESTATE;
+    Scenario sc;
+    int line_num = 0;
+    bool stop = false;
+    scenario_init(&sc);
+    scenario_parse(&sc, text, len, true, &line_num, &stop);
+    scenario_populate(&sc, &s->sim, 0);
+    scenario_destroy(&sc);
+    dsched_added(s);
+    return DSCHED_OK;
+}
+
+/* Generated load in the `--workload` syntax; only before the run starts. */
+int dsched_set_workload(DschedSim *s, const char *spec) {
+    if (s->started || s->has_workload) return DSCHED_ESTATE;
+    WorkloadOptions opts;
+    if (!workload_parse(spec, &opts)) return DSCHED_EINVAL;
+    if (opts.seed == 0) opts.seed = s->sim.seed;
+    workload_init(&s->workload, &s->sim, &opts);
+    s->sim.workload = &s->workload;
+    s->has_workload = true;
+    return DSCHED_OK;
+}
+
+int dsched_add_drone(DschedSim *s, int speed, int battery) {
+    return dsched_add_drone_at(s, speed, battery, 0, 0);
+}
+
+int dsched_add_drone_at(DschedSim *s, int speed, int battery, double x, double y) {
+    if (s->finished) return DSCHED_ESTATE;
+    if (speed <= 0 || battery < 0 || battery > 100) return DSCHED_EINVAL;
+    int before = s->sim.num_drones;
+    add_drone_at(&s->sim, speed, battery, (Point){ x, y });
+    if (s->sim.num_drones == before) return DSCHED_ENOMEM;
+    dsched_added(s);
+    return DSCHED_OK;
+}
+
+/* Gives a location coordinates, so tasks between placed names are flown by
+ * distance and go to the nearest idle drone. */
+int dsched_place(DschedSim *s, const char *name, double x, double y) {
+    if (s->finished) return DSCHED_ESTATE;
+    if (name == NULL || name[0] == '\0') return DSCHED_EINVAL;
+    LocationId id = lt_intern(&s->sim.locations, name, strnlen(name, MAX_LOCATION_LEN - 1));
+    lt_place(&s->sim.locations, id, (Point){ x, y });
+    return DSCHED_OK;
+}
+
+int dsched_add_charger(DschedSim *s, double x, double y) {
+    if (s->finished) return DSCHED_ESTATE;
+    add_charger(&s->sim, (Point){ x, y });
+    return DSCHED_OK;
+}
+
+int dsched_add_task(DschedSim *s, const char *source, const char *dest, int priority, int est_time) {
+    if (s->finished) return DSCHED_ESTATE;
+    if (source == NULL || dest == NULL || source[0] == '\0' || dest[0] == '\0' ||
+        priority < 1 || priority > PQ_PRIORITY_LEVELS || est_time < 1) {
+        return DSCHED_EINVAL;
+    }
+    int before = s->sim.stats.total_tasks;
+    add_task(&s->sim, source, dest, priority, est_time);
+    if (s->sim.stats.total_tasks == before) return DSCHED_ENOMEM;
+    dsched_added(s);
+    return DSCHED_OK;
+}
+
+static void dsched_begin(DschedSim *s) {
+    if (s->started) return;
+    des_start(&s->des, &s->sim, 0);
+    s->started = true;
+}
+
+/* Handles every event due before `time` (in virtual seconds) and leaves
+ * the clock there; calls may alternate with adding drones and tasks. */
+int dsched_run_until(DschedSim *s, long long time) {
+    if (s->finished) return DSCHED_ESTATE;
+    if (time < s->sim.virtual_time) return DSCHED_EINVAL;
+    dsched_begin(s);
+    des_run_until(&s->des, time);
+    return DSCHED_OK;
+}
+
+/* Moves the clock to the next second anything happens in and handles all
+ * of it. Returns 1, or 0 when nothing is left to happen (the clock stays),
+ * which without a workload means the run has gone quiet for good. */
+int dsched_step(DschedSim *s) {
+    if (s->finished) return DSCHED_ESTATE;
+    dsched_begin(s);
+    const SimEvent *next = eq_peek(&s->des.queue);
+    if (next == NULL) return 0;
+
+    long long at = next->time > s->sim.virtual_time ? next->time : s->sim.virtual_time;
+    des_run_until(&s->des, at + 1);
+    s->sim.virtual_time = at;
+    return 1;
+}
+
+/* Ends the run at the current time: drones mid-phase are settled and the
+ * station time closed, as at the end of a `--duration`. Statistics and
+ * drones stay readable; nothing can be added or run any more. */
+int dsched_finish(DschedSim *s) {
+    if (s->finished) return DSCHED_ESTATE;
+    dsched_begin(s);
+    des_finish(&s->des, (int)s->sim.virtual_time);
+    s->finished = true;
+    return DSCHED_OK;
+}
+
+long long dsched_now(const DschedSim *s) {
+    return s->sim.virtual_time;
+}
+
+int dsched_save(DschedSim *s, const char *path) {
+    if (s->finished) return DSCHED_ESTATE;
+    dsched_begin(s);
+    FILE *out = fopen(path, "wb");
+    bool ok = out != NULL && checkpoint_write(&s->des, out);
+    if (out != NULL && fclose(out) != 0) ok = false;
+    return ok ? DSCHED_OK : DSCHED_EIO;
+}
+
+static double dsched_utilization(long long busy_us, int units, long long span_us) {
+    return (units > 0 && span_us > 0) ? busy_us / ((double)units * span_us) : 0;
+}
+
+int dsched_stats(DschedSim *s, DschedStats *out) {
+    Simulation *sim = &s->sim;
+    Histogram *h = (Histogram *)malloc(sizeof(Histogram));
+    if (h == NULL) return DSCHED_ENOMEM;
+
+    memset(out, 0, sizeof(*out));
+    out->time = sim->virtual_time;
+    out->total_tasks = sim->stats.total_tasks;
+    out->completed_tasks = sim->stats.completed_tasks;
+    out->queued_tasks = pq_size(&sim->task_queue);
+    out->preemptions = sim->stats.total_preemptions;
+    out->charging_station_uses = sim->stats.charging_station_uses;
+    out->loading_bay_uses = sim->stats.loading_bay_uses;
+    if (sim->stats.completed_tasks > 0) {
+        out->mean_delivery_seconds = sim->stats.total_delivery_time / sim->stats.completed_tasks;
+    }
+    phase_timers_merge(&sim->stats.phases, PHASE_QUEUE_WAIT, -1, h);
+    out->queue_wait_p50_us = hist_percentile(h, 50);
+    out->queue_wait_p99_us = hist_percentile(h, 99);
+    phase_timers_merge(&sim->stats.phases, PHASE_DELIVERY, -1, h);
+    out->completion_p50_us = hist_percentile(h, 50);
+    out->completion_p99_us = hist_percentile(h, 99);
+    free(h);
+
+    /* The pools only exist while the engine runs; a finished run keeps
+     * their settled totals in the statistics. */
+    if (s->finished) {
+        out->charging_utilization = dsched_utilization(sim->stats.charging_busy_us, sim->num_charging_stations,
+                                                       sim->stats.span_us);
+        out->loading_utilization = dsched_utilization(sim->stats.loading_busy_us, sim->num_loading_bays,
+                                                      sim->stats.span_us);
+    } else if (s->started) {
+        const DroneFsm *fsm = &s->des.fsm;
+        long long span = sim_clock_us(sim) - fsm->charging_stations.start;
+        out->charging_utilization = dsched_utilization(fsm_busy_us(fsm, &fsm->charging_stations),
+                                                       fsm->charging_stations.total, span);
+        out->loading_utilization = dsched_utilization(fsm_busy_us(fsm, &fsm->loading_bays),
+                                                      fsm->loading_bays.total, span);
+    }
+    out->events_processed = s->des.events_processed;
+    return DSCHED_OK;
+}
+
+int dsched_num_drones(const DschedSim *s) {
+    return s->sim.num_drones;
+}
+
+/* `index` counts from 0; drone ids in events count from 1. */
+int dsched_drone(DschedSim *s, int index, DschedDrone *out) {
+    if (index < 0 || index >= s->sim.num_drones) return DSCHED_EINVAL;
+    const Drone *drone = &s->sim.drones[index];
+    out->id = drone->drone_id;
+    out->state = (int)drone->state;
+    out->battery = (s->started && !s->finished) ? fsm_battery(&s->des.fsm, index) : drone->battery_level;
+    out->speed = drone->speed;
+    out->task = drone->current_task != NULL ? drone->current_task->task_id : 0;
+    out->tasks_completed = drone->tasks_completed;
+    out->preemptions = drone->preempted_count;
+    out->x = drone->position.x;
+    out->y = drone->position.y;
+    return DSCHED_OK;
+}
+
+/* Names the `source` and `destination` of an event; NULL for an unknown
+ * id. The string lives as long as the simulation. */
+const char *dsched_location_name(const DschedSim *s, int id) {
+    if (id < 0 || id >= lt_count(&s->sim.locations)) return NULL;
+    return lt_name(&s->sim.locations, (LocationId)id);
+}
+
+/* Calls `fn` for every event from now on, from inside the call that caused
+ * it; `fn` must not call back into the simulation. NULL turns it off. A
+ * callback takes precedence over buffering. */
+void dsched_on_event(DschedSim *s, DschedEventFn fn, void *ctx) {
+    s->on_event = fn;
+    s->event_ctx = ctx;
+    dsched_update_sink(s);
+}
+
+/* Keeps events from now on for dsched_poll_events(). The buffer grows as
+ * needed, so poll after each slice of a long run. */
+void dsched_buffer_events(DschedSim *s, int enable) {
+    s->buffering = enable != 0;
+    if (!s->buffering) {
+        s->events_read = 0;
+        s->events_count = 0;
+    }
+    dsched_update_sink(s);
+}
+
+/* Moves up to `max` buffered events, oldest first, into `out`; returns how
+ * many. */
+int dsched_poll_events(DschedSim *s, DschedEvent *out, int max) {
+    int available = s->events_count - s->events_read;
+    int count = available < max ? available : max;
+    if (count <= 0) return 0;
+    memcpy(out, s->events + s->events_read, sizeof(DschedEvent) * count);
+    s->events_read += count;
+    if (s->events_read == s->events_count) {
+        s->events_read = 0;
+        s->events_count = 0;
+    }
+    return count;
+}
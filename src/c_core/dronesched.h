@@ -0,0 +1,153 @@
+#ifndef DRONESCHED_H
+#define DRONESCHED_H
+
+/* Embedding API of libdronesched.so: a discrete-event simulation driven
+ * from the caller's thread, fed drones and tasks directly and read back as
+ * numbers, with no process or text in between. Only the declarations here
+ * are exported; the structs are versioned by DSCHED_API_VERSION and only
+ * ever grow at the end.
+ *
+ * A DschedSim belongs to one thread at a time. Separate simulations share
+ * nothing, so each thread may run its own. */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DSCHED_API_VERSION 1
+
+#if defined(__GNUC__)
+#define DSCHED_API __attribute__((visibility("default")))
+#else
+#define DSCHED_API
+#endif
+
+typedef struct DschedSim DschedSim;
+
+enum {
+    DSCHED_OK = 0,
+    DSCHED_EINVAL = -1,
+    DSCHED_ESTATE = -2,
+    DSCHED_EIO = -3,
+    DSCHED_ENOMEM = -4
+};
+
+/* Fill with dsched_options_init() before setting fields, so fields added
+ * later keep their defaults. A NULL `policy` is strict priority. */
+typedef struct {
+    int num_charging;
+    int num_loading;
+    unsigned long long seed;
+    const char *policy;
+    int full_charge;
+} DschedOptions;
+
+typedef enum {
+    DSCHED_EVENT_DRONE_ADDED = 1,
+    DSCHED_EVENT_TASK_ADDED,
+    DSCHED_EVENT_ASSIGNED,
+    DSCHED_EVENT_PREEMPTION,
+    DSCHED_EVENT_DISPATCH_BATCH,
+    DSCHED_EVENT_WAIT_BAY,
+    DSCHED_EVENT_LOADING,
+    DSCHED_EVENT_BAY_RELEASED,
+    DSCHED_EVENT_BATTERY_CRITICAL,
+    DSCHED_EVENT_TASK_COMPLETED,
+    DSCHED_EVENT_CHARGE_REQUEST,
+    DSCHED_EVENT_CHARGE_START,
+    DSCHED_EVENT_CHARGE_END,
+    DSCHED_EVENT_DELIVERY_START
+} DschedEventType;
+
+/* One event, with the fields of the matching `--output jsonl` object;
+ * unused ones are 0, or -1 for the locations. `value` is the speed
+ * (drone_added), est_time (task_added), count (dispatch_batch) or seconds
+ * (task_completed, delivery_start); `aux` is the task preempted for
+ * (preemption) or the drain rate (delivery_start). */
+typedef struct {
+    long long time;
+    int type;
+    int drone;
+    int task;
+    int priority;
+    int battery;
+    int value;
+    int aux;
+    int source;
+    int destination;
+} DschedEvent;
+
+typedef void (*DschedEventFn)(void *ctx, const DschedEvent *event);
+
+/* Counters as of dsched_now(). Utilization is station time in use over
+ * station time available since the run started. */
+typedef struct {
+    long long time;
+    int total_tasks;
+    int completed_tasks;
+    int queued_tasks;
+    int preemptions;
+    int charging_station_uses;
+    int loading_bay_uses;
+    double mean_delivery_seconds;
+    long long queue_wait_p50_us;
+    long long queue_wait_p99_us;
+    long long completion_p50_us;
+    long long completion_p99_us;
+    double charging_utilization;
+    double loading_utilization;
+    unsigned long long events_processed;
+} DschedStats;
+
+/* `state` is 0 idle, 1 loading, 2 delivering, 3 charging, 4 preempted. */
+typedef struct {
+    int id;
+    int state;
+    int battery;
+    int speed;
+    int task;
+    int tasks_completed;
+    int preemptions;
+    double x;
+    double y;
+} DschedDrone;
+
+DSCHED_API int dsched_api_version(void);
+DSCHED_API const char *dsched_strerror(int status);
+DSCHED_API const char *dsched_event_name(int type);
+
+DSCHED_API void dsched_options_init(DschedOptions *options);
+DSCHED_API int dsched_create(const DschedOptions *options, DschedSim **out);
+DSCHED_API int dsched_restore(const char *path, const DschedOptions *options, DschedSim **out);
+DSCHED_API void dsched_destroy(DschedSim *sim);
+
+DSCHED_API int dsched_load_config(DschedSim *sim, const char *text, size_t len);
+DSCHED_API int dsched_set_workload(DschedSim *sim, const char *spec);
+DSCHED_API int dsched_add_drone(DschedSim *sim, int speed, int battery);
+DSCHED_API int dsched_add_drone_at(DschedSim *sim, int speed, int battery, double x, double y);
+DSCHED_API int dsched_place(DschedSim *sim, const char *name, double x, double y);
+DSCHED_API int dsched_add_charger(DschedSim *sim, double x, double y);
+DSCHED_API int dsched_add_task(DschedSim *sim, const char *source, const char *dest, int priority, int est_time);
+
+DSCHED_API int dsched_run_until(DschedSim *sim, long long time);
+DSCHED_API int dsched_step(DschedSim *sim);
+DSCHED_API int dsched_finish(DschedSim *sim);
+DSCHED_API long long dsched_now(const DschedSim *sim);
+DSCHED_API int dsched_save(DschedSim *sim, const char *path);
+
+DSCHED_API int dsched_stats(DschedSim *sim, DschedStats *out);
+DSCHED_API int dsched_num_drones(const DschedSim *sim);
+DSCHED_API int dsched_drone(DschedSim *sim, int index, DschedDrone *out);
+DSCHED_API const char *dsched_location_name(const DschedSim *sim, int id);
+
+DSCHED_API void dsched_on_event(DschedSim *sim, DschedEventFn fn, void *ctx);
+DSCHED_API void dsched_buffer_events(DschedSim *sim, int enable);
+DSCHED_API int dsched_poll_events(DschedSim *sim, DschedEvent *out, int max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
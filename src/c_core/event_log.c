@@ -0,0 +1,533 @@
+#include "event_log.h"
+#include <sched.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static atomic_ulong next_log_id = 1;
+static __thread LogRing *thread_ring = NULL;
+static __thread unsigned long thread_ring_log = 0;
+
+/* Returns the calling thread's ring for `log`, registering one on first use.
+ * The id check keeps a thread from reusing a ring of an earlier log that
+ * happened to live at the same address. */
+static LogRing *event_log_ring(EventLog *log) {
+    if (thread_ring_log == log->id) return thread_ring;
+
+    LogRing *ring = (LogRing *)calloc(1, sizeof(LogRing));
+    pthread_mutex_lock(&log->rings_mutex);
+    ring->id = (unsigned short)log->num_rings++;
+    ring->next = log->rings;
+    log->rings = ring;
+    pthread_mutex_unlock(&log->rings_mutex);
+
+    thread_ring = ring;
+    thread_ring_log = log->id;
+    return ring;
+}
+
+static void event_log_wake(EventLog *log) {
+    pthread_mutex_lock(&log->mutex);
+    pthread_cond_signal(&log->wakeup);
+    pthread_mutex_unlock(&log->mutex);
+}
+
+/* Hot path: a copy into the thread's own ring and one release store. The
+ * drain thread is only signalled by the first record after it went idle. */
+void event_log_append(EventLog *log, const LogRecord *rec) {
+    if (log->sink != NULL) {
+        log->sink(log->sink_ctx, rec);
+        return;
+    }
+    if (log->format == NULL) return;
+    LogRing *ring = event_log_ring(log);
+    unsigned long head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    if (head - atomic_load_explicit(&ring->tail, memory_order_acquire) == LOG_RING_SIZE) {
+        /* Full: records are never dropped, so wait for the drain to catch up. */
+        atomic_fetch_add_explicit(&log->stalls, 1, memory_order_relaxed);
+        atomic_store(&log->pending, true);
+        event_log_wake(log);
+        while (head - atomic_load_explicit(&ring->tail, memory_order_acquire) == LOG_RING_SIZE) {
+            sched_yield();
+        }
+    }
+
+    LogRecord *slot = &ring->records[head & (LOG_RING_SIZE - 1)];
+    *slot = *rec;
+    slot->seq = ring->next_seq++;
+    slot->ring = ring->id;
+    atomic_store(&ring->head, head + 1);
+
+    if (!atomic_load(&log->pending) && !atomic_exchange(&log->pending, true)) {
+        event_log_wake(log);
+    }
+}
+
+static void event_log_emit(EventLog *log, const LogRecord *rec) {
+    log->format(log, rec);
+    if (rec->type == LOG_TEXT) free((void *)rec->ref);
+}
+
+/* Moves everything currently published out of the rings and formats it.
+ * Each ring's records stay in append order; across rings the earliest
+ * timestamp goes first. Returns the number of records written. */
+static int event_log_drain(EventLog *log) {
+    pthread_mutex_lock(&log->rings_mutex);
+    LogRing *rings = log->rings;
+    int num_rings = log->num_rings;
+    pthread_mutex_unlock(&log->rings_mutex);
+
+    if (num_rings > log->segments_capacity) {
+        log->segments = (int *)realloc(log->segments, sizeof(int) * 2 * num_rings);
+        log->segments_capacity = num_rings;
+    }
+
+    int count = 0;
+    int segments = 0;
+    for (LogRing *ring = rings; ring != NULL; ring = ring->next) {
+        unsigned long tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        unsigned long head = atomic_load(&ring->head);
+        int available = (int)(head - tail);
+        if (available == 0) continue;
+
+        if (count + available > log->batch_capacity) {
+            int new_capacity = log->batch_capacity > 0 ? log->batch_capacity : LOG_RING_SIZE;
+            while (new_capacity < count + available) new_capacity *= 2;
+            log->batch = (LogRecord *)realloc(log->batch, sizeof(LogRecord) * new_capacity);
+            log->batch_capacity = new_capacity;
+        }
+        log->segments[2 * segments] = count;
+        for (; tail != head; tail++) {
+            log->batch[count++] = ring->records[tail & (LOG_RING_SIZE - 1)];
+        }
+        log->segments[2 * segments + 1] = count;
+        segments++;
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+    if (count == 0) return 0;
+
+    while (true) {
+        int best = -1;
+        for (int i = 0; i < segments; i++) {
+            int *seg = &log->segments[2 * i];
+            if (seg[0] == seg[1]) continue;
+            if (best < 0 || log->batch[seg[0]].time_us < log->batch[log->segments[2 * best]].time_us) best = i;
+        }
+        if (best < 0) break;
+        event_log_emit(log, &log->batch[log->segments[2 * best]++]);
+    }
+    fflush(log->out);
+    log->written += count;
+    return count;
+}
+
+static void *event_log_thread(void *arg) {
+    EventLog *log = (EventLog *)arg;
+
+    pthread_mutex_lock(&log->mutex);
+    while (true) {
+        atomic_store(&log->pending, false);
+        pthread_mutex_unlock(&log->mutex);
+        int count = event_log_drain(log);
+        pthread_mutex_lock(&log->mutex);
+
+        if (count > 0) continue;
+        log->idle_passes++;
+        pthread_cond_broadcast(&log->drained);
+        if (!log->running) break;
+        if (!atomic_load(&log->pending)) {
+            pthread_cond_wait(&log->wakeup, &log->mutex);
+        }
+    }
+    pthread_mutex_unlock(&log->mutex);
+    return NULL;
+}
+
+void event_log_start(EventLog *log, FILE *out, SimOutput output, const LocationTable *locations) {
+    log->id = atomic_fetch_add(&next_log_id, 1);
+    log->rings = NULL;
+    log->num_rings = 0;
+    log->running = true;
+    log->idle_passes = 0;
+    log->written = 0;
+    atomic_init(&log->stalls, 0);
+    log->out = out;
+    log->locations = locations;
+    log->sink = NULL;
+    log->sink_ctx = NULL;
+    log->format = (output == OUTPUT_JSONL) ? event_log_format_jsonl :
+                  (output == OUTPUT_BINARY) ? event_log_format_binary :
+                  (output == OUTPUT_NONE) ? NULL : event_log_format_text;
+    if (output == OUTPUT_BINARY) {
+        uint32_t record_size = sizeof(BinaryLogRecord);
+        fwrite(LOG_BINARY_MAGIC, 1, sizeof(LOG_BINARY_MAGIC), out);
+        fwrite(&record_size, sizeof(record_size), 1, out);
+    }
+    log->batch = NULL;
+    log->batch_capacity = 0;
+    log->segments = NULL;
+    log->segments_capacity = 0;
+    atomic_init(&log->pending, false);
+    pthread_mutex_init(&log->rings_mutex, NULL);
+    pthread_mutex_init(&log->mutex, NULL);
+    pthread_cond_init(&log->wakeup, NULL);
+    pthread_cond_init(&log->drained, NULL);
+    /* A silent log has no drain thread; appends return straight away. */
+    if (log->format == NULL) {
+        log->running = false;
+        return;
+    }
+    pthread_create(&log->drain_thread, NULL, event_log_thread, log);
+}
+
+/* Hands records to `sink` as they are appended, synchronously and on the
+ * appending thread, for a single-threaded embedder that wants them as data
+ * (see dronesched.c). Only for a log started with OUTPUT_NONE: there is no
+ * drain to race with, and no LOG_TEXT is ever built. NULL stops it. */
+void event_log_set_sink(EventLog *log, void (*sink)(void *ctx, const LogRecord *rec), void *ctx) {
+    log->sink = sink;
+    log->sink_ctx = ctx;
+}
+
+/* Blocks until every record appended before the call has been written. A
+ * pass already under way may have missed them, so wait for two empty ones. */
+void event_log_flush(EventLog *log) {
+    pthread_mutex_lock(&log->mutex);
+    unsigned long long target = log->idle_passes + 2;
+    while (log->running && log->idle_passes < target) {
+        atomic_store(&log->pending, true);
+        pthread_cond_signal(&log->wakeup);
+        pthread_cond_wait(&log->drained, &log->mutex);
+    }
+    pthread_mutex_unlock(&log->mutex);
+}
+
+void event_log_stop(EventLog *log) {
+    if (log->format != NULL) {
+        pthread_mutex_lock(&log->mutex);
+        log->running = false;
+        pthread_cond_signal(&log->wakeup);
+        pthread_mutex_unlock(&log->mutex);
+        pthread_join(log->drain_thread, NULL);
+    }
+
+    LogRing *ring = log->rings;
+    while (ring != NULL) {
+        LogRing *next = ring->next;
+        free(ring);
+        ring = next;
+    }
+    log->rings = NULL;
+    free(log->batch);
+    log->batch = NULL;
+    free(log->segments);
+    log->segments = NULL;
+    pthread_cond_destroy(&log->wakeup);
+    pthread_cond_destroy(&log->drained);
+    pthread_mutex_destroy(&log->mutex);
+    pthread_mutex_destroy(&log->rings_mutex);
+}
+
+static const char *priority_color(int priority) {
+    return (priority == 1) ? ANSI_COLOR_RED :
+           (priority == 2) ? ANSI_COLOR_YELLOW : ANSI_COLOR_GREEN;
+}
+
+/* Only drain threads format, each for its own log, so a per-thread
+ * timestamp cache needs no lock even with several simulations running. */
+static void format_timestamp(FILE *out, const LogRecord *rec) {
+    static __thread long long cached_second = -1;
+    static __thread char cached[32];
+
+    long long second = rec->time_us / 1000000LL;
+    if (second != cached_second || (rec->flags & LOG_VIRTUAL_TIME)) {
+        if (rec->flags & LOG_VIRTUAL_TIME) {
+            snprintf(cached, sizeof(cached), "[%02lld:%02lld:%02lld] ", second / 3600, (second / 60) % 60, second % 60);
+        } else {
+            time_t now = (time_t)second;
+            struct tm t;
+            localtime_r(&now, &t);
+            snprintf(cached, sizeof(cached), "[%02d:%02d:%02d] ", t.tm_hour, t.tm_min, t.tm_sec);
+        }
+        cached_second = (rec->flags & LOG_VIRTUAL_TIME) ? -1 : second;
+    }
+    fputs(cached, out);
+}
+
+/* The original human-readable output: a wall-clock or virtual timestamp and
+ * one ANSI-colored line per event. */
+void event_log_format_text(const EventLog *log, const LogRecord *rec) {
+    FILE *out = log->out;
+    if (rec->type == LOG_BLANK) {
+        fputc('\n', out);
+        return;
+    }
+    if (rec->type == LOG_DELIVERY_START) return;
+
+    format_timestamp(out, rec);
+    const Task *task = (const Task *)rec->ref;
+
+    switch ((LogEventType)rec->type) {
+        case LOG_TEXT:
+            fputs((const char *)rec->ref, out);
+            break;
+        case LOG_BLANK:
+            break;
+        case LOG_DRONE_ADDED:
+            fprintf(out, ANSI_COLOR_GREEN "[Setup] Added Drone %d (Speed: %d, Battery: %d%%)" ANSI_COLOR_RESET,
+                    rec->drone_id, rec->value, rec->battery);
+            break;
+        case LOG_TASK_ADDED:
+            fprintf(out, "%s[Setup] Added task T%d: %s → %s (Priority: %d, Est. Time: %ds)" ANSI_COLOR_RESET,
+                    priority_color(rec->priority), rec->task_id, lt_name(log->locations, task->source),
+                    lt_name(log->locations, task->destination), rec->priority, rec->value);
+            break;
+        case LOG_ASSIGNED:
+            fprintf(out, "%s[Scheduler] Assigned task T%d (Priority %d) to Drone %d" ANSI_COLOR_RESET,
+                    priority_color(rec->priority), rec->task_id, rec->priority, rec->drone_id);
+            break;
+        case LOG_PREEMPTION:
+            fprintf(out, ANSI_COLOR_RED "[Scheduler] ⚠ PREEMPTION: Interrupting Drone %d (Task T%d, Priority %d) for urgent task T%d" ANSI_COLOR_RESET,
+                    rec->drone_id, rec->task_id, rec->priority, rec->aux);
+            break;
+        case LOG_DISPATCH_BATCH:
+            fprintf(out, ANSI_COLOR_MAGENTA "[Scheduler] Dispatched %d tasks in one pass" ANSI_COLOR_RESET, rec->value);
+            break;
+        case LOG_WAIT_BAY:
+            fprintf(out, ANSI_COLOR_BLUE "[Drone %d] Waiting for loading bay..." ANSI_COLOR_RESET, rec->drone_id);
+            break;
+        case LOG_LOADING:
+            fprintf(out, "%s[Drone %d] Acquired loading bay - Loading task T%d (Priority %d: %s -> %s)" ANSI_COLOR_RESET,
+                    priority_color(rec->priority), rec->drone_id, rec->task_id, rec->priority,
+                    lt_name(log->locations, task->source), lt_name(log->locations, task->destination));
+            break;
+        case LOG_BAY_RELEASED:
+            fprintf(out, "[Drone %d] Released loading bay", rec->drone_id);
+            break;
+        case LOG_BATTERY_CRITICAL:
+            fprintf(out, ANSI_COLOR_YELLOW "[Drone %d] Battery critical (%d%%), must charge!" ANSI_COLOR_RESET,
+                    rec->drone_id, rec->battery);
+            break;
+        case LOG_TASK_COMPLETED:
+            fprintf(out, ANSI_COLOR_GREEN "[Drone %d] ✓ Completed task T%d (%d seconds, Battery: %d%%)" ANSI_COLOR_RESET,
+                    rec->drone_id, rec->task_id, rec->value, rec->battery);
+            break;
+        case LOG_CHARGE_REQUEST:
+            fprintf(out, "[Drone %d] Requesting charging station...", rec->drone_id);
+            break;
+        case LOG_CHARGE_START:
+            fprintf(out, ANSI_COLOR_YELLOW "[Drone %d] Acquired charging station (Battery: %d%%)" ANSI_COLOR_RESET,
+                    rec->drone_id, rec->battery);
+            break;
+        case LOG_CHARGE_END:
+            if (rec->battery >= 100) {
+                fprintf(out, ANSI_COLOR_GREEN "[Drone %d] Fully charged (100%%), releasing charging station" ANSI_COLOR_RESET,
+                        rec->drone_id);
+            } else {
+                fprintf(out, ANSI_COLOR_GREEN "[Drone %d] Charged to %d%% for queued work, releasing charging station" ANSI_COLOR_RESET,
+                        rec->drone_id, rec->battery);
+            }
+            break;
+        case LOG_DELIVERY_START:
+            break;
+    }
+    fputc('\n', out);
+}
+
+static const char *const event_names[] = {
+    [LOG_TEXT] = "text",
+    [LOG_BLANK] = "blank",
+    [LOG_DRONE_ADDED] = "drone_added",
+    [LOG_TASK_ADDED] = "task_added",
+    [LOG_ASSIGNED] = "assigned",
+    [LOG_PREEMPTION] = "preemption",
+    [LOG_DISPATCH_BATCH] = "dispatch_batch",
+    [LOG_WAIT_BAY] = "wait_bay",
+    [LOG_LOADING] = "loading",
+    [LOG_BAY_RELEASED] = "bay_released",
+    [LOG_BATTERY_CRITICAL] = "battery_critical",
+    [LOG_TASK_COMPLETED] = "task_completed",
+    [LOG_CHARGE_REQUEST] = "charge_request",
+    [LOG_CHARGE_START] = "charge_start",
+    [LOG_CHARGE_END] = "charge_end",
+    [LOG_DELIVERY_START] = "delivery_start"
+};
+
+/* Writes `s` as a JSON string, dropping ANSI color sequences. */
+static void json_string(FILE *out, const char *s) {
+    fputc('"', out);
+    for (const unsigned char *p = (const unsigned char *)s; *p; p++) {
+        if (*p == 0x1b && p[1] == '[') {
+            p += 2;
+            while (*p && *p != 'm') p++;
+            if (!*p) break;
+            continue;
+        }
+        switch (*p) {
+            case '"': fputs("\\\"", out); break;
+            case '\\': fputs("\\\\", out); break;
+            case '\n': fputs("\\n", out); break;
+            case '\t': fputs("\\t", out); break;
+            default:
+                if (*p < 0x20) fprintf(out, "\\u%04x", *p);
+                else fputc(*p, out);
+        }
+    }
+    fputc('"', out);
+}
+
+/* One JSON object per line with the fields the event type carries, so a
+ * consumer can track fleet state without parsing the text messages. */
+void event_log_format_jsonl(const EventLog *log, const LogRecord *rec) {
+    FILE *out = log->out;
+    if (rec->type == LOG_BLANK) return;
+
+    const Task *task = (const Task *)rec->ref;
+    fprintf(out, "{\"time\":%lld.%03lld,\"clock\":\"%s\",\"event\":\"%s\"",
+            rec->time_us / 1000000LL, (rec->time_us / 1000LL) % 1000,
+            (rec->flags & LOG_VIRTUAL_TIME) ? "virtual" : "wall", event_names[rec->type]);
+
+    switch ((LogEventType)rec->type) {
+        case LOG_TEXT:
+            fputs(",\"message\":", out);
+            json_string(out, (const char *)rec->ref);
+            break;
+        case LOG_BLANK:
+            break;
+        case LOG_DRONE_ADDED:
+            fprintf(out, ",\"drone\":%d,\"speed\":%d,\"battery\":%d", rec->drone_id, rec->value, rec->battery);
+            break;
+        case LOG_TASK_ADDED:
+            fprintf(out, ",\"task\":%d,\"priority\":%d,\"est_time\":%d,\"source\":",
+                    rec->task_id, rec->priority, rec->value);
+            json_string(out, lt_name(log->locations, task->source));
+            fputs(",\"destination\":", out);
+            json_string(out, lt_name(log->locations, task->destination));
+            if (task->located) {
+                Point pickup, dropoff;
+                lt_position(log->locations, task->source, &pickup);
+                lt_position(log->locations, task->destination, &dropoff);
+                fprintf(out, ",\"pickup\":[%.1f,%.1f],\"dropoff\":[%.1f,%.1f]",
+                        pickup.x, pickup.y, dropoff.x, dropoff.y);
+            }
+            break;
+        case LOG_PREEMPTION:
+            fprintf(out, ",\"drone\":%d,\"task\":%d,\"priority\":%d,\"for_task\":%d",
+                    rec->drone_id, rec->task_id, rec->priority, rec->aux);
+            break;
+        case LOG_DISPATCH_BATCH:
+            fprintf(out, ",\"count\":%d", rec->value);
+            break;
+        case LOG_LOADING:
+            fprintf(out, ",\"drone\":%d,\"task\":%d,\"priority\":%d,\"source\":",
+                    rec->drone_id, rec->task_id, rec->priority);
+            json_string(out, lt_name(log->locations, task->source));
+            fputs(",\"destination\":", out);
+            json_string(out, lt_name(log->locations, task->destination));
+            break;
+        case LOG_ASSIGNED:
+            fprintf(out, ",\"drone\":%d,\"task\":%d,\"priority\":%d", rec->drone_id, rec->task_id, rec->priority);
+            break;
+        case LOG_TASK_COMPLETED:
+            fprintf(out, ",\"drone\":%d,\"task\":%d,\"priority\":%d,\"battery\":%d,\"seconds\":%d",
+                    rec->drone_id, rec->task_id, rec->priority, rec->battery, rec->value);
+            break;
+        case LOG_DELIVERY_START:
+            fprintf(out, ",\"drone\":%d,\"task\":%d,\"priority\":%d,\"battery\":%d,\"seconds\":%d,\"drain_rate\":%d",
+                    rec->drone_id, rec->task_id, rec->priority, rec->battery, rec->value, rec->aux);
+            break;
+        case LOG_BATTERY_CRITICAL:
+        case LOG_CHARGE_START:
+        case LOG_CHARGE_END:
+            fprintf(out, ",\"drone\":%d,\"battery\":%d", rec->drone_id, rec->battery);
+            break;
+        case LOG_WAIT_BAY:
+        case LOG_BAY_RELEASED:
+        case LOG_CHARGE_REQUEST:
+            fprintf(out, ",\"drone\":%d", rec->drone_id);
+            break;
+    }
+    fputs("}\n", out);
+}
+
+/* Fixed records for consumers that would rather not parse JSON at all. */
+void event_log_format_binary(const EventLog *log, const LogRecord *rec) {
+    FILE *out = log->out;
+    BinaryLogRecord bin = {
+        .time_us = rec->time_us,
+        .type = rec->type,
+        .flags = rec->flags,
+        .drone_id = rec->drone_id,
+        .task_id = rec->task_id,
+        .priority = rec->priority,
+        .battery = rec->battery,
+        .value = rec->value,
+        .aux = rec->aux
+    };
+    const Task *task = (const Task *)rec->ref;
+    const char *source = NULL, *destination = NULL;
+    size_t source_len = 0, dest_len = 0;
+
+    if (rec->type == LOG_TEXT) {
+        source_len = strlen((const char *)rec->ref);
+        bin.payload_len = (uint16_t)(source_len < UINT16_MAX ? source_len : UINT16_MAX);
+    } else if (rec->type == LOG_TASK_ADDED || rec->type == LOG_LOADING) {
+        source = lt_name(log->locations, task->source);
+        destination = lt_name(log->locations, task->destination);
+        source_len = strlen(source);
+        dest_len = strlen(destination);
+        bin.payload_len = (uint16_t)(source_len + 1 + dest_len);
+    }
+
+    fwrite(&bin, sizeof(bin), 1, out);
+    if (rec->type == LOG_TEXT) {
+        fwrite(rec->ref, 1, bin.payload_len, out);
+    } else if (bin.payload_len > 0) {
+        fwrite(source, 1, source_len + 1, out);
+        fwrite(destination, 1, dest_len, out);
+    }
+}
+
+static void log_stamp(Simulation *sim, LogRecord *rec) {
+    if (sim->engine == ENGINE_DES) {
+        rec->time_us = sim->virtual_time * 1000000LL;
+        rec->flags = LOG_VIRTUAL_TIME;
+    } else {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        rec->time_us = ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+        rec->flags = 0;
+    }
+}
+
+void log_record(Simulation *sim, const LogRecord *rec) {
+    LogRecord stamped = *rec;
+    log_stamp(sim, &stamped);
+    event_log_append(sim->log, &stamped);
+}
+
+void log_blank(Simulation *sim) {
+    LogRecord rec = { .type = LOG_BLANK };
+    log_record(sim, &rec);
+}
+
+/* Free-form text for setup, banners and statistics. Formats on the calling
+ * thread, so keep it off the per-event path. */
+void log_event(Simulation *sim, const char *format, ...) {
+    if (sim->log->format == NULL) return;
+    va_list args;
+    va_start(args, format);
+    va_list copy;
+    va_copy(copy, args);
+    int len = vsnprintf(NULL, 0, format, copy);
+    va_end(copy);
+
+    char *message = (char *)malloc(len + 1);
+    vsnprintf(message, len + 1, format, args);
+    va_end(args);
+
+    LogRecord rec = { .type = LOG_TEXT, .ref = message };
+    log_record(sim, &rec);
+}
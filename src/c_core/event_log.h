@@ -0,0 +1,124 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "drone_scheduler.h"
+
+#define LOG_RING_SIZE 8192
+
+typedef enum {
+    LOG_TEXT,
+    LOG_BLANK,
+    LOG_DRONE_ADDED,
+    LOG_TASK_ADDED,
+    LOG_ASSIGNED,
+    LOG_PREEMPTION,
+    LOG_DISPATCH_BATCH,
+    LOG_WAIT_BAY,
+    LOG_LOADING,
+    LOG_BAY_RELEASED,
+    LOG_BATTERY_CRITICAL,
+    LOG_TASK_COMPLETED,
+    LOG_CHARGE_REQUEST,
+    LOG_CHARGE_START,
+    LOG_CHARGE_END,
+    LOG_DELIVERY_START
+} LogEventType;
+
+#define LOG_VIRTUAL_TIME 0x1
+
+/* Fixed-size binary event. Producers fill in only the fields their type
+ * uses; `ref` is the Task for LOG_TASK_ADDED/LOG_LOADING (its location ids
+ * are looked up in the log's LocationTable at format time) or the owned
+ * message of a LOG_TEXT. */
+typedef struct {
+    long long time_us;
+    unsigned int seq;
+    unsigned char type;
+    unsigned char flags;
+    unsigned short ring;
+    int drone_id;
+    int task_id;
+    int priority;
+    int battery;
+    int value;
+    int aux;
+    const void *ref;
+} LogRecord;
+
+#define LOG_BINARY_MAGIC "DRNLOG1"
+
+/* On-disk form of one record for --output binary: fixed little-endian
+ * fields, then `payload_len` bytes (a LOG_TEXT message, or the task's
+ * source and destination separated by a NUL). The stream opens with the
+ * 8-byte magic followed by a uint32 sizeof(BinaryLogRecord). */
+typedef struct __attribute__((packed)) {
+    int64_t time_us;
+    uint8_t type;
+    uint8_t flags;
+    uint16_t payload_len;
+    int32_t drone_id;
+    int32_t task_id;
+    int32_t priority;
+    int32_t battery;
+    int32_t value;
+    int32_t aux;
+} BinaryLogRecord;
+
+/* Single-producer single-consumer ring owned by one thread. */
+typedef struct LogRing {
+    _Atomic unsigned long head;
+    char pad[CACHE_LINE_SIZE];
+    _Atomic unsigned long tail;
+    unsigned int next_seq;
+    unsigned short id;
+    struct LogRing *next;
+    LogRecord records[LOG_RING_SIZE];
+} LogRing;
+
+/* Threads append to their own ring without locking; a background thread
+ * merges the rings by timestamp and hands each record to the formatter.
+ * `pending` makes only the first record after a drain wake the thread.
+ * A `sink` takes every record instead, on the appending thread. */
+typedef struct EventLog {
+    unsigned long id;
+    LogRing *rings;
+    int num_rings;
+    pthread_mutex_t rings_mutex;
+    pthread_t drain_thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t wakeup;
+    pthread_cond_t drained;
+    atomic_bool pending;
+    bool running;
+    unsigned long long idle_passes;
+    unsigned long long written;
+    atomic_ullong stalls;
+    FILE *out;
+    const LocationTable *locations;
+    void (*format)(const struct EventLog *log, const LogRecord *rec);
+    void (*sink)(void *ctx, const LogRecord *rec);
+    void *sink_ctx;
+    LogRecord *batch;
+    int batch_capacity;
+    int *segments;
+    int segments_capacity;
+} EventLog;
+
+void event_log_start(EventLog *log, FILE *out, SimOutput output, const LocationTable *locations);
+void event_log_set_sink(EventLog *log, void (*sink)(void *ctx, const LogRecord *rec), void *ctx);
+void event_log_append(EventLog *log, const LogRecord *rec);
+void event_log_flush(EventLog *log);
+void event_log_stop(EventLog *log);
+void event_log_format_text(const EventLog *log, const LogRecord *rec);
+void event_log_format_jsonl(const EventLog *log, const LogRecord *rec);
+void event_log_format_binary(const EventLog *log, const LogRecord *rec);
+
+void log_record(Simulation *sim, const LogRecord *rec);
+void log_blank(Simulation *sim);
+
+#endif
@@ -0,0 +1,92 @@
+#include "event_queue.h"
+#include <stdlib.h>
+#include <string.h>
+
+void eq_init(EventQueue *q) {
+    q->size = 0;
+    q->capacity = 64;
+    q->next_seq = 0;
+    q->tie_seed = 0;
+    q->events = (SimEvent *)malloc(sizeof(SimEvent) * q->capacity);
+}
+
+void eq_seed(EventQueue *q, unsigned long long seed) {
+    q->tie_seed = seed;
+}
+
+/* splitmix64 finalizer: a cheap bijective mix, so distinct seqs never tie. */
+static unsigned long long eq_mix(unsigned long long x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+static bool eq_before(const SimEvent *a, const SimEvent *b) {
+    if (a->time != b->time) return a->time < b->time;
+    if (a->tie != b->tie) return a->tie < b->tie;
+    return a->seq < b->seq;
+}
+
+void eq_push(EventQueue *q, long long time, SimEventType type, int drone, unsigned int generation) {
+    if (q->size == q->capacity) {
+        q->capacity *= 2;
+        q->events = (SimEvent *)realloc(q->events, sizeof(SimEvent) * q->capacity);
+    }
+
+    unsigned long long seq = q->next_seq++;
+    unsigned long long tie = q->tie_seed ? eq_mix(seq ^ eq_mix(q->tie_seed)) : 0;
+    SimEvent ev = { time, tie, seq, type, drone, generation };
+    int i = q->size++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!eq_before(&ev, &q->events[parent])) break;
+        q->events[i] = q->events[parent];
+        i = parent;
+    }
+    q->events[i] = ev;
+}
+
+bool eq_pop(EventQueue *q, SimEvent *out) {
+    if (q->size == 0) return false;
+
+    *out = q->events[0];
+    SimEvent last = q->events[--q->size];
+    int i = 0;
+    while (true) {
+        int child = 2 * i + 1;
+        if (child >= q->size) break;
+        if (child + 1 < q->size && eq_before(&q->events[child + 1], &q->events[child])) {
+            child++;
+        }
+        if (!eq_before(&q->events[child], &last)) break;
+        q->events[i] = q->events[child];
+        i = child;
+    }
+    if (q->size > 0) q->events[i] = last;
+    return true;
+}
+
+const SimEvent *eq_peek(const EventQueue *q) {
+    return q->size > 0 ? &q->events[0] : NULL;
+}
+
+/* Refills an empty queue with another queue's heap array, copied in array
+ * order so it is still a heap, and carries on its sequence numbers. The
+ * saved events keep their tie values; `tie_seed` only affects new ones. */
+void eq_restore(EventQueue *q, const SimEvent *events, int count, unsigned long long next_seq) {
+    if (count > q->capacity) {
+        q->capacity = count;
+        q->events = (SimEvent *)realloc(q->events, sizeof(SimEvent) * q->capacity);
+    }
+    memcpy(q->events, events, sizeof(SimEvent) * count);
+    q->size = count;
+    q->next_seq = next_seq;
+}
+
+void eq_destroy(EventQueue *q) {
+    free(q->events);
+    q->events = NULL;
+    q->size = 0;
+    q->capacity = 0;
+}
@@ -0,0 +1,44 @@
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <stdbool.h>
+
+typedef enum {
+    EV_SCHEDULER_TICK,
+    EV_ASSIGNMENT,
+    EV_LOAD_COMPLETE,
+    EV_DELIVERY_END,
+    EV_CHARGE_COMPLETE,
+    EV_TASK_ARRIVAL
+} SimEventType;
+
+typedef struct {
+    long long time;
+    unsigned long long tie;
+    unsigned long long seq;
+    SimEventType type;
+    int drone;
+    unsigned int generation;
+} SimEvent;
+
+/* Min-heap of events ordered by (time, tie, seq). Unseeded, `tie` is zero
+ * and seq preserves insertion order among events due at the same instant;
+ * a seed turns `tie` into a hash of seq, which picks one reproducible
+ * interleaving of simultaneous events per seed. Not thread-safe. */
+typedef struct {
+    SimEvent *events;
+    int size;
+    int capacity;
+    unsigned long long next_seq;
+    unsigned long long tie_seed;
+} EventQueue;
+
+void eq_init(EventQueue *q);
+void eq_seed(EventQueue *q, unsigned long long seed);
+void eq_push(EventQueue *q, long long time, SimEventType type, int drone, unsigned int generation);
+bool eq_pop(EventQueue *q, SimEvent *out);
+const SimEvent *eq_peek(const EventQueue *q);
+void eq_restore(EventQueue *q, const SimEvent *events, int count, unsigned long long next_seq);
+void eq_destroy(EventQueue *q);
+
+#endif
@@ -0,0 +1,122 @@
+#include "fleet_soa.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* A tick this long drains or fills any drone completely, so longer ones
+ * give the same result and the per-tick delta stays well inside int16. */
+#define FLEET_MAX_TICK_SECONDS 100
+
+static int fleet_padded(int count) {
+    return FLEET_MASK_WORDS(count) * 64;
+}
+
+void fleet_soa_init(FleetSoA *fleet, int capacity) {
+    fleet->capacity = fleet_padded(capacity > 0 ? capacity : 1);
+    fleet->count = 0;
+    fleet->state = (uint8_t *)calloc(fleet->capacity, sizeof(uint8_t));
+    fleet->battery = (int16_t *)calloc(fleet->capacity, sizeof(int16_t));
+    fleet->active = (uint8_t *)calloc(fleet->capacity, sizeof(uint8_t));
+}
+
+void fleet_soa_destroy(FleetSoA *fleet) {
+    free(fleet->state);
+    free(fleet->battery);
+    free(fleet->active);
+    fleet->state = NULL;
+    fleet->battery = NULL;
+    fleet->active = NULL;
+    fleet->count = 0;
+    fleet->capacity = 0;
+}
+
+/* Copies the hot fields of `drones` in; padding slots are inactive idle
+ * drones, which the tick leaves alone and never flags. */
+void fleet_soa_load(FleetSoA *fleet, const Drone *drones, int count) {
+    if (fleet_padded(count) > fleet->capacity) {
+        fleet_soa_destroy(fleet);
+        fleet_soa_init(fleet, count);
+    }
+    for (int i = 0; i < count; i++) {
+        fleet->state[i] = (uint8_t)drones[i].state;
+        fleet->battery[i] = (int16_t)drones[i].battery_level;
+        fleet->active[i] = drones[i].active;
+    }
+    int padded = fleet_padded(count);
+    memset(fleet->state + count, DRONE_IDLE, padded - count);
+    memset(fleet->battery + count, 0, sizeof(int16_t) * (padded - count));
+    memset(fleet->active + count, 0, padded - count);
+    fleet->count = count;
+}
+
+/* Writes the battery levels back; the tick never changes a state. */
+void fleet_soa_store(const FleetSoA *fleet, Drone *drones) {
+    for (int i = 0; i < fleet->count; i++) {
+        drones[i].battery_level = fleet->battery[i];
+    }
+}
+
+/* Advances every drone by `seconds`: delivering drones drain, charging
+ * drones charge, both saturating at 0 and 100. Bit i of `low_mask` (one
+ * word per 64 drones) is set when drone i is active, not on a charger and
+ * at or under BATTERY_LOW_THRESHOLD afterwards; returns how many are.
+ * The inner loop is branch-free over fixed 64-drone blocks so it
+ * vectorizes; the Makefile builds this file with -O3 for that. */
+int fleet_soa_tick(FleetSoA *fleet, int seconds, uint64_t *low_mask) {
+    if (seconds > FLEET_MAX_TICK_SECONDS) seconds = FLEET_MAX_TICK_SECONDS;
+    const int16_t drain = (int16_t)(seconds * BATTERY_DRAIN_RATE);
+    const int16_t charge = (int16_t)(seconds * BATTERY_CHARGE_RATE);
+    int low = 0;
+
+    for (int base = 0; base < fleet->count; base += 64) {
+        const uint8_t *restrict state = fleet->state + base;
+        const uint8_t *restrict active = fleet->active + base;
+        int16_t *restrict battery = fleet->battery + base;
+        uint8_t flag[64];
+
+        for (int j = 0; j < 64; j++) {
+            int16_t delta = (int16_t)((state[j] == DRONE_CHARGING ? charge : 0) -
+                                      (state[j] == DRONE_DELIVERING ? drain : 0));
+            int16_t level = (int16_t)(battery[j] + delta);
+            level = level < 0 ? 0 : level;
+            level = level > 100 ? 100 : level;
+            battery[j] = level;
+            flag[j] = (uint8_t)(active[j] & (level <= BATTERY_LOW_THRESHOLD) & (state[j] != DRONE_CHARGING));
+        }
+
+        /* Packs eight 0/1 bytes at a time: on a little-endian load the
+         * multiply moves byte k's bit to bit 56 + k, so the top byte holds
+         * all eight in order. */
+        uint64_t word = 0;
+        for (int j = 0; j < 8; j++) {
+            uint64_t bytes;
+            memcpy(&bytes, flag + 8 * j, sizeof(bytes));
+            word |= ((bytes * 0x0102040810204080ULL) >> 56) << (8 * j);
+        }
+        low_mask[base / 64] = word;
+        low += __builtin_popcountll(word);
+    }
+    return low;
+}
+
+/* The same tick one `Drone` record at a time, as each drone thread used
+ * to apply it to itself; the reference for fleet_soa_tick. */
+int fleet_tick_drones(Drone *drones, int count, int seconds, uint64_t *low_mask) {
+    int low = 0;
+    memset(low_mask, 0, sizeof(uint64_t) * FLEET_MASK_WORDS(count));
+
+    for (int i = 0; i < count; i++) {
+        Drone *drone = &drones[i];
+        if (drone->state == DRONE_DELIVERING) {
+            drone->battery_level -= seconds * BATTERY_DRAIN_RATE;
+            if (drone->battery_level < 0) drone->battery_level = 0;
+        } else if (drone->state == DRONE_CHARGING) {
+            drone->battery_level += seconds * BATTERY_CHARGE_RATE;
+            if (drone->battery_level > 100) drone->battery_level = 100;
+        }
+        if (drone->active && drone->state != DRONE_CHARGING && drone->battery_level <= BATTERY_LOW_THRESHOLD) {
+            low_mask[i / 64] |= 1ULL << (i % 64);
+            low++;
+        }
+    }
+    return low;
+}
@@ -0,0 +1,29 @@
+#ifndef FLEET_SOA_H
+#define FLEET_SOA_H
+
+#include <stdint.h>
+#include "drone_scheduler.h"
+
+#define FLEET_MASK_WORDS(n) (((n) + 63) / 64)
+
+/* The fleet's per-second fields as parallel arrays, one byte or two per
+ * drone instead of a whole `Drone` record, so a pass over the fleet reads
+ * only what it uses and the compiler can process 16 or 32 drones per
+ * instruction. `count` drones are valid; the arrays are padded to a
+ * multiple of 64 so the tick can work in whole mask words. */
+typedef struct {
+    uint8_t *state;
+    int16_t *battery;
+    uint8_t *active;
+    int count;
+    int capacity;
+} FleetSoA;
+
+void fleet_soa_init(FleetSoA *fleet, int capacity);
+void fleet_soa_destroy(FleetSoA *fleet);
+void fleet_soa_load(FleetSoA *fleet, const Drone *drones, int count);
+void fleet_soa_store(const FleetSoA *fleet, Drone *drones);
+int fleet_soa_tick(FleetSoA *fleet, int seconds, uint64_t *low_mask);
+int fleet_tick_drones(Drone *drones, int count, int seconds, uint64_t *low_mask);
+
+#endif
@@ -0,0 +1,125 @@
+#include "histogram.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+static atomic_ulong next_timers_id = 1;
+static __thread PhaseSet *thread_set = NULL;
+static __thread unsigned long thread_set_timers = 0;
+
+static int hist_index(long long value) {
+    uint64_t v = value < 0 ? 0 : (uint64_t)value;
+    if (v >> HIST_MAX_BITS) return HIST_BUCKETS - 1;
+    if (v < 2 * HIST_HALF) return (int)v;
+    int shift = 63 - __builtin_clzll(v) - (HIST_SUB_BITS - 1);
+    return shift * HIST_HALF + (int)(v >> shift);
+}
+
+/* Largest value that falls in bucket `index`. */
+static long long hist_bucket_top(int index) {
+    if (index < 2 * HIST_HALF) return index;
+    int shift = index / HIST_HALF - 1;
+    long long low = (long long)(index % HIST_HALF + HIST_HALF) << shift;
+    return low + (1LL << shift) - 1;
+}
+
+void hist_clear(Histogram *h) {
+    memset(h, 0, sizeof(*h));
+}
+
+void hist_record(Histogram *h, long long value_us) {
+    h->counts[hist_index(value_us)]++;
+    h->total++;
+    h->sum += value_us;
+    if (value_us > h->max) h->max = value_us;
+}
+
+void hist_merge(Histogram *into, const Histogram *from) {
+    if (from->total == 0) return;
+    for (int i = 0; i < HIST_BUCKETS; i++) into->counts[i] += from->counts[i];
+    into->total += from->total;
+    into->sum += from->sum;
+    if (from->max > into->max) into->max = from->max;
+}
+
+/* Nearest-rank percentile, reported as the top of its bucket (never above
+ * the recorded maximum). */
+long long hist_percentile(const Histogram *h, int pct) {
+    if (h->total == 0) return 0;
+    uint64_t rank = (pct * h->total + 99) / 100;
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            if (i == HIST_BUCKETS - 1) return h->max;
+            long long top = hist_bucket_top(i);
+            return top < h->max ? top : h->max;
+        }
+    }
+    return h->max;
+}
+
+void phase_timers_init(PhaseTimers *timers) {
+    timers->id = atomic_fetch_add(&next_timers_id, 1);
+    timers->sets = NULL;
+    pthread_mutex_init(&timers->mutex, NULL);
+}
+
+/* The thread's set for `timers`. The last one used is cached; a thread
+ * that moves between simulations (a hub worker) finds its existing set
+ * again instead of starting a new one. */
+static PhaseSet *phase_set(PhaseTimers *timers) {
+    if (thread_set_timers == timers->id) return thread_set;
+
+    pthread_t self = pthread_self();
+    pthread_mutex_lock(&timers->mutex);
+    PhaseSet *set = timers->sets;
+    while (set != NULL && !pthread_equal(set->owner, self)) set = set->next;
+    if (set == NULL) {
+        set = (PhaseSet *)calloc(1, sizeof(PhaseSet));
+        set->owner = self;
+        set->next = timers->sets;
+        timers->sets = set;
+    }
+    pthread_mutex_unlock(&timers->mutex);
+
+    thread_set = set;
+    thread_set_timers = timers->id;
+    return set;
+}
+
+/* `priority` is the task's (1-3), or 0 for a phase without one. */
+void phase_record(PhaseTimers *timers, Phase phase, int priority, long long value_us) {
+    if (priority < 0 || priority >= PHASE_PRIORITY_SLOTS) priority = 0;
+    hist_record(&phase_set(timers)->hist[phase][priority], value_us);
+}
+
+/* Sums every thread's histogram for `phase` and `priority` (-1 for all
+ * priorities) into `out`. Only call once the recording threads are done. */
+void phase_timers_merge(const PhaseTimers *timers, Phase phase, int priority, Histogram *out) {
+    hist_clear(out);
+    for (const PhaseSet *set = timers->sets; set != NULL; set = set->next) {
+        for (int p = 0; p < PHASE_PRIORITY_SLOTS; p++) {
+            if (priority < 0 || p == priority) hist_merge(out, &set->hist[phase][p]);
+        }
+    }
+}
+
+/* Adds a whole histogram to the calling thread's, as if its samples had
+ * been recorded here; used to carry timings over from a checkpoint. */
+void phase_timers_add(PhaseTimers *timers, Phase phase, int priority, const Histogram *from) {
+    if (priority < 0 || priority >= PHASE_PRIORITY_SLOTS) priority = 0;
+    hist_merge(&phase_set(timers)->hist[phase][priority], from);
+}
+
+void phase_timers_destroy(PhaseTimers *timers) {
+    PhaseSet *set = timers->sets;
+    while (set != NULL) {
+        PhaseSet *next = set->next;
+        free(set);
+        set = next;
+    }
+    timers->sets = NULL;
+    pthread_mutex_destroy(&timers->mutex);
+}
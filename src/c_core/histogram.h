@@ -0,0 +1,62 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#define HIST_SUB_BITS 7
+#define HIST_HALF (1 << (HIST_SUB_BITS - 1))
+#define HIST_MAX_BITS 40
+#define HIST_BUCKETS ((HIST_MAX_BITS - HIST_SUB_BITS + 2) * HIST_HALF)
+#define PHASE_PRIORITY_SLOTS 4
+
+/* Log-linear histogram of microsecond values in the style of HdrHistogram:
+ * exact below 128 us, then 64 linear buckets per power of two, so a
+ * percentile is within about 1.6% of the true value. Values at or above
+ * 2^40 us (about 12 days) land in the last bucket; `max` stays exact. */
+typedef struct {
+    uint64_t counts[HIST_BUCKETS];
+    uint64_t total;
+    long long sum;
+    long long max;
+} Histogram;
+
+typedef enum {
+    PHASE_QUEUE_WAIT,
+    PHASE_PICKUP,
+    PHASE_BAY_WAIT,
+    PHASE_CHARGER_WAIT,
+    PHASE_FLIGHT,
+    PHASE_DELIVERY,
+    PHASE_COUNT
+} Phase;
+
+/* One thread's histograms: slot 0 is for phases with no task (a drone
+ * waiting for a charger), slots 1-3 for task priorities. */
+typedef struct PhaseSet {
+    Histogram hist[PHASE_COUNT][PHASE_PRIORITY_SLOTS];
+    pthread_t owner;
+    struct PhaseSet *next;
+} PhaseSet;
+
+/* Timing for one simulation. Each recording thread gets its own PhaseSet
+ * on first use, so recording is a plain increment with no lock or atomic;
+ * the sets are merged once the threads that wrote them have stopped. */
+typedef struct {
+    unsigned long id;
+    PhaseSet *sets;
+    pthread_mutex_t mutex;
+} PhaseTimers;
+
+void hist_clear(Histogram *h);
+void hist_record(Histogram *h, long long value_us);
+void hist_merge(Histogram *into, const Histogram *from);
+long long hist_percentile(const Histogram *h, int pct);
+
+void phase_timers_init(PhaseTimers *timers);
+void phase_record(PhaseTimers *timers, Phase phase, int priority, long long value_us);
+void phase_timers_merge(const PhaseTimers *timers, Phase phase, int priority, Histogram *out);
+void phase_timers_add(PhaseTimers *timers, Phase phase, int priority, const Histogram *from);
+void phase_timers_destroy(PhaseTimers *timers);
+
+#endif
@@ -0,0 +1,305 @@
+#include "hub.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct {
+    Hub *hubs;
+    int num_hubs;
+    long long epoch_end;
+    bool done;
+    atomic_int next;
+    pthread_barrier_t start;
+    pthread_barrier_t finish;
+} HubRun;
+
+/* Hub of every scenario location, in order of first use as a task source;
+ * -1 for locations no task starts from. Returns the number of hubs. */
+static int hub_partition(const Scenario *sc, int *hub_of) {
+    int num_locations = lt_count(&sc->locations);
+    int num_hubs = 0;
+    for (int i = 0; i < num_locations; i++) hub_of[i] = -1;
+    for (int i = 0; i < sc->num_tasks; i++) {
+        LocationId source = sc->tasks[i].source;
+        if (hub_of[source] < 0) hub_of[source] = num_hubs++;
+    }
+    return num_hubs;
+}
+
+int hub_count(const Scenario *sc) {
+    int *hub_of = (int *)malloc(sizeof(int) * (lt_count(&sc->locations) + 1));
+    int num_hubs = hub_partition(sc, hub_of);
+    free(hub_of);
+    return num_hubs;
+}
+
+/* Drone i goes to hub i % num_hubs; every hub knows every location and
+ * charger, and gets the tasks that start at its warehouse. */
+static void hub_populate(const Scenario *sc, const HubOptions *opts, Hub *hub, int h, int num_hubs,
+                         const int *hub_of) {
+    Simulation *sim = &hub->sim;
+    int num_drones = opts->num_drones > 0 ? opts->num_drones : sc->num_drones;
+
+    for (int i = h; i < num_drones; i += num_hubs) {
+        if (sc->num_drones > 0) {
+            const DroneSpec *spec = &sc->drones[i % sc->num_drones];
+            add_drone_at(sim, spec->speed, spec->battery, spec->position);
+        } else {
+            add_drone(sim, 1 + (i % 2), 80 + (i % 21));
+        }
+    }
+    int num_locations = lt_count(&sc->locations);
+    LocationId *ids = (LocationId *)malloc(sizeof(LocationId) * (num_locations > 0 ? num_locations : 1));
+    for (int i = 0; i < num_locations; i++) {
+        const char *name = lt_name(&sc->locations, i);
+        Point position;
+        ids[i] = lt_intern(&sim->locations, name, strlen(name));
+        if (lt_position(&sc->locations, i, &position)) lt_place(&sim->locations, ids[i], position);
+    }
+    for (int i = 0; i < sc->num_tasks; i++) {
+        const TaskSpec *spec = &sc->tasks[i];
+        if (hub_of[spec->source] != h) continue;
+        add_task_between(sim, ids[spec->source], ids[spec->destination], spec->priority, spec->est_time);
+    }
+    free(ids);
+    for (int i = 0; i < sc->num_chargers; i++) {
+        add_charger(sim, sc->chargers[i]);
+    }
+}
+
+static LocationId hub_location(Simulation *to, const Simulation *from, LocationId id) {
+    const char *name = lt_name(&from->locations, id);
+    LocationId local = lt_intern(&to->locations, name, strlen(name));
+    Point position;
+    if (lt_position(&from->locations, id, &position)) lt_place(&to->locations, local, position);
+    return local;
+}
+
+/* Re-creates a stolen task in `to`, keeping its original timestamps so its
+ * latency covers the time it spent queued at the other hub. */
+static void hub_adopt(Hub *to, Hub *from, const Task *task) {
+    LocationId source = hub_location(&to->sim, &from->sim, task->source);
+    LocationId dest = hub_location(&to->sim, &from->sim, task->destination);
+    Task *copy = add_task_between(&to->sim, source, dest, task->priority, task->estimated_time);
+    if (copy == NULL) return;
+    copy->created_at = task->created_at;
+    copy->enqueued_at = task->enqueued_at;
+    from->stolen_out++;
+    to->stolen_in++;
+}
+
+/* Queued tasks a hub cannot start now: its backlog beyond its idle drones. */
+static int hub_surplus(Hub *hub) {
+    return pq_size(&hub->sim.task_queue) - hub->sim.idle_drones.size;
+}
+
+/* Runs between slices, with every engine stopped at the same instant. Each
+ * hub with idle drones and nothing queued takes one task per idle drone,
+ * always from the hub with the largest surplus, so the result depends only
+ * on the hubs' state and the run stays reproducible. */
+static int hub_rebalance(HubRun *run) {
+    int moved = 0;
+    for (int t = 0; t < run->num_hubs; t++) {
+        Hub *thief = &run->hubs[t];
+        int idle = -hub_surplus(thief);
+        if (idle <= 0 || pq_size(&thief->sim.task_queue) > 0) continue;
+
+        int taken = 0;
+        while (taken < idle) {
+            Hub *victim = NULL;
+            int most = 0;
+            for (int v = 0; v < run->num_hubs; v++) {
+                int surplus = hub_surplus(&run->hubs[v]);
+                if (v != t && surplus > most) {
+                    victim = &run->hubs[v];
+                    most = surplus;
+                }
+            }
+            if (victim == NULL) break;
+            Task *task = dispatch_steal(&victim->sim);
+            if (task == NULL) break;
+            hub_adopt(thief, victim, task);
+            taken++;
+        }
+        if (taken > 0) des_notify(&thief->des);
+        moved += taken;
+    }
+    return moved;
+}
+
+/* Each slice, workers claim hubs one at a time and run them to the slice
+ * end; the barriers hand control back to hub_run in between. */
+static void *hub_worker(void *arg) {
+    HubRun *run = (HubRun *)arg;
+    for (;;) {
+        pthread_barrier_wait(&run->start);
+        if (run->done) break;
+        int i;
+        while ((i = atomic_fetch_add(&run->next, 1)) < run->num_hubs) {
+            des_run_until(&run->hubs[i].des, run->epoch_end);
+        }
+        pthread_barrier_wait(&run->finish);
+    }
+    return NULL;
+}
+
+static void hub_report(FILE *out, const HubRun *run, const HubOptions *opts, const HubSummary *summary) {
+    double span_us = (double)opts->duration * 1e6;
+    Histogram *done = (Histogram *)malloc(sizeof(Histogram));
+    Histogram *all = (Histogram *)calloc(1, sizeof(Histogram));
+    Histogram *wait = (Histogram *)calloc(1, sizeof(Histogram));
+
+    fprintf(out, "Hubs: %d (one per warehouse), %d simulated s on %d thread%s", run->num_hubs, opts->duration,
+            summary->threads, summary->threads == 1 ? "" : "s");
+    if (opts->steal_interval > 0) {
+        fprintf(out, ", task stealing every %d s\n", opts->steal_interval);
+    } else {
+        fprintf(out, ", no task stealing\n");
+    }
+    fprintf(out, "  %-16s %7s %7s %7s %8s %9s %8s %8s %9s\n", "hub", "drones", "tasks", "done", "preempt",
+            "stolen", "p50 s", "p99 s", "charging");
+
+    long long charging_busy_us = 0;
+    int drones = 0;
+    for (int h = 0; h < run->num_hubs; h++) {
+        const Hub *hub = &run->hubs[h];
+        const Statistics *stats = &hub->sim.stats;
+        phase_timers_merge(&stats->phases, PHASE_QUEUE_WAIT, -1, done);
+        hist_merge(wait, done);
+        phase_timers_merge(&stats->phases, PHASE_DELIVERY, -1, done);
+        hist_merge(all, done);
+
+        char stolen[24];
+        snprintf(stolen, sizeof(stolen), "+%d/-%d", hub->stolen_in, hub->stolen_out);
+        double charging = (opts->num_charging > 0 && span_us > 0)
+                              ? stats->charging_busy_us * 100.0 / (opts->num_charging * span_us) : 0.0;
+        fprintf(out, "  %-16s %7d %7d %7d %8d %9s %8.1f %8.1f %8.1f%%\n", hub->name, hub->sim.num_drones,
+                stats->total_tasks - hub->stolen_in, stats->completed_tasks, stats->total_preemptions, stolen,
+                hist_percentile(done, 50) / 1e6, hist_percentile(done, 99) / 1e6, charging);
+        charging_busy_us += stats->charging_busy_us;
+        drones += hub->sim.num_drones;
+    }
+    double charging = (opts->num_charging > 0 && span_us > 0)
+                          ? charging_busy_us * 100.0 / (opts->num_charging * run->num_hubs * span_us) : 0.0;
+    char stolen[24];
+    snprintf(stolen, sizeof(stolen), "%d", summary->stolen);
+    fprintf(out, "  %-16s %7d %7d %7d %8d %9s %8.1f %8.1f %8.1f%%\n", "all", drones, summary->total_tasks,
+            summary->completed_tasks, summary->preemptions, stolen, hist_percentile(all, 50) / 1e6,
+            hist_percentile(all, 99) / 1e6, charging);
+
+    fprintf(out, "Dispatch latency (all hubs): p50 %.1fs | p90 %.1fs | p99 %.1fs | max %.1fs\n",
+            hist_percentile(wait, 50) / 1e6, hist_percentile(wait, 90) / 1e6, hist_percentile(wait, 99) / 1e6,
+            wait->max / 1e6);
+    fprintf(out, "Completion latency (all hubs): p50 %.1fs | p90 %.1fs | p99 %.1fs | max %.1fs\n",
+            hist_percentile(all, 50) / 1e6, hist_percentile(all, 90) / 1e6, hist_percentile(all, 99) / 1e6,
+            all->max / 1e6);
+    if (opts->deterministic) {
+        fprintf(out, "Processed %llu events (seed %llu)\n", summary->events, opts->seed);
+    } else {
+        fprintf(out, "Processed %llu events in %.3f ms wall time\n", summary->events, summary->wall_ms);
+    }
+    free(done);
+    free(all);
+    free(wait);
+}
+
+/* Splits the scenario into one hub per warehouse (task source) and runs
+ * the hubs in parallel on `threads` workers, each hub on the
+ * discrete-event engine with its own stations. With `steal_interval` the
+ * run advances in slices of that many simulated seconds and rebalances
+ * between them. Writes a merged report to `out` (if not NULL) and fills
+ * `summary`; returns false when the scenario has no tasks to partition. */
+bool hub_run(const Scenario *sc, const HubOptions *opts, FILE *out, HubSummary *summary) {
+    int *hub_of = (int *)malloc(sizeof(int) * (lt_count(&sc->locations) + 1));
+    int num_hubs = hub_partition(sc, hub_of);
+    memset(summary, 0, sizeof(*summary));
+    if (num_hubs == 0) {
+        free(hub_of);
+        return false;
+    }
+
+    HubRun run;
+    run.num_hubs = num_hubs;
+    run.hubs = (Hub *)calloc(num_hubs, sizeof(Hub));
+    run.done = false;
+    for (int i = 0; i < sc->num_tasks; i++) {
+        LocationId source = sc->tasks[i].source;
+        run.hubs[hub_of[source]].name = lt_name(&sc->locations, source);
+    }
+    for (int h = 0; h < num_hubs; h++) {
+        Hub *hub = &run.hubs[h];
+        SimOptions options = {
+            .num_drones = 0,
+            .num_charging = opts->num_charging,
+            .num_loading = opts->num_loading,
+            .engine = ENGINE_DES,
+            .output = OUTPUT_NONE,
+            .deterministic = opts->deterministic,
+            .seed = opts->seed + h,
+            .quiet_setup = true,
+            .policy = opts->policy,
+            .full_charge = opts->full_charge
+        };
+        init_simulation_with_options(&hub->sim, &options);
+        hub_populate(sc, opts, hub, h, num_hubs, hub_of);
+        des_start(&hub->des, &hub->sim, opts->duration);
+    }
+    free(hub_of);
+
+    int threads = opts->threads;
+    if (threads < 1) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads > num_hubs) threads = num_hubs;
+    summary->num_hubs = num_hubs;
+    summary->threads = threads;
+
+    pthread_barrier_init(&run.start, NULL, threads + 1);
+    pthread_barrier_init(&run.finish, NULL, threads + 1);
+    pthread_t *workers = (pthread_t *)malloc(sizeof(pthread_t) * threads);
+    for (int t = 0; t < threads; t++) {
+        pthread_create(&workers[t], NULL, hub_worker, &run);
+    }
+
+    struct timespec wall_start, wall_end;
+    clock_gettime(CLOCK_MONOTONIC, &wall_start);
+    int slice = opts->steal_interval > 0 ? opts->steal_interval : opts->duration;
+    for (long long now = 0; now < opts->duration; now += slice) {
+        run.epoch_end = now + slice < opts->duration ? now + slice : opts->duration;
+        atomic_store(&run.next, 0);
+        pthread_barrier_wait(&run.start);
+        pthread_barrier_wait(&run.finish);
+        if (opts->steal_interval > 0 && run.epoch_end < opts->duration) {
+            summary->stolen += hub_rebalance(&run);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+    summary->wall_ms = (wall_end.tv_sec - wall_start.tv_sec) * 1000.0 +
+                       (wall_end.tv_nsec - wall_start.tv_nsec) / 1e6;
+
+    run.done = true;
+    pthread_barrier_wait(&run.start);
+    for (int t = 0; t < threads; t++) {
+        pthread_join(workers[t], NULL);
+    }
+    free(workers);
+    pthread_barrier_destroy(&run.start);
+    pthread_barrier_destroy(&run.finish);
+
+    for (int h = 0; h < num_hubs; h++) {
+        Hub *hub = &run.hubs[h];
+        des_finish(&hub->des, opts->duration);
+        summary->total_tasks += hub->sim.stats.total_tasks - hub->stolen_in;
+        summary->completed_tasks += hub->sim.stats.completed_tasks;
+        summary->preemptions += hub->sim.stats.total_preemptions;
+        summary->events += hub->des.events_processed;
+    }
+    if (out != NULL) {
+        hub_report(out, &run, opts, summary);
+        fflush(out);
+    }
+    for (int h = 0; h < num_hubs; h++) {
+        free_simulation(&run.hubs[h].sim);
+    }
+    free(run.hubs);
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef HUB_H
+#define HUB_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "scenario.h"
+#include "des_engine.h"
+#include "policy.h"
+
+/* `steal_interval` is how often, in simulated seconds, hubs with idle
+ * drones take queued tasks from overloaded ones; 0 keeps hubs apart. */
+typedef struct {
+    int num_drones;
+    int num_charging;
+    int num_loading;
+    int duration;
+    int threads;
+    int steal_interval;
+    bool deterministic;
+    unsigned long long seed;
+    const SchedPolicy *policy;
+    bool full_charge;
+} HubOptions;
+
+/* One warehouse's share of the operation: its own simulation (drones,
+ * queue, stations, dispatcher) on its own discrete-event engine. */
+typedef struct {
+    const char *name;
+    Simulation sim;
+    DesEngine des;
+    int stolen_in;
+    int stolen_out;
+} Hub;
+
+typedef struct {
+    int num_hubs;
+    int threads;
+    int total_tasks;
+    int completed_tasks;
+    int preemptions;
+    int stolen;
+    unsigned long long events;
+    double wall_ms;
+} HubSummary;
+
+int hub_count(const Scenario *sc);
+bool hub_run(const Scenario *sc, const HubOptions *opts, FILE *out, HubSummary *summary);
+
+#endif
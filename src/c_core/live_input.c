@@ -0,0 +1,233 @@
+#include "live_input.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static void live_add_source(LiveInput *live, int fd) {
+    if (live->num_sources == LIVE_MAX_SOURCES) {
+        fprintf(stderr, "Warning: Live input full (%d sources), closing connection\n", LIVE_MAX_SOURCES);
+        close(fd);
+        return;
+    }
+    LiveSource *src = &live->sources[live->num_sources++];
+    src->fd = fd;
+    src->capacity = LIVE_READ_CHUNK;
+    src->buf = (char *)malloc(src->capacity);
+    src->used = 0;
+    src->line_num = 0;
+}
+
+/* Moves the last source into slot `i`, so callers walk the array backwards. */
+static void live_remove_source(LiveInput *live, int i) {
+    LiveSource *src = &live->sources[i];
+    if (src->fd != STDIN_FILENO) close(src->fd);
+    free(src->buf);
+    live->sources[i] = live->sources[--live->num_sources];
+}
+
+/* Parses the complete lines buffered for `src` (and with `final` its
+ * unterminated tail) into the batch. START only ends the initial
+ * configuration, so a repeated one is skipped. */
+static void live_parse(LiveInput *live, LiveSource *src, bool final) {
+    size_t offset = 0;
+    while (offset < src->used) {
+        bool stop = false;
+        int before = src->line_num;
+        offset += scenario_parse(&live->batch, src->buf + offset, src->used - offset, final, &src->line_num, &stop);
+        live->lines += (unsigned long long)(src->line_num - before);
+        if (!stop) break;
+    }
+    memmove(src->buf, src->buf + offset, src->used - offset);
+    src->used -= offset;
+}
+
+/* Returns false once the source has closed. */
+static bool live_read(LiveInput *live, LiveSource *src) {
+    if (src->used == src->capacity) {
+        src->capacity *= 2;
+        src->buf = (char *)realloc(src->buf, src->capacity);
+    }
+    ssize_t n = read(src->fd, src->buf + src->used, src->capacity - src->used);
+    if (n < 0 && (errno == EINTR || errno == EAGAIN)) return true;
+    if (n > 0) src->used += (size_t)n;
+    live_parse(live, src, n <= 0);
+    return n > 0;
+}
+
+/* Hands the batch to the running simulation: drones first, so a task in the
+ * same read can go straight to one, then locations by name and the tasks
+ * between them. A location keeps the coordinates it had when the
+ * simulation first placed it; running drones may be reading them. */
+static void live_apply(LiveInput *live) {
+    Scenario *batch = &live->batch;
+    Simulation *sim = live->sim;
+
+    for (int i = 0; i < batch->num_drones; i++) {
+        add_drone_at(sim, batch->drones[i].speed, batch->drones[i].battery, batch->drones[i].position);
+    }
+
+    int num_locations = lt_count(&batch->locations);
+    if (num_locations > live->ids_capacity) {
+        live->ids_capacity = num_locations * 2;
+        live->ids = (LocationId *)realloc(live->ids, sizeof(LocationId) * live->ids_capacity);
+    }
+    for (int i = 0; i < num_locations; i++) {
+        const char *name = lt_name(&batch->locations, i);
+        Point position;
+        live->ids[i] = lt_intern(&sim->locations, name, strlen(name));
+        if (lt_position(&batch->locations, i, &position) && !lt_position(&sim->locations, live->ids[i], NULL)) {
+            lt_place(&sim->locations, live->ids[i], position);
+        }
+    }
+    for (int i = 0; i < batch->num_tasks; i++) {
+        const TaskSpec *spec = &batch->tasks[i];
+        add_task_between(sim, live->ids[spec->source], live->ids[spec->destination], spec->priority, spec->est_time);
+    }
+    for (int i = 0; i < batch->num_chargers; i++) {
+        add_charger(sim, batch->chargers[i]);
+    }
+
+    live->drones += (unsigned long long)batch->num_drones;
+    live->tasks += (unsigned long long)batch->num_tasks;
+    batch->num_drones = 0;
+    batch->num_tasks = 0;
+    batch->num_chargers = 0;
+    if (num_locations > 0) {
+        lt_destroy(&batch->locations);
+        lt_init(&batch->locations);
+    }
+}
+
+static void *live_thread(void *arg) {
+    LiveInput *live = (LiveInput *)arg;
+    struct pollfd fds[LIVE_MAX_SOURCES + 2];
+
+    for (;;) {
+        int count = 0;
+        fds[count++] = (struct pollfd){ .fd = live->wake_pipe[0], .events = POLLIN };
+        if (live->listen_fd >= 0) fds[count++] = (struct pollfd){ .fd = live->listen_fd, .events = POLLIN };
+        int first = count;
+        for (int i = 0; i < live->num_sources; i++) {
+            fds[count++] = (struct pollfd){ .fd = live->sources[i].fd, .events = POLLIN };
+        }
+
+        if (poll(fds, count, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[0].revents != 0) break;
+
+        for (int i = live->num_sources - 1; i >= 0; i--) {
+            if (fds[first + i].revents == 0) continue;
+            if (!live_read(live, &live->sources[i])) live_remove_source(live, i);
+        }
+        live_apply(live);
+
+        if (live->listen_fd >= 0 && (fds[1].revents & POLLIN)) {
+            int fd = accept(live->listen_fd, NULL, NULL);
+            if (fd >= 0) {
+                live->connections++;
+                live_add_source(live, fd);
+            }
+        }
+    }
+    return NULL;
+}
+
+static int live_listen(const char *path) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    unlink(path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+/* Starts reading from stdin (`pending` holds what the configuration reader
+ * had already taken past START) and/or a Unix socket at `socket_path`. The
+ * simulation must be running on the threads engine. */
+bool live_input_start(LiveInput *live, Simulation *sim, bool use_stdin, const char *socket_path,
+                      const char *pending, size_t pending_len) {
+    live->sim = sim;
+    scenario_init(&live->batch);
+    live->ids = NULL;
+    live->ids_capacity = 0;
+    live->num_sources = 0;
+    live->listen_fd = -1;
+    live->socket_path = socket_path;
+    live->lines = 0;
+    live->drones = 0;
+    live->tasks = 0;
+    live->connections = 0;
+
+    if (socket_path != NULL) {
+        live->listen_fd = live_listen(socket_path);
+        if (live->listen_fd < 0) {
+            fprintf(stderr, "Error: Cannot listen on socket '%s': %s\n", socket_path, strerror(errno));
+            scenario_destroy(&live->batch);
+            return false;
+        }
+    }
+    if (pipe(live->wake_pipe) < 0) {
+        fprintf(stderr, "Error: Cannot create live input pipe: %s\n", strerror(errno));
+        if (live->listen_fd >= 0) close(live->listen_fd);
+        scenario_destroy(&live->batch);
+        return false;
+    }
+
+    if (use_stdin) {
+        live_add_source(live, STDIN_FILENO);
+        LiveSource *src = &live->sources[0];
+        if (pending_len > src->capacity) {
+            src->capacity = pending_len;
+            src->buf = (char *)realloc(src->buf, src->capacity);
+        }
+        memcpy(src->buf, pending, pending_len);
+        src->used = pending_len;
+        live_parse(live, src, false);
+        live_apply(live);
+    }
+
+    pthread_create(&live->thread, NULL, live_thread, live);
+    log_event(sim, "[Live] Accepting tasks from %s%s%s", use_stdin ? "stdin" : "",
+              use_stdin && socket_path != NULL ? " and " : "", socket_path != NULL ? socket_path : "");
+    return true;
+}
+
+/* Stops reading; a line still missing its newline is dropped. */
+void live_input_stop(LiveInput *live) {
+    ssize_t written;
+    do {
+        written = write(live->wake_pipe[1], "", 1);
+    } while (written < 0 && errno == EINTR);
+    pthread_join(live->thread, NULL);
+
+    log_event(live->sim, "[Live] %llu lines: %llu drones and %llu tasks added, %llu connections",
+              live->lines, live->drones, live->tasks, live->connections);
+
+    while (live->num_sources > 0) live_remove_source(live, live->num_sources - 1);
+    if (live->listen_fd >= 0) {
+        close(live->listen_fd);
+        unlink(live->socket_path);
+    }
+    close(live->wake_pipe[0]);
+    close(live->wake_pipe[1]);
+    free(live->ids);
+    scenario_destroy(&live->batch);
+}
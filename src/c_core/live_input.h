@@ -0,0 +1,48 @@
+#ifndef LIVE_INPUT_H
+#define LIVE_INPUT_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "scenario.h"
+
+#define LIVE_MAX_SOURCES 64
+#define LIVE_READ_CHUNK 65536
+
+/* One descriptor feeding lines: stdin or an accepted socket client. Bytes
+ * past the last newline wait in `buf` for the rest of their line. */
+typedef struct {
+    int fd;
+    char *buf;
+    size_t used;
+    size_t capacity;
+    int line_num;
+} LiveSource;
+
+/* Reads DRONE/TASK/WAREHOUSE/CUSTOMER/CHARGER lines while a threads-engine
+ * simulation runs. One thread polls stdin, a Unix socket and its clients;
+ * each read is parsed into `batch` with the scenario parser and applied in
+ * one go, so tasks reach the lock-free queue without the scheduler ever
+ * waiting on input. */
+typedef struct {
+    Simulation *sim;
+    Scenario batch;
+    LocationId *ids;
+    int ids_capacity;
+    LiveSource sources[LIVE_MAX_SOURCES];
+    int num_sources;
+    int listen_fd;
+    const char *socket_path;
+    int wake_pipe[2];
+    pthread_t thread;
+    unsigned long long lines;
+    unsigned long long drones;
+    unsigned long long tasks;
+    unsigned long long connections;
+} LiveInput;
+
+bool live_input_start(LiveInput *live, Simulation *sim, bool use_stdin, const char *socket_path,
+                      const char *pending, size_t pending_len);
+void live_input_stop(LiveInput *live);
+
+#endif
@@ -0,0 +1,144 @@
+#include "location_table.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t lt_hash(const char *name, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static LocationEntry *lt_entry(const LocationTable *table, LocationId id) {
+    return &table->pages[id / LOCATION_PAGE_SIZE][id % LOCATION_PAGE_SIZE];
+}
+
+void lt_init(LocationTable *table) {
+    table->pages = (LocationEntry **)calloc(LOCATION_MAX_PAGES, sizeof(LocationEntry *));
+    atomic_init(&table->count, 0);
+    table->slot_mask = 63;
+    table->slots = (uint32_t *)calloc(table->slot_mask + 1, sizeof(uint32_t));
+    table->arenas = NULL;
+    pthread_mutex_init(&table->mutex, NULL);
+}
+
+/* Caller holds the mutex. Slots store id + 1 so zero marks an empty slot. */
+static void lt_grow_slots(LocationTable *table) {
+    uint32_t mask = table->slot_mask * 2 + 1;
+    uint32_t *slots = (uint32_t *)calloc(mask + 1, sizeof(uint32_t));
+    for (uint32_t i = 0; i <= table->slot_mask; i++) {
+        if (table->slots[i] == 0) continue;
+        const char *name = lt_entry(table, table->slots[i] - 1)->name;
+        uint32_t slot = lt_hash(name, strlen(name)) & mask;
+        while (slots[slot] != 0) slot = (slot + 1) & mask;
+        slots[slot] = table->slots[i];
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->slot_mask = mask;
+}
+
+static const char *lt_store_name(LocationTable *table, const char *name, size_t len) {
+    LocationArena *arena = table->arenas;
+    if (arena == NULL || arena->used + len + 1 > LOCATION_ARENA_SIZE) {
+        arena = (LocationArena *)malloc(sizeof(LocationArena));
+        arena->next = table->arenas;
+        arena->used = 0;
+        table->arenas = arena;
+    }
+    char *stored = arena->data + arena->used;
+    memcpy(stored, name, len);
+    stored[len] = '\0';
+    arena->used += len + 1;
+    return stored;
+}
+
+/* Returns the id of the first `len` bytes of `name`, adding it on first
+ * sight. Ids are dense and start at 0. */
+LocationId lt_intern(LocationTable *table, const char *name, size_t len) {
+    if (len >= LOCATION_ARENA_SIZE) len = LOCATION_ARENA_SIZE - 1;
+    uint32_t hash = lt_hash(name, len);
+
+    pthread_mutex_lock(&table->mutex);
+    uint32_t slot = hash & table->slot_mask;
+    while (table->slots[slot] != 0) {
+        LocationId id = table->slots[slot] - 1;
+        const char *existing = lt_entry(table, id)->name;
+        if (strncmp(existing, name, len) == 0 && existing[len] == '\0') {
+            pthread_mutex_unlock(&table->mutex);
+            return id;
+        }
+        slot = (slot + 1) & table->slot_mask;
+    }
+
+    LocationId id = atomic_load_explicit(&table->count, memory_order_relaxed);
+    if (id == (LocationId)LOCATION_PAGE_SIZE * LOCATION_MAX_PAGES) {
+        pthread_mutex_unlock(&table->mutex);
+        fprintf(stderr, "Error: Location table full (%d names)\n", LOCATION_PAGE_SIZE * LOCATION_MAX_PAGES);
+        exit(1);
+    }
+    if (table->pages[id / LOCATION_PAGE_SIZE] == NULL) {
+        table->pages[id / LOCATION_PAGE_SIZE] = (LocationEntry *)calloc(LOCATION_PAGE_SIZE, sizeof(LocationEntry));
+    }
+    LocationEntry *entry = lt_entry(table, id);
+    entry->name = lt_store_name(table, name, len);
+    entry->placed = false;
+    table->slots[slot] = id + 1;
+    atomic_store_explicit(&table->count, id + 1, memory_order_release);
+
+    if ((id + 1) * 2 > table->slot_mask) lt_grow_slots(table);
+    pthread_mutex_unlock(&table->mutex);
+    return id;
+}
+
+/* Gives a location coordinates; a later call moves it. Positions are meant
+ * to be set while the scenario is built, before drones read them. */
+void lt_place(LocationTable *table, LocationId id, Point position) {
+    pthread_mutex_lock(&table->mutex);
+    LocationEntry *entry = lt_entry(table, id);
+    entry->position = position;
+    entry->placed = true;
+    pthread_mutex_unlock(&table->mutex);
+}
+
+const char *lt_name(const LocationTable *table, LocationId id) {
+    return lt_entry(table, id)->name;
+}
+
+bool lt_position(const LocationTable *table, LocationId id, Point *position) {
+    const LocationEntry *entry = lt_entry(table, id);
+    if (position != NULL) *position = entry->position;
+    return entry->placed;
+}
+
+int lt_count(const LocationTable *table) {
+    return (int)atomic_load(&((LocationTable *)table)->count);
+}
+
+/* Heap bytes held by the table: entry pages, hash slots and name arenas. */
+size_t lt_memory(const LocationTable *table) {
+    size_t pages = (lt_count(table) + LOCATION_PAGE_SIZE - 1) / LOCATION_PAGE_SIZE;
+    size_t arenas = 0;
+    for (const LocationArena *arena = table->arenas; arena != NULL; arena = arena->next) arenas++;
+    return LOCATION_MAX_PAGES * sizeof(LocationEntry *) + pages * LOCATION_PAGE_SIZE * sizeof(LocationEntry) +
+           (table->slot_mask + 1) * sizeof(uint32_t) + arenas * sizeof(LocationArena);
+}
+
+void lt_destroy(LocationTable *table) {
+    for (int i = 0; i < LOCATION_MAX_PAGES; i++) free(table->pages[i]);
+    free(table->pages);
+    free(table->slots);
+    LocationArena *arena = table->arenas;
+    while (arena != NULL) {
+        LocationArena *next = arena->next;
+        free(arena);
+        arena = next;
+    }
+    table->pages = NULL;
+    table->slots = NULL;
+    table->arenas = NULL;
+    atomic_store(&table->count, 0);
+    pthread_mutex_destroy(&table->mutex);
+}
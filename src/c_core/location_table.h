@@ -0,0 +1,52 @@
+#ifndef LOCATION_TABLE_H
+#define LOCATION_TABLE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "spatial_index.h"
+
+#define LOCATION_PAGE_SIZE 1024
+#define LOCATION_MAX_PAGES 1024
+#define LOCATION_ARENA_SIZE 65536
+
+typedef uint32_t LocationId;
+
+typedef struct {
+    const char *name;
+    Point position;
+    bool placed;
+} LocationEntry;
+
+typedef struct LocationArena {
+    struct LocationArena *next;
+    size_t used;
+    char data[LOCATION_ARENA_SIZE];
+} LocationArena;
+
+/* Interned location names, so a task holds two small ids instead of two
+ * strings. Entries live in fixed pages and names in append-only arenas, so
+ * an id handed out stays valid without a lock: only interning (and
+ * placing) takes `mutex`, and readers such as the log drain thread look
+ * names up directly. */
+typedef struct {
+    LocationEntry **pages;
+    atomic_uint count;
+    uint32_t *slots;
+    uint32_t slot_mask;
+    LocationArena *arenas;
+    pthread_mutex_t mutex;
+} LocationTable;
+
+void lt_init(LocationTable *table);
+LocationId lt_intern(LocationTable *table, const char *name, size_t len);
+void lt_place(LocationTable *table, LocationId id, Point position);
+const char *lt_name(const LocationTable *table, LocationId id);
+bool lt_position(const LocationTable *table, LocationId id, Point *position);
+int lt_count(const LocationTable *table);
+size_t lt_memory(const LocationTable *table);
+void lt_destroy(LocationTable *table);
+
+#endif
@@ -1,4 +1,16 @@
 #include "drone_scheduler.h"
+#include "des_engine.h"
+#include "scenario.h"
+#include "sweep.h"
+#include "trace.h"
+#include "live_input.h"
+#include "workload.h"
+#include "metrics_export.h"
+#include "policy.h"
+#include "hub.h"
+#include "checkpoint.h"
+#include "serve.h"
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,24 +23,181 @@ void print_usage(const char *program_name) {
     printf("  --charging <count>      Number of charging stations (default: 3)\n");
     printf("  --loading <count>       Number of loading bays (default: 5)\n");
     printf("  --duration <seconds>    Simulation duration (default: 30)\n");
-    printf("  --config stdin          Read drone and task configuration from stdin\n");
+    printf("  --config <stdin|file>   Read drone and task configuration from stdin or a file (text or binary scenario)\n");
+    printf("  --write-scenario <file> Save the configuration as a binary scenario and exit\n");
+    printf("  --quiet-setup           Do not log each drone and task as it is added\n");
+    printf("  --live                  Keep reading DRONE/TASK lines from stdin after START (threads engine)\n");
+    printf("  --socket <path>         Also accept DRONE/TASK lines on a Unix socket while running\n");
+    printf("  --workload <spec>       Generate tasks while running: poisson|bursty|diurnal[,rate=R,mix=P1:P2:P3,...]\n");
+    printf("  --metrics <file>        Write live metrics in the Prometheus text format to <file> (threads engine)\n");
+    printf("  --metrics-interval <ms> How often --metrics rewrites the file (default: 1000)\n");
+    printf("  --policy <name>         Scheduling policy: priority, edf, sjf, aging or no-preempt (default: priority)\n");
+    printf("  --full-charge           Charge drones to 100%% in arrival order instead of to the queued work's need\n");
+    printf("  --engine <threads|des>  Real-time pthread engine or discrete-event virtual clock (default: threads)\n");
+    printf("  --workers <count>       Worker threads for the threads engine, a sweep, --hubs or --serve (default: one per core)\n");
+    printf("  --output <text|jsonl|binary>  Event stream format on stdout (default: text)\n");
+    printf("  --hubs                  Split the run into one hub per warehouse, each with its own drones, stations and engine\n");
+    printf("  --hub-steal <seconds>   With --hubs, move queued tasks to hubs with idle drones every <seconds> (implies --hubs)\n");
+    printf("  --sweep-drones <range>  Sweep the fleet size; ranges are N, MIN:MAX or MIN:MAX:STEP\n");
+    printf("  --sweep-charging <range>  Sweep the number of charging stations\n");
+    printf("  --sweep-loading <range> Sweep the number of loading bays\n");
+    printf("  --sweep-policy <list>   Sweep scheduling policies: comma-separated names or 'all'\n");
+    printf("  --sweep-format <csv|json>  Sweep result table format (default: csv)\n");
+    printf("  --seed <n>              Deterministic run: discrete-event engine, seeded ordering of simultaneous events\n");
+    printf("  --record <file>         Write the inputs and event trace of a deterministic run to <file>\n");
+    printf("  --replay <file>         Rerun a recorded trace and report where it diverges\n");
+    printf("  --checkpoint <file>     Save the full state of a discrete-event run to <file> at --checkpoint-at\n");
+    printf("  --checkpoint-at <seconds>  Virtual time of the --checkpoint snapshot (default: the end of the run)\n");
+    printf("  --restore <file>        Resume a checkpoint and run on to --duration; --config adds drones and tasks\n");
+    printf("  --serve <path>          Run as a simulation service on a Unix socket; --workers sets the pool size\n");
     printf("  --help                  Show this help message\n");
 }
 
+/* Runs a started engine on to `duration`, saving a checkpoint at
+ * `checkpoint_at` on the way when `checkpoint_path` is set. */
+static bool run_des(DesEngine *des, int duration, const char *checkpoint_path, long long checkpoint_at) {
+    bool ok = true;
+    if (checkpoint_path != NULL) {
+        des_run_until(des, checkpoint_at);
+        FILE *out = fopen(checkpoint_path, "wb");
+        ok = out != NULL && checkpoint_write(des, out);
+        if (out != NULL && fclose(out) != 0) ok = false;
+        if (ok) {
+            log_event(des->sim, "[Engine] Checkpoint at %llds written to %s", checkpoint_at, checkpoint_path);
+        } else {
+            fprintf(stderr, "Error: Cannot write checkpoint '%s'\n", checkpoint_path);
+        }
+    }
+    des_run_until(des, duration);
+    des_finish(des, duration);
+    return ok;
+}
+
+/* Resumes the checkpoint at `path` and runs it on to `duration`. Stations
+ * and the workload come from the file; `overrides` picks the output and
+ * may change the policy, turn on full charging or reseed the run, and the
+ * drones and tasks in `extra` join at the checkpoint's time. */
+static int run_restored(const char *path, const Scenario *extra, const SimOptions *overrides, int duration,
+                        const char *checkpoint_path, long long checkpoint_at) {
+    CheckpointHeader header;
+    FILE *in = fopen(path, "rb");
+    if (in == NULL || !checkpoint_read_header(in, &header)) {
+        fprintf(stderr, "Error: Cannot read checkpoint '%s'\n", path);
+        if (in != NULL) fclose(in);
+        return 1;
+    }
+    const SchedPolicy *policy = overrides->policy != NULL ? overrides->policy : policy_find(header.policy);
+    if (policy == NULL || duration <= header.virtual_time ||
+        (checkpoint_path != NULL && checkpoint_at < header.virtual_time)) {
+        if (policy == NULL) {
+            fprintf(stderr, "Error: Checkpoint '%s' uses unknown policy '%s'\n", path, header.policy);
+        } else {
+            fprintf(stderr, "Error: --duration and --checkpoint-at must be past the checkpoint's %llds\n",
+                    (long long)header.virtual_time);
+        }
+        fclose(in);
+        return 1;
+    }
+    
+    SimOptions options = {
+        .num_drones = header.num_drones,
+        .num_charging = header.num_charging,
+        .num_loading = header.num_loading,
+        .engine = ENGINE_DES,
+        .output = overrides->output,
+        .deterministic = overrides->deterministic || header.deterministic,
+        .seed = overrides->deterministic ? overrides->seed : header.seed,
+        .quiet_setup = overrides->quiet_setup,
+        .policy = policy,
+        .full_charge = overrides->full_charge || header.full_charge
+    };
+    Simulation sim;
+    init_simulation_with_options(&sim, &options);
+    DesEngine des;
+    Workload workload;
+    bool ok = checkpoint_restore(&des, &sim, &workload, in, &header, duration);
+    fclose(in);
+    if (!ok) {
+        fprintf(stderr, "Error: Checkpoint '%s' is damaged\n", path);
+        destroy_simulation(&sim);
+        free_simulation(&sim);
+        return 1;
+    }
+    
+    if (extra->num_drones > 0 || extra->num_tasks > 0) {
+        scenario_populate(extra, &sim, 0);
+        des_notify(&des);
+    }
+    ok = run_des(&des, duration, checkpoint_path, checkpoint_at);
+    print_statistics(&sim);
+    free_simulation(&sim);
+    if (header.has_workload) workload_destroy(&workload);
+    return ok ? 0 : 1;
+}
+
+/* Runs the simulation service until SIGINT or SIGTERM. The signals are
+ * blocked before any thread starts, so only sigwait() sees them. */
+static int run_server(const char *socket_path, int num_workers) {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+    SimServer server;
+    if (!serve_start(&server, socket_path, num_workers, stderr)) return 1;
+    fprintf(stderr, "[Serve] Listening on %s with %d workers\n", socket_path, server.num_workers);
+    int sig;
+    sigwait(&signals, &sig);
+    serve_stop(&server);
+    fprintf(stderr, "[Serve] Stopped: %llu jobs accepted, %llu done, %llu cancelled, %llu failed, %llu turned away\n",
+            (unsigned long long)server.accepted, (unsigned long long)server.completed,
+            (unsigned long long)server.cancelled, (unsigned long long)server.failed,
+            (unsigned long long)server.rejected);
+    return 0;
+}
+
 int main(int argc, char *argv[]) {
     int num_drones = 0;
     int num_charging = 3;
     int num_loading = 5;
     int duration = 30;
     bool use_stdin_config = false;
+    const char *config_path = NULL;
+    const char *write_scenario_path = NULL;
+    bool quiet_setup = false;
+    bool live_stdin = false;
+    const char *socket_path = NULL;
+    bool use_workload = false;
+    WorkloadOptions workload_opts;
+    const char *metrics_path = NULL;
+    int metrics_interval_ms = 1000;
+    const SchedPolicy *policy = NULL;
+    bool full_charge = false;
+    bool hubs = false;
+    int hub_steal = 0;
     bool use_legacy_mode = false;
+    SimEngine engine = ENGINE_THREADS;
+    int num_workers = 0;
+    SimOutput output = OUTPUT_TEXT;
+    bool sweep = false;
+    bool sweep_drones = false;
+    SweepOptions sweep_opts = { .format = SWEEP_CSV };
+    bool deterministic = false;
+    unsigned long long seed = 0;
+    const char *record_path = NULL;
+    const char *replay_path = NULL;
+    const char *checkpoint_path = NULL;
+    long long checkpoint_at = -1;
+    const char *restore_path = NULL;
+    const char *serve_path = NULL;
     
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--drones") == 0 && i + 1 < argc) {
             num_drones = atoi(argv[++i]);
             use_legacy_mode = true;
-            if (num_drones < 1 || num_drones > MAX_DRONES) {
-                fprintf(stderr, "Error: Number of drones must be between 1 and %d\n", MAX_DRONES);
+            if (num_drones < 1) {
+                fprintf(stderr, "Error: Number of drones must be at least 1\n");
                 return 1;
             }
         } else if (strcmp(argv[i], "--charging") == 0 && i + 1 < argc) {
@@ -41,123 +210,409 @@ int main(int argc, char *argv[]) {
             i++;
             if (strcmp(argv[i], "stdin") == 0) {
                 use_stdin_config = true;
+            } else {
+                config_path = argv[i];
+            }
+        } else if (strcmp(argv[i], "--write-scenario") == 0 && i + 1 < argc) {
+            write_scenario_path = argv[++i];
+        } else if (strcmp(argv[i], "--quiet-setup") == 0) {
+            quiet_setup = true;
+        } else if (strcmp(argv[i], "--live") == 0) {
+            live_stdin = true;
+        } else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (strcmp(argv[i], "--workload") == 0 && i + 1 < argc) {
+            if (!workload_parse(argv[++i], &workload_opts)) {
+                fprintf(stderr, "Error: Invalid workload '%s' (see README: poisson|bursty|diurnal[,key=value...])\n", argv[i]);
+                return 1;
+            }
+            use_workload = true;
+        } else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+            metrics_path = argv[++i];
+        } else if (strcmp(argv[i], "--metrics-interval") == 0 && i + 1 < argc) {
+            metrics_interval_ms = atoi(argv[++i]);
+            if (metrics_interval_ms < 1) {
+                fprintf(stderr, "Error: Metrics interval must be at least 1 ms\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--policy") == 0 && i + 1 < argc) {
+            policy = policy_find(argv[++i]);
+            if (policy == NULL) {
+                fprintf(stderr, "Error: Unknown policy '%s' (use priority, edf, sjf, aging or no-preempt)\n", argv[i]);
+                return 1;
             }
+        } else if (strcmp(argv[i], "--full-charge") == 0) {
+            full_charge = true;
+        } else if (strcmp(argv[i], "--hubs") == 0) {
+            hubs = true;
+        } else if (strcmp(argv[i], "--hub-steal") == 0 && i + 1 < argc) {
+            hub_steal = atoi(argv[++i]);
+            if (hub_steal < 1) {
+                fprintf(stderr, "Error: Hub steal interval must be at least 1 second\n");
+                return 1;
+            }
+            hubs = true;
+        } else if (strcmp(argv[i], "--sweep-policy") == 0 && i + 1 < argc) {
+            sweep_opts.num_policies = policy_parse_list(argv[++i], sweep_opts.policies, POLICY_MAX);
+            if (sweep_opts.num_policies < 1) {
+                fprintf(stderr, "Error: Invalid policy list '%s' (comma-separated names or all)\n", argv[i]);
+                return 1;
+            }
+            sweep = true;
+        } else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "des") == 0) {
+                engine = ENGINE_DES;
+            } else if (strcmp(argv[i], "threads") == 0) {
+                engine = ENGINE_THREADS;
+            } else {
+                fprintf(stderr, "Error: Unknown engine '%s' (use threads or des)\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            num_workers = atoi(argv[++i]);
+            if (num_workers < 1) {
+                fprintf(stderr, "Error: Number of workers must be at least 1\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "text") == 0) {
+                output = OUTPUT_TEXT;
+            } else if (strcmp(argv[i], "jsonl") == 0) {
+                output = OUTPUT_JSONL;
+            } else if (strcmp(argv[i], "binary") == 0) {
+                output = OUTPUT_BINARY;
+            } else {
+                fprintf(stderr, "Error: Unknown output '%s' (use text, jsonl or binary)\n", argv[i]);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--sweep-", 8) == 0 && strcmp(argv[i], "--sweep-format") != 0 && i + 1 < argc) {
+            const char *axis = argv[i] + 8;
+            SweepRange *range = (strcmp(axis, "drones") == 0) ? &sweep_opts.drones :
+                                (strcmp(axis, "charging") == 0) ? &sweep_opts.charging :
+                                (strcmp(axis, "loading") == 0) ? &sweep_opts.loading : NULL;
+            if (range == NULL) {
+                fprintf(stderr, "Error: Unknown sweep axis '%s' (use drones, charging or loading)\n", axis);
+                return 1;
+            }
+            if (!sweep_parse_range(argv[++i], range) || (range == &sweep_opts.drones && range->min < 1)) {
+                fprintf(stderr, "Error: Invalid range '%s' for --sweep-%s (use N, MIN:MAX or MIN:MAX:STEP)\n", argv[i], axis);
+                return 1;
+            }
+            sweep = true;
+            if (range == &sweep_opts.drones) sweep_drones = true;
+        } else if (strcmp(argv[i], "--sweep-format") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "csv") == 0) {
+                sweep_opts.format = SWEEP_CSV;
+            } else if (strcmp(argv[i], "json") == 0) {
+                sweep_opts.format = SWEEP_JSON;
+            } else {
+                fprintf(stderr, "Error: Unknown sweep format '%s' (use csv or json)\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+            deterministic = true;
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+            deterministic = true;
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+            deterministic = true;
+        } else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            checkpoint_path = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint-at") == 0 && i + 1 < argc) {
+            checkpoint_at = atoll(argv[++i]);
+            if (checkpoint_at < 0) {
+                fprintf(stderr, "Error: Checkpoint time must not be negative\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--restore") == 0 && i + 1 < argc) {
+            restore_path = argv[++i];
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            serve_path = argv[++i];
         } else if (strcmp(argv[i], "--help") == 0) {
             print_usage(argv[0]);
             return 0;
         }
     }
     
-    Simulation sim;
-    init_simulation(&sim, 0, num_charging, num_loading);
-    
-    if (use_stdin_config) {
-        char line[512];
-        int line_num = 0;
-        while (fgets(line, sizeof(line), stdin)) {
-            line_num++;
-            line[strcspn(line, "\n")] = 0;
-            
-            if (strlen(line) == 0 || line[0] == '#') {
-                continue;
-            }
-            
-            if (strncmp(line, "DRONE", 5) == 0) {
-                int speed, battery;
-                if (sscanf(line, "DRONE %d %d", &speed, &battery) == 2) {
-                    if (speed >= 1 && speed <= 3 && battery >= 20 && battery <= 100) {
-                        add_drone(&sim, speed, battery);
-                    } else {
-                        fprintf(stderr, "Warning: Invalid drone config at line %d (speed 1-3, battery 20-100)\n", line_num);
-                    }
-                } else {
-                    fprintf(stderr, "Warning: Malformed DRONE line %d\n", line_num);
-                }
-            } else if (strncmp(line, "TASK", 4) == 0) {
-                char *tokens[100];
-                int token_count = 0;
-                
-                char line_copy[512];
-                strncpy(line_copy, line + 5, sizeof(line_copy) - 1);
-                
-                char *token = strtok(line_copy, " ");
-                while (token != NULL && token_count < 100) {
-                    tokens[token_count++] = token;
-                    token = strtok(NULL, " ");
-                }
-                
-                if (token_count < 4) {
-                    fprintf(stderr, "Warning: Malformed TASK line %d (need: warehouse customer priority time)\n", line_num);
-                    continue;
-                }
-                
-                char warehouse[MAX_LOCATION_LEN];
-                char customer[MAX_LOCATION_LEN];
-                int priority, est_time;
-                
-                strncpy(warehouse, tokens[0], MAX_LOCATION_LEN - 1);
-                warehouse[MAX_LOCATION_LEN - 1] = '\0';
-                
-                priority = atoi(tokens[token_count - 2]);
-                est_time = atoi(tokens[token_count - 1]);
-                
-                customer[0] = '\0';
-                for (int i = 1; i < token_count - 2; i++) {
-                    if (i > 1) strcat(customer, " ");
-                    strncat(customer, tokens[i], MAX_LOCATION_LEN - strlen(customer) - 1);
-                }
-                
-                if (priority >= 1 && priority <= 3 && est_time >= 1 && est_time <= 100) {
-                    char source[MAX_LOCATION_LEN];
-                    snprintf(source, MAX_LOCATION_LEN, "Warehouse %s", warehouse);
-                    add_task(&sim, source, customer, priority, est_time);
-                } else {
-                    fprintf(stderr, "Warning: Invalid task config at line %d (priority 1-3, time 1-100)\n", line_num);
-                }
-            } else if (strncmp(line, "START", 5) == 0) {
-                break;
-            }
+    /* Each job carries its own configuration and settings. */
+    if (serve_path != NULL) {
+        if (use_stdin_config || config_path != NULL || use_legacy_mode || write_scenario_path != NULL ||
+            live_stdin || socket_path != NULL || use_workload || metrics_path != NULL || hubs || sweep ||
+            record_path != NULL || replay_path != NULL || checkpoint_path != NULL || restore_path != NULL) {
+            fprintf(stderr, "Error: --serve takes its configuration from each job and only combines with --workers\n");
+            return 1;
+        }
+        return run_server(serve_path, num_workers);
+    }
+    
+    if (sweep && (record_path != NULL || replay_path != NULL)) {
+        fprintf(stderr, "Error: --record and --replay cannot be combined with a sweep\n");
+        return 1;
+    }
+    
+    /* A trace only carries the scenario, not the generator's settings, the
+     * policy or the charging mode. */
+    if (use_workload && (record_path != NULL || replay_path != NULL)) {
+        fprintf(stderr, "Error: --workload cannot be combined with --record or --replay\n");
+        return 1;
+    }
+    if (policy != NULL && policy != policy_default() && (record_path != NULL || replay_path != NULL)) {
+        fprintf(stderr, "Error: --policy cannot be combined with --record or --replay\n");
+        return 1;
+    }
+    if (full_charge && (record_path != NULL || replay_path != NULL)) {
+        fprintf(stderr, "Error: --full-charge cannot be combined with --record or --replay\n");
+        return 1;
+    }
+    if (use_workload && workload_opts.seed == 0) workload_opts.seed = deterministic ? seed : 1;
+    
+    /* Live input feeds the real-time engine; a deterministic run has to know
+     * its inputs up front. */
+    bool live = live_stdin || socket_path != NULL;
+    if (live && (engine != ENGINE_THREADS || deterministic || sweep)) {
+        fprintf(stderr, "Error: --live and --socket need the threads engine and cannot be combined with --seed, --record, --replay or a sweep\n");
+        return 1;
+    }
+    if (metrics_path != NULL && (engine != ENGINE_THREADS || deterministic || sweep)) {
+        fprintf(stderr, "Error: --metrics needs the threads engine and cannot be combined with --seed, --record, --replay or a sweep\n");
+        return 1;
+    }
+    if (hubs && (sweep || live || use_workload || metrics_path != NULL || record_path != NULL || replay_path != NULL)) {
+        fprintf(stderr, "Error: --hubs cannot be combined with a sweep, --live, --socket, --workload, --metrics, --record or --replay\n");
+        return 1;
+    }
+    /* Checkpoints hold the virtual clock's state, so they belong to single
+     * discrete-event runs; a restored run takes its workload, stations and
+     * (unless overridden) policy and seed from the file. */
+    bool checkpointing = checkpoint_path != NULL || restore_path != NULL;
+    if (checkpointing && (sweep || hubs || live || metrics_path != NULL || record_path != NULL || replay_path != NULL)) {
+        fprintf(stderr, "Error: --checkpoint and --restore cannot be combined with a sweep, --hubs, --live, --socket, --metrics, --record or --replay\n");
+        return 1;
+    }
+    if (checkpoint_path != NULL && restore_path == NULL && engine != ENGINE_DES && !deterministic) {
+        fprintf(stderr, "Error: --checkpoint needs the discrete-event engine (--engine des or --seed)\n");
+        return 1;
+    }
+    if (restore_path != NULL && use_workload) {
+        fprintf(stderr, "Error: --workload cannot be combined with --restore; the checkpoint carries its workload\n");
+        return 1;
+    }
+    if (checkpoint_at >= 0 && checkpoint_path == NULL) {
+        fprintf(stderr, "Error: --checkpoint-at needs --checkpoint\n");
+        return 1;
+    }
+    if (checkpoint_at < 0) checkpoint_at = duration;
+    if (checkpoint_path != NULL && checkpoint_at > duration) {
+        fprintf(stderr, "Error: --checkpoint-at must not be past --duration\n");
+        return 1;
+    }
+    if (live_stdin && !use_stdin_config) {
+        fprintf(stderr, "Error: --live reads stdin and needs --config stdin\n");
+        return 1;
+    }
+    
+    Scenario scenario;
+    scenario_init(&scenario);
+    Trace trace;
+    
+    if (replay_path != NULL) {
+        /* The trace carries its own inputs; the command line only picks the output. */
+        TraceHeader header;
+        if (!trace_replay_open(&trace, replay_path, &header, &scenario)) {
+            fprintf(stderr, "Error: Cannot read trace '%s'\n", replay_path);
+            scenario_destroy(&scenario);
+            return 1;
+        }
+        seed = header.seed;
+        num_charging = header.num_charging;
+        num_loading = header.num_loading;
+        duration = header.duration;
+    } else if (use_stdin_config || config_path != NULL) {
+        bool ok = config_path != NULL ? scenario_load(&scenario, config_path) : scenario_read(&scenario, stdin);
+        if (!ok) {
+            fprintf(stderr, "Error: Cannot read scenario '%s'\n", config_path != NULL ? config_path : "stdin");
+            scenario_destroy(&scenario);
+            return 1;
         }
+    } else if (restore_path != NULL) {
+        /* The checkpoint carries the fleet and the tasks. */
     } else if (use_legacy_mode) {
         int drone_speeds[] = {1, 2, 1, 2, 1};
         int drone_batteries[] = {100, 80, 90, 100, 75};
         
         for (int i = 0; i < num_drones && i < 5; i++) {
-            add_drone(&sim, drone_speeds[i], drone_batteries[i]);
+            scenario_add_drone(&scenario, drone_speeds[i], drone_batteries[i]);
         }
         for (int i = 5; i < num_drones; i++) {
-            add_drone(&sim, 1 + (i % 2), 80 + (i % 21));
+            scenario_add_drone(&scenario, 1 + (i % 2), 80 + (i % 21));
         }
         
-        add_task(&sim, "Warehouse A", "Customer 101", 2, 10);
-        add_task(&sim, "Warehouse B", "Customer 102", 3, 8);
-        add_task(&sim, "Warehouse A", "Customer 103", 1, 12);
-        add_task(&sim, "Warehouse C", "Customer 104", 2, 15);
-        add_task(&sim, "Warehouse B", "Customer 105", 3, 7);
+        /* A generated workload replaces the fixed demo tasks. */
+        if (!use_workload) {
+            scenario_add_task(&scenario, "Warehouse A", "Customer 101", 2, 10);
+            scenario_add_task(&scenario, "Warehouse B", "Customer 102", 3, 8);
+            scenario_add_task(&scenario, "Warehouse A", "Customer 103", 1, 12);
+            scenario_add_task(&scenario, "Warehouse C", "Customer 104", 2, 15);
+            scenario_add_task(&scenario, "Warehouse B", "Customer 105", 3, 7);
+        }
     } else {
-        fprintf(stderr, "Error: Either use --drones or --config stdin\n");
+        fprintf(stderr, "Error: Either use --drones or --config <stdin|file>\n");
         print_usage(argv[0]);
         return 1;
     }
     
-    if (sim.num_drones == 0) {
+    if (restore_path != NULL) {
+        SimOptions overrides = {
+            .output = output,
+            .deterministic = deterministic,
+            .seed = seed,
+            .quiet_setup = quiet_setup,
+            .policy = policy,
+            .full_charge = full_charge
+        };
+        int status = run_restored(restore_path, &scenario, &overrides, duration, checkpoint_path, checkpoint_at);
+        scenario_destroy(&scenario);
+        return status;
+    }
+    
+    if (scenario.num_drones == 0 && !sweep_drones) {
         fprintf(stderr, "Error: No drones configured. Please add at least one drone.\n");
+        scenario_destroy(&scenario);
         return 1;
     }
     
-    pthread_mutex_lock(&sim.task_queue.mutex);
-    int task_count = sim.task_queue.size;
-    pthread_mutex_unlock(&sim.task_queue.mutex);
-    
-    if (task_count == 0) {
+    if (scenario.num_tasks == 0 && !use_workload) {
         fprintf(stderr, "Error: No tasks configured. Please add at least one task.\n");
+        scenario_destroy(&scenario);
         return 1;
     }
     
-    start_simulation(&sim);
-    sleep(duration);
-    stop_simulation(&sim);
+    if (write_scenario_path != NULL) {
+        FILE *out = fopen(write_scenario_path, "wb");
+        bool ok = out != NULL && scenario_write_binary(&scenario, out);
+        if (out != NULL && fclose(out) != 0) ok = false;
+        if (!ok) fprintf(stderr, "Error: Cannot write scenario '%s'\n", write_scenario_path);
+        scenario_destroy(&scenario);
+        return ok ? 0 : 1;
+    }
+    
+    if (hubs) {
+        HubOptions hub_opts = {
+            .num_charging = num_charging,
+            .num_loading = num_loading,
+            .duration = duration,
+            .threads = num_workers,
+            .steal_interval = hub_steal,
+            .deterministic = deterministic,
+            .seed = seed,
+            .policy = policy,
+            .full_charge = full_charge
+        };
+        HubSummary summary;
+        hub_run(&scenario, &hub_opts, stdout, &summary);
+        scenario_destroy(&scenario);
+        return 0;
+    }
+    
+    if (sweep) {
+        /* Axes that are not swept stay at their single-run values. */
+        if (!sweep_drones) {
+            sweep_opts.drones = (SweepRange){ scenario.num_drones, scenario.num_drones, 1 };
+        }
+        if (sweep_opts.charging.step == 0) {
+            sweep_opts.charging = (SweepRange){ num_charging, num_charging, 1 };
+        }
+        if (sweep_opts.loading.step == 0) {
+            sweep_opts.loading = (SweepRange){ num_loading, num_loading, 1 };
+        }
+        sweep_opts.duration = duration;
+        sweep_opts.threads = num_workers;
+        sweep_opts.deterministic = deterministic;
+        sweep_opts.seed = seed;
+        sweep_opts.workload = use_workload ? &workload_opts : NULL;
+        sweep_opts.full_charge = full_charge;
+        if (sweep_opts.num_policies == 0 && policy != NULL) {
+            sweep_opts.policies[0] = policy;
+            sweep_opts.num_policies = 1;
+        }
+        sweep_run(&scenario, &sweep_opts, stdout);
+        scenario_destroy(&scenario);
+        return 0;
+    }
+    
+    if (record_path != NULL) {
+        TraceHeader header = {
+            .seed = seed,
+            .num_charging = num_charging,
+            .num_loading = num_loading,
+            .duration = duration
+        };
+        if (!trace_record_open(&trace, record_path, &header, &scenario)) {
+            fprintf(stderr, "Error: Cannot write trace '%s'\n", record_path);
+            scenario_destroy(&scenario);
+            return 1;
+        }
+    }
+    
+    SimOptions options = {
+        .num_drones = scenario.num_drones,
+        .num_charging = num_charging,
+        .num_loading = num_loading,
+        .engine = engine,
+        .output = output,
+        .deterministic = deterministic,
+        .seed = seed,
+        .quiet_setup = quiet_setup,
+        .policy = policy,
+        .full_charge = full_charge
+    };
+    Simulation sim;
+    init_simulation_with_options(&sim, &options);
+    sim.num_workers = num_workers;
+    if (record_path != NULL || replay_path != NULL) sim.trace = &trace;
+    scenario_populate(&scenario, &sim, 0);
+    Workload workload;
+    if (use_workload) {
+        workload_init(&workload, &sim, &workload_opts);
+        sim.workload = &workload;
+    }
+    
+    bool checkpoint_ok = true;
+    if (sim.engine == ENGINE_DES) {
+        scenario_destroy(&scenario);
+        DesEngine des;
+        des_start(&des, &sim, duration);
+        checkpoint_ok = run_des(&des, duration, checkpoint_path, checkpoint_at);
+    } else {
+        LiveInput live_input;
+        MetricsExporter metrics;
+        start_simulation(&sim);
+        bool metrics_ok = metrics_path == NULL || metrics_export_start(&metrics, &sim, metrics_path, metrics_interval_ms);
+        bool live_ok = metrics_ok && (!live || live_input_start(&live_input, &sim, live_stdin, socket_path,
+                                                                scenario.unread, scenario.unread_len));
+        scenario_destroy(&scenario);
+        if (!live_ok) {
+            stop_simulation(&sim);
+            if (metrics_ok && metrics_path != NULL) metrics_export_stop(&metrics);
+            free_simulation(&sim);
+            return 1;
+        }
+        sleep(duration);
+        if (live) live_input_stop(&live_input);
+        stop_simulation(&sim);
+        if (metrics_path != NULL) metrics_export_stop(&metrics);
+    }
     print_statistics(&sim);
+    free_simulation(&sim);
+    if (use_workload) workload_destroy(&workload);
     
-    return 0;
+    if (sim.trace != NULL && !trace_close(&trace)) {
+        return 1;
+    }
+    return checkpoint_ok ? 0 : 1;
 }
@@ -0,0 +1,29 @@
+#include "metrics.h"
+
+void metrics_init(SimMetrics *metrics) {
+    for (int i = 0; i < METRIC_DRONE_STATES; i++) atomic_init(&metrics->drones[i], 0);
+    atomic_init(&metrics->loading_bays.in_use, 0);
+    atomic_init(&metrics->loading_bays.queued, 0);
+    atomic_init(&metrics->charging_stations.in_use, 0);
+    atomic_init(&metrics->charging_stations.queued, 0);
+    atomic_init(&metrics->tasks_added, 0);
+    atomic_init(&metrics->tasks_assigned, 0);
+    atomic_init(&metrics->tasks_completed, 0);
+    atomic_init(&metrics->preemptions, 0);
+}
+
+void metrics_count(atomic_ullong *counter, unsigned long long n) {
+    atomic_fetch_add_explicit(counter, n, memory_order_relaxed);
+}
+
+void metrics_gauge_add(atomic_int *gauge, int delta) {
+    atomic_fetch_add_explicit(gauge, delta, memory_order_relaxed);
+}
+
+int metrics_gauge(atomic_int *gauge) {
+    return atomic_load_explicit(gauge, memory_order_relaxed);
+}
+
+unsigned long long metrics_counter(atomic_ullong *counter) {
+    return atomic_load_explicit(counter, memory_order_relaxed);
+}
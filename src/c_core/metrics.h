@@ -0,0 +1,35 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdatomic.h>
+
+#define METRIC_DRONE_STATES 5
+
+/* Units of a loading bay or charging station pool in use, and entries in
+ * its wait queue. A drone preempted while queued keeps its entry until the
+ * queue skips it on the next hand-off. */
+typedef struct {
+    atomic_int in_use;
+    atomic_int queued;
+} ResourceGauge;
+
+/* Live counters and gauges for one simulation. Each is a relaxed atomic
+ * updated where the event happens, so no update takes a lock; a reader
+ * sees every value exact on its own, but not one consistent snapshot. */
+typedef struct {
+    atomic_int drones[METRIC_DRONE_STATES];
+    ResourceGauge loading_bays;
+    ResourceGauge charging_stations;
+    atomic_ullong tasks_added;
+    atomic_ullong tasks_assigned;
+    atomic_ullong tasks_completed;
+    atomic_ullong preemptions;
+} SimMetrics;
+
+void metrics_init(SimMetrics *metrics);
+void metrics_count(atomic_ullong *counter, unsigned long long n);
+void metrics_gauge_add(atomic_int *gauge, int delta);
+int metrics_gauge(atomic_int *gauge);
+unsigned long long metrics_counter(atomic_ullong *counter);
+
+#endif
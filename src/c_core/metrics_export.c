@@ -0,0 +1,180 @@
+#include "metrics_export.h"
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define METRICS_BUFFER_SIZE 4096
+
+static const char *state_labels[METRIC_DRONE_STATES] = { "idle", "loading", "delivering", "charging", "preempted" };
+static const char *resource_labels[2] = { "loading_bay", "charging_station" };
+
+static long long metrics_clock_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t used;
+} MetricsText;
+
+static void metrics_append(MetricsText *text, const char *format, ...) {
+    if (text->used >= text->size) return;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(text->buf + text->used, text->size - text->used, format, args);
+    va_end(args);
+    if (n > 0) text->used += (size_t)n;
+    if (text->used > text->size) text->used = text->size;
+}
+
+static void metrics_header(MetricsText *text, const char *name, const char *type, const char *help) {
+    metrics_append(text, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+/* Renders one snapshot into `buf` and returns its length (cut short if
+ * `size` is too small). Throughput is completions per second of wall time
+ * since the previous snapshot. */
+size_t metrics_format(MetricsExporter *ex, char *buf, size_t size) {
+    Simulation *sim = ex->sim;
+    SimMetrics *m = &sim->metrics;
+    MetricsText text = { buf, size, 0 };
+
+    long long now = metrics_clock_us();
+    unsigned long long completed = metrics_counter(&m->tasks_completed);
+    double throughput = now > ex->last_us ? (completed - ex->last_completed) * 1e6 / (now - ex->last_us) : 0.0;
+    ex->last_us = now;
+    ex->last_completed = completed;
+
+    metrics_header(&text, "drone_sim_queue_depth", "gauge", "Tasks waiting for a drone, by priority.");
+    for (int p = 0; p < PQ_PRIORITY_LEVELS; p++) {
+        metrics_append(&text, "drone_sim_queue_depth{priority=\"%d\"} %d\n", p + 1,
+                       atomic_load_explicit(&sim->task_queue.lanes[p].size, memory_order_relaxed));
+    }
+
+    metrics_header(&text, "drone_sim_drones", "gauge", "Drones by state.");
+    for (int s = 0; s < METRIC_DRONE_STATES; s++) {
+        metrics_append(&text, "drone_sim_drones{state=\"%s\"} %d\n", state_labels[s], metrics_gauge(&m->drones[s]));
+    }
+
+    ResourceGauge *gauges[2] = { &m->loading_bays, &m->charging_stations };
+    int capacities[2] = { sim->num_loading_bays, sim->num_charging_stations };
+    metrics_header(&text, "drone_sim_resource_capacity", "gauge", "Loading bays and charging stations.");
+    for (int r = 0; r < 2; r++) {
+        metrics_append(&text, "drone_sim_resource_capacity{resource=\"%s\"} %d\n", resource_labels[r], capacities[r]);
+    }
+    metrics_header(&text, "drone_sim_resource_in_use", "gauge", "Loading bays and charging stations held by a drone.");
+    for (int r = 0; r < 2; r++) {
+        metrics_append(&text, "drone_sim_resource_in_use{resource=\"%s\"} %d\n", resource_labels[r],
+                       metrics_gauge(&gauges[r]->in_use));
+    }
+    metrics_header(&text, "drone_sim_resource_waiters", "gauge", "Drones queued for a loading bay or charging station.");
+    for (int r = 0; r < 2; r++) {
+        metrics_append(&text, "drone_sim_resource_waiters{resource=\"%s\"} %d\n", resource_labels[r],
+                       metrics_gauge(&gauges[r]->queued));
+    }
+
+    metrics_header(&text, "drone_sim_tasks_added_total", "counter", "Tasks added to the simulation.");
+    metrics_append(&text, "drone_sim_tasks_added_total %llu\n", metrics_counter(&m->tasks_added));
+    metrics_header(&text, "drone_sim_tasks_assigned_total", "counter", "Task assignments, including reassignments after preemption.");
+    metrics_append(&text, "drone_sim_tasks_assigned_total %llu\n", metrics_counter(&m->tasks_assigned));
+    metrics_header(&text, "drone_sim_tasks_completed_total", "counter", "Tasks delivered.");
+    metrics_append(&text, "drone_sim_tasks_completed_total %llu\n", completed);
+    metrics_header(&text, "drone_sim_preemptions_total", "counter", "Tasks preempted by an urgent task.");
+    metrics_append(&text, "drone_sim_preemptions_total %llu\n", metrics_counter(&m->preemptions));
+
+    metrics_header(&text, "drone_sim_throughput_tasks_per_second", "gauge", "Deliveries per second since the previous snapshot.");
+    metrics_append(&text, "drone_sim_throughput_tasks_per_second %.3f\n", throughput);
+    metrics_header(&text, "drone_sim_uptime_seconds", "gauge", "Seconds since the exporter started.");
+    metrics_append(&text, "drone_sim_uptime_seconds %.3f\n", (now - ex->started_us) / 1e6);
+    return text.used;
+}
+
+static bool metrics_write(MetricsExporter *ex) {
+    char buf[METRICS_BUFFER_SIZE];
+    size_t len = metrics_format(ex, buf, sizeof(buf));
+
+    FILE *out = fopen(ex->tmp_path, "w");
+    if (out == NULL) return false;
+    bool ok = fwrite(buf, 1, len, out) == len;
+    if (fclose(out) != 0) ok = false;
+    if (ok && rename(ex->tmp_path, ex->path) != 0) ok = false;
+    if (!ok) remove(ex->tmp_path);
+    if (ok) ex->snapshots++;
+    return ok;
+}
+
+static void *metrics_thread(void *arg) {
+    MetricsExporter *ex = (MetricsExporter *)arg;
+
+    pthread_mutex_lock(&ex->mutex);
+    while (ex->running) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        long long ns = deadline.tv_nsec + ex->interval_ms * 1000000LL;
+        deadline.tv_sec += ns / 1000000000LL;
+        deadline.tv_nsec = ns % 1000000000LL;
+        int rc = 0;
+        while (ex->running && rc != ETIMEDOUT) rc = pthread_cond_timedwait(&ex->wakeup, &ex->mutex, &deadline);
+        if (!ex->running) break;
+
+        pthread_mutex_unlock(&ex->mutex);
+        if (!metrics_write(ex) && !ex->failed) {
+            fprintf(stderr, "Error: Cannot write metrics to '%s': %s\n", ex->path, strerror(errno));
+            ex->failed = true;
+        }
+        pthread_mutex_lock(&ex->mutex);
+    }
+    pthread_mutex_unlock(&ex->mutex);
+    return NULL;
+}
+
+/* Writes a first snapshot straight away, so a bad path fails the start. */
+bool metrics_export_start(MetricsExporter *ex, Simulation *sim, const char *path, int interval_ms) {
+    ex->sim = sim;
+    ex->path = path;
+    ex->tmp_path = (char *)malloc(strlen(path) + 5);
+    sprintf(ex->tmp_path, "%s.tmp", path);
+    ex->interval_ms = interval_ms;
+    ex->started_us = metrics_clock_us();
+    ex->last_us = ex->started_us;
+    ex->last_completed = 0;
+    ex->snapshots = 0;
+    ex->failed = false;
+
+    if (!metrics_write(ex)) {
+        fprintf(stderr, "Error: Cannot write metrics to '%s': %s\n", path, strerror(errno));
+        free(ex->tmp_path);
+        return false;
+    }
+
+    pthread_mutex_init(&ex->mutex, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&ex->wakeup, &attr);
+    pthread_condattr_destroy(&attr);
+    ex->running = true;
+    pthread_create(&ex->thread, NULL, metrics_thread, ex);
+    return true;
+}
+
+/* Stops the thread and writes a final snapshot; the file is left behind. */
+void metrics_export_stop(MetricsExporter *ex) {
+    pthread_mutex_lock(&ex->mutex);
+    ex->running = false;
+    pthread_cond_signal(&ex->wakeup);
+    pthread_mutex_unlock(&ex->mutex);
+    pthread_join(ex->thread, NULL);
+
+    metrics_write(ex);
+    log_event(ex->sim, "[Metrics] %llu snapshots written to %s", ex->snapshots, ex->path);
+    pthread_cond_destroy(&ex->wakeup);
+    pthread_mutex_destroy(&ex->mutex);
+    free(ex->tmp_path);
+}
@@ -0,0 +1,32 @@
+#ifndef METRICS_EXPORT_H
+#define METRICS_EXPORT_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "drone_scheduler.h"
+
+/* Writes the simulation's metrics in the Prometheus text format to `path`
+ * every `interval_ms`, from its own thread. Each snapshot goes to a
+ * temporary file renamed over `path`, so a reader never sees half of one. */
+typedef struct {
+    Simulation *sim;
+    const char *path;
+    char *tmp_path;
+    int interval_ms;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t wakeup;
+    bool running;
+    long long started_us;
+    long long last_us;
+    unsigned long long last_completed;
+    unsigned long long snapshots;
+    bool failed;
+} MetricsExporter;
+
+size_t metrics_format(MetricsExporter *ex, char *buf, size_t size);
+bool metrics_export_start(MetricsExporter *ex, Simulation *sim, const char *path, int interval_ms);
+void metrics_export_stop(MetricsExporter *ex);
+
+#endif
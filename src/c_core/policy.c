@@ -0,0 +1,79 @@
+#include "policy.h"
+#include <string.h>
+
+/* Delivery deadlines by priority for earliest-deadline-first, in seconds
+ * from when the task was added. */
+static const long long deadline_s[PQ_PRIORITY_LEVELS] = { 60, 300, 900 };
+
+static int policy_priority(const Task *task) {
+    if (task->priority < 1) return 1;
+    return task->priority > PQ_PRIORITY_LEVELS ? PQ_PRIORITY_LEVELS : task->priority;
+}
+
+static long long edf_key(const Simulation *sim, const Task *task) {
+    return task->created_at + deadline_s[policy_priority(task) - 1] * 1000000LL;
+}
+
+/* Seconds a speed-1 drone needs from pickup to drop-off. */
+static long long sjf_key(const Simulation *sim, const Task *task) {
+    if (task->located) {
+        Point pickup, dropoff;
+        lt_position(&sim->locations, task->source, &pickup);
+        lt_position(&sim->locations, task->destination, &dropoff);
+        return (long long)(point_distance(pickup, dropoff) / FLIGHT_METRES_PER_SECOND);
+    }
+    return task->estimated_time;
+}
+
+/* A task gains one priority level per POLICY_AGING_STEP_S it has waited,
+ * so a priority-3 task queued two steps ago ranks with a fresh urgent one.
+ * A preempted task starts waiting again when it is requeued. */
+static long long aging_key(const Simulation *sim, const Task *task) {
+    return task->enqueued_at + (policy_priority(task) - 1) * POLICY_AGING_STEP_S * 1000000LL;
+}
+
+const SchedPolicy scheduling_policies[] = {
+    { "priority", "strict priority, FIFO within a priority; urgent tasks preempt priority 2/3 work", NULL, true },
+    { "edf", "earliest deadline first (deadline 60/300/900 s after the task is added by priority)", edf_key, true },
+    { "sjf", "shortest job first by pickup-to-drop-off time", sjf_key, true },
+    { "aging", "priority that rises one level per 60 s of waiting", aging_key, true },
+    { "no-preempt", "strict priority without preemption", NULL, false },
+};
+const int num_scheduling_policies = sizeof(scheduling_policies) / sizeof(scheduling_policies[0]);
+
+const SchedPolicy *policy_default(void) {
+    return &scheduling_policies[0];
+}
+
+const SchedPolicy *policy_find(const char *name) {
+    for (int i = 0; i < num_scheduling_policies; i++) {
+        if (strcmp(scheduling_policies[i].name, name) == 0) return &scheduling_policies[i];
+    }
+    return NULL;
+}
+
+/* Parses "all" or a comma-separated list of names; returns the count, or
+ * -1 for an unknown name or more than `max`. */
+int policy_parse_list(const char *text, const SchedPolicy **out, int max) {
+    if (strcmp(text, "all") == 0) {
+        if (num_scheduling_policies > max) return -1;
+        for (int i = 0; i < num_scheduling_policies; i++) out[i] = &scheduling_policies[i];
+        return num_scheduling_policies;
+    }
+
+    int count = 0;
+    const char *start = text;
+    for (;;) {
+        const char *end = strchr(start, ',');
+        size_t len = end != NULL ? (size_t)(end - start) : strlen(start);
+        const SchedPolicy *found = NULL;
+        for (int i = 0; i < num_scheduling_policies; i++) {
+            const char *name = scheduling_policies[i].name;
+            if (strlen(name) == len && strncmp(name, start, len) == 0) found = &scheduling_policies[i];
+        }
+        if (found == NULL || count == max) return -1;
+        out[count++] = found;
+        if (end == NULL) return count;
+        start = end + 1;
+    }
+}
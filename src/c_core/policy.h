@@ -0,0 +1,32 @@
+#ifndef POLICY_H
+#define POLICY_H
+
+#include <stdbool.h>
+#include "drone_scheduler.h"
+
+#define POLICY_AGING_STEP_S 60
+#define POLICY_MAX 8
+
+/* How the dispatcher orders queued tasks and whether an urgent task may
+ * take a drone from a less urgent one. With no `task_key`, tasks leave in
+ * strict priority order, FIFO within a priority, straight from the
+ * lock-free lanes. Otherwise the dispatcher moves them into a heap and
+ * dispatches the smallest key first (ties in priority, then arrival
+ * order). The key is computed once, when the task is queued or requeued.
+ * Whatever the order, a drone is picked the same way: nearest for a
+ * located task, else the idle drone with the most battery. */
+typedef struct SchedPolicy {
+    const char *name;
+    const char *description;
+    long long (*task_key)(const Simulation *sim, const Task *task);
+    bool preempt;
+} SchedPolicy;
+
+extern const SchedPolicy scheduling_policies[];
+extern const int num_scheduling_policies;
+
+const SchedPolicy *policy_default(void);
+const SchedPolicy *policy_find(const char *name);
+int policy_parse_list(const char *text, const SchedPolicy **out, int max);
+
+#endif
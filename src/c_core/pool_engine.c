@@ -0,0 +1,126 @@
+#include "pool_engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static void pool_schedule(void *ctx, int drone, SimEventType type, unsigned int generation, long long delay_us) {
+    PoolEngine *pool = (PoolEngine *)ctx;
+    long long due = sim_clock_us(pool->sim) + delay_us;
+
+    pthread_mutex_lock(&pool->mutex);
+    eq_push(&pool->timers, due, type, drone, generation);
+    pthread_cond_signal(&pool->wakeup);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static void pool_wake_scheduler(void *ctx) {
+    PoolEngine *pool = (PoolEngine *)ctx;
+    scheduler_notify(pool->sim);
+}
+
+static struct timespec pool_deadline(long long us) {
+    struct timespec ts;
+    ts.tv_sec = us / 1000000LL;
+    ts.tv_nsec = (us % 1000000LL) * 1000;
+    return ts;
+}
+
+/* Pops the earliest timer once it is due and runs that drone's transition.
+ * The heap lock is dropped before taking fleet_mutex: hooks fired from inside
+ * a transition take the locks in the opposite order. */
+static void *pool_worker_func(void *arg) {
+    PoolEngine *pool = (PoolEngine *)arg;
+    Simulation *sim = pool->sim;
+
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->running) {
+        const SimEvent *next = eq_peek(&pool->timers);
+        if (next == NULL) {
+            pthread_cond_wait(&pool->wakeup, &pool->mutex);
+            continue;
+        }
+
+        long long now = sim_clock_us(sim);
+        if (next->time > now) {
+            struct timespec deadline = pool_deadline(next->time);
+            pthread_cond_timedwait(&pool->wakeup, &pool->mutex, &deadline);
+            continue;
+        }
+
+        SimEvent ev;
+        eq_pop(&pool->timers, &ev);
+        pthread_mutex_unlock(&pool->mutex);
+
+        pthread_mutex_lock(&sim->fleet_mutex);
+        if (sim->simulation_running && fsm_is_current(&pool->fsm, ev.drone, ev.generation)) {
+            fsm_handle(&pool->fsm, ev.drone, ev.type);
+        }
+        pthread_mutex_unlock(&sim->fleet_mutex);
+
+        pthread_mutex_lock(&pool->mutex);
+        pool->steps++;
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+void pool_engine_start(PoolEngine *pool, Simulation *sim, int num_workers) {
+    if (num_workers < 1) num_workers = 1;
+
+    pool->sim = sim;
+    pool->num_workers = num_workers;
+    pool->running = true;
+    pool->steps = 0;
+    eq_init(&pool->timers);
+    pthread_mutex_init(&pool->mutex, NULL);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&pool->wakeup, &attr);
+    pthread_condattr_destroy(&attr);
+
+    FsmHooks hooks = { pool, pool_schedule, pool_wake_scheduler };
+    fsm_init(&pool->fsm, sim, hooks);
+    sim->fsm = &pool->fsm;
+
+    log_event(sim, ANSI_COLOR_MAGENTA "[Engine] Worker pool: %d workers driving %d drones" ANSI_COLOR_RESET,
+             num_workers, sim->num_drones);
+
+    pthread_mutex_lock(&sim->fleet_mutex);
+    fsm_start(&pool->fsm);
+    pthread_mutex_unlock(&sim->fleet_mutex);
+
+    pool->workers = (pthread_t *)malloc(sizeof(pthread_t) * num_workers);
+    for (int i = 0; i < num_workers; i++) {
+        pthread_create(&pool->workers[i], NULL, pool_worker_func, pool);
+    }
+}
+
+/* Joins the workers and settles drones caught mid-phase. The scheduler thread
+ * must already be stopped, since it calls into the state machine. */
+void pool_engine_stop(PoolEngine *pool) {
+    Simulation *sim = pool->sim;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->running = false;
+    pthread_cond_broadcast(&pool->wakeup);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < pool->num_workers; i++) {
+        pthread_join(pool->workers[i], NULL);
+    }
+    free(pool->workers);
+    pool->workers = NULL;
+
+    pthread_mutex_lock(&sim->fleet_mutex);
+    fsm_settle(&pool->fsm);
+    pthread_mutex_unlock(&sim->fleet_mutex);
+
+    log_event(sim, "[Engine] %d workers processed %llu timer events", pool->num_workers, pool->steps);
+
+    sim->fsm = NULL;
+    fsm_destroy(&pool->fsm);
+    eq_destroy(&pool->timers);
+    pthread_cond_destroy(&pool->wakeup);
+    pthread_mutex_destroy(&pool->mutex);
+}
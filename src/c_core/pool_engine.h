@@ -0,0 +1,26 @@
+#ifndef POOL_ENGINE_H
+#define POOL_ENGINE_H
+
+#include "drone_scheduler.h"
+#include "drone_fsm.h"
+#include "event_queue.h"
+
+/* Real-time engine: a fixed set of worker threads drives every drone's state
+ * machine off one shared timer heap, so the thread count (and stack memory)
+ * depends on the core count rather than the fleet size. */
+typedef struct PoolEngine {
+    Simulation *sim;
+    DroneFsm fsm;
+    EventQueue timers;
+    pthread_mutex_t mutex;
+    pthread_cond_t wakeup;
+    pthread_t *workers;
+    int num_workers;
+    bool running;
+    unsigned long long steps;
+} PoolEngine;
+
+void pool_engine_start(PoolEngine *pool, Simulation *sim, int num_workers);
+void pool_engine_stop(PoolEngine *pool);
+
+#endif
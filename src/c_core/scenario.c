@@ -0,0 +1,465 @@
+#include "scenario.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+void scenario_init(Scenario *sc) {
+    sc->drones = NULL;
+    sc->num_drones = 0;
+    sc->drone_capacity = 0;
+    sc->tasks = NULL;
+    sc->num_tasks = 0;
+    sc->task_capacity = 0;
+    lt_init(&sc->locations);
+    sc->chargers = NULL;
+    sc->num_chargers = 0;
+    sc->charger_capacity = 0;
+    sc->unread = NULL;
+    sc->unread_len = 0;
+}
+
+void scenario_add_drone(Scenario *sc, int speed, int battery) {
+    scenario_add_drone_at(sc, speed, battery, (Point){ 0, 0 });
+}
+
+void scenario_add_drone_at(Scenario *sc, int speed, int battery, Point position) {
+    if (sc->num_drones == sc->drone_capacity) {
+        sc->drone_capacity = sc->drone_capacity > 0 ? sc->drone_capacity * 2 : 16;
+        sc->drones = (DroneSpec *)realloc(sc->drones, sizeof(DroneSpec) * sc->drone_capacity);
+    }
+    sc->drones[sc->num_drones++] = (DroneSpec){ speed, battery, position };
+}
+
+void scenario_add_task(Scenario *sc, const char *source, const char *dest, int priority, int est_time) {
+    scenario_add_task_between(sc, lt_intern(&sc->locations, source, strnlen(source, MAX_LOCATION_LEN - 1)),
+                              lt_intern(&sc->locations, dest, strnlen(dest, MAX_LOCATION_LEN - 1)),
+                              priority, est_time);
+}
+
+void scenario_add_task_between(Scenario *sc, LocationId source, LocationId dest, int priority, int est_time) {
+    if (sc->num_tasks == sc->task_capacity) {
+        sc->task_capacity = sc->task_capacity > 0 ? sc->task_capacity * 2 : 16;
+        sc->tasks = (TaskSpec *)realloc(sc->tasks, sizeof(TaskSpec) * sc->task_capacity);
+    }
+    sc->tasks[sc->num_tasks++] = (TaskSpec){ source, dest, priority, est_time };
+}
+
+/* Names a point; a later entry with the same name wins. */
+void scenario_add_location(Scenario *sc, const char *name, Point position) {
+    LocationId id = lt_intern(&sc->locations, name, strnlen(name, MAX_LOCATION_LEN - 1));
+    lt_place(&sc->locations, id, position);
+}
+
+void scenario_add_charger(Scenario *sc, Point position) {
+    if (sc->num_chargers == sc->charger_capacity) {
+        sc->charger_capacity = sc->charger_capacity > 0 ? sc->charger_capacity * 2 : 8;
+        sc->chargers = (Point *)realloc(sc->chargers, sizeof(Point) * sc->charger_capacity);
+    }
+    sc->chargers[sc->num_chargers++] = position;
+}
+
+/* A token of a config line: a range of the input, not a copy. */
+typedef struct {
+    const char *start;
+    int len;
+} Span;
+
+/* Splits [p, end) on spaces, as TASK and CUSTOMER lines always have. */
+static int split_spans(const char *p, const char *end, Span *tokens, int max_tokens) {
+    int count = 0;
+    while (count < max_tokens) {
+        while (p < end && *p == ' ') p++;
+        if (p == end) break;
+        const char *start = p;
+        while (p < end && *p != ' ') p++;
+        tokens[count++] = (Span){ start, (int)(p - start) };
+    }
+    return count;
+}
+
+/* Joins tokens[first..last) with single spaces into a name. */
+static int join_spans(char *out, const Span *tokens, int first, int last) {
+    int len = 0;
+    for (int i = first; i < last && len < MAX_LOCATION_LEN - 1; i++) {
+        if (i > first) out[len++] = ' ';
+        int n = tokens[i].len;
+        if (n > MAX_LOCATION_LEN - 1 - len) n = MAX_LOCATION_LEN - 1 - len;
+        memcpy(out + len, tokens[i].start, n);
+        len += n;
+    }
+    out[len] = '\0';
+    return len;
+}
+
+/* Reads an int the way sscanf's %d does: leading blanks, an optional sign
+ * and at least one digit. Works on ranges, so the input need not end in a
+ * NUL (the last line of a mapped file does not). */
+static bool scan_int(const char **p, const char *end, int *value) {
+    const char *q = *p;
+    while (q < end && (*q == ' ' || *q == '\t')) q++;
+    bool negative = (q < end && (*q == '-' || *q == '+')) ? (*q++ == '-') : false;
+    if (q == end || *q < '0' || *q > '9') return false;
+    long long v = 0;
+    while (q < end && *q >= '0' && *q <= '9') {
+        if (v < 1000000000LL) v = v * 10 + (*q - '0');
+        q++;
+    }
+    *value = (int)(negative ? -v : v);
+    *p = q;
+    return true;
+}
+
+/* Same for %lf; the number is copied out so strtod sees a NUL. */
+static bool scan_double(const char **p, const char *end, double *value) {
+    const char *q = *p;
+    while (q < end && (*q == ' ' || *q == '\t')) q++;
+    char buf[64];
+    int len = 0;
+    while (q + len < end && len < (int)sizeof(buf) - 1 && q[len] != ' ' && q[len] != '\t') {
+        buf[len] = q[len];
+        len++;
+    }
+    buf[len] = '\0';
+    char *parsed;
+    *value = strtod(buf, &parsed);
+    if (parsed == buf) return false;
+    *p = q + (parsed - buf);
+    return true;
+}
+
+/* A whole token as a number, for CUSTOMER coordinates. */
+static bool span_double(Span token, double *value) {
+    const char *p = token.start;
+    return scan_double(&p, token.start + token.len, value) && p == token.start + token.len;
+}
+
+static int span_int(Span token) {
+    int value = 0;
+    const char *p = token.start;
+    scan_int(&p, token.start + token.len, &value);
+    return value;
+}
+
+static bool starts_with(const char *line, size_t len, const char *keyword, size_t keyword_len) {
+    return len >= keyword_len && memcmp(line, keyword, keyword_len) == 0;
+}
+
+/* Parses one line (without its newline). Returns false at START. */
+static bool scenario_parse_line(Scenario *sc, const char *line, const char *end, int line_num) {
+    size_t len = (size_t)(end - line);
+    if (len == 0 || line[0] == '#') return true;
+    
+    if (starts_with(line, len, "DRONE", 5)) {
+        int speed = 0, battery = 0;
+        Point position = { 0, 0 };
+        const char *p = line + 5;
+        int fields = 0;
+        if (scan_int(&p, end, &speed)) fields++;
+        if (fields == 1 && scan_int(&p, end, &battery)) fields++;
+        if (fields == 2 && scan_double(&p, end, &position.x)) fields++;
+        if (fields == 3 && scan_double(&p, end, &position.y)) fields++;
+        if (fields == 2 || fields == 4) {
+            if (speed >= 1 && speed <= 3 && battery >= 20 && battery <= 100) {
+                scenario_add_drone_at(sc, speed, battery, fields == 4 ? position : (Point){ 0, 0 });
+            } else {
+                fprintf(stderr, "Warning: Invalid drone config at line %d (speed 1-3, battery 20-100)\n", line_num);
+            }
+        } else {
+            fprintf(stderr, "Warning: Malformed DRONE line %d\n", line_num);
+        }
+    } else if (starts_with(line, len, "TASK", 4)) {
+        Span tokens[SCENARIO_MAX_TOKENS];
+        int token_count = split_spans(len >= 5 ? line + 5 : end, end, tokens, SCENARIO_MAX_TOKENS);
+        
+        if (token_count < 4) {
+            fprintf(stderr, "Warning: Malformed TASK line %d (need: warehouse customer priority time)\n", line_num);
+            return true;
+        }
+        
+        int priority = span_int(tokens[token_count - 2]);
+        int est_time = span_int(tokens[token_count - 1]);
+        
+        if (priority >= 1 && priority <= 3 && est_time >= 1 && est_time <= 100) {
+            /* "Warehouse " plus the id, cut to a location name like before. */
+            char source[MAX_LOCATION_LEN];
+            char customer[MAX_LOCATION_LEN];
+            int id_len = tokens[0].len < MAX_LOCATION_LEN - 11 ? tokens[0].len : MAX_LOCATION_LEN - 11;
+            memcpy(source, "Warehouse ", 10);
+            memcpy(source + 10, tokens[0].start, id_len);
+            int customer_len = join_spans(customer, tokens, 1, token_count - 2);
+            scenario_add_task_between(sc, lt_intern(&sc->locations, source, 10 + id_len),
+                                      lt_intern(&sc->locations, customer, customer_len), priority, est_time);
+        } else {
+            fprintf(stderr, "Warning: Invalid task config at line %d (priority 1-3, time 1-100)\n", line_num);
+        }
+    } else if (starts_with(line, len, "WAREHOUSE", 9)) {
+        Span id;
+        Point position;
+        const char *p = line + 9;
+        bool ok = split_spans(p, end, &id, 1) == 1;
+        if (ok) {
+            p = id.start + id.len;
+            ok = scan_double(&p, end, &position.x) && scan_double(&p, end, &position.y);
+        }
+        if (ok) {
+            char name[MAX_LOCATION_LEN];
+            int id_len = id.len < MAX_LOCATION_LEN - 11 ? id.len : MAX_LOCATION_LEN - 11;
+            memcpy(name, "Warehouse ", 10);
+            memcpy(name + 10, id.start, id_len);
+            name[10 + id_len] = '\0';
+            scenario_add_location(sc, name, position);
+        } else {
+            fprintf(stderr, "Warning: Malformed WAREHOUSE line %d (need: id x y)\n", line_num);
+        }
+    } else if (starts_with(line, len, "CUSTOMER", 8)) {
+        Span tokens[SCENARIO_MAX_TOKENS];
+        int token_count = split_spans(line + 8, end, tokens, SCENARIO_MAX_TOKENS);
+        Point position = { 0, 0 };
+        if (token_count >= 3 && span_double(tokens[token_count - 2], &position.x) &&
+            span_double(tokens[token_count - 1], &position.y)) {
+            char name[MAX_LOCATION_LEN];
+            join_spans(name, tokens, 0, token_count - 2);
+            scenario_add_location(sc, name, position);
+        } else {
+            fprintf(stderr, "Warning: Malformed CUSTOMER line %d (need: name x y)\n", line_num);
+        }
+    } else if (starts_with(line, len, "CHARGER", 7)) {
+        Point position;
+        const char *p = line + 7;
+        if (scan_double(&p, end, &position.x) && scan_double(&p, end, &position.y)) {
+            scenario_add_charger(sc, position);
+        } else {
+            fprintf(stderr, "Warning: Malformed CHARGER line %d (need: x y)\n", line_num);
+        }
+    } else if (starts_with(line, len, "START", 5)) {
+        return false;
+    }
+    return true;
+}
+
+/* Parses the complete lines of [data, data + len), and with `final` the
+ * unterminated tail too. Returns the bytes consumed; *stop is set at START. */
+size_t scenario_parse(Scenario *sc, const char *data, size_t len, bool final, int *line_num, bool *stop) {
+    const char *p = data;
+    const char *end = data + len;
+    while (p < end && !*stop) {
+        const char *newline = (const char *)memchr(p, '\n', (size_t)(end - p));
+        if (newline == NULL && !final) break;
+        const char *line_end = newline != NULL ? newline : end;
+        (*line_num)++;
+        *stop = !scenario_parse_line(sc, p, line_end, *line_num);
+        p = newline != NULL ? newline + 1 : end;
+    }
+    return (size_t)(p - data);
+}
+
+/* Pipes and terminals: large reads into one buffer, parsed in place. A
+ * line split across reads is moved to the front and completed by the next.
+ * Bytes read past START are kept in `sc->unread` for a live input. */
+static bool scenario_read_stream(Scenario *sc, int fd) {
+    size_t capacity = SCENARIO_READ_CHUNK;
+    char *buf = (char *)malloc(capacity);
+    size_t used = 0;
+    int line_num = 0;
+    bool stop = false;
+    bool checked_magic = false;
+    
+    while (!stop) {
+        if (used == capacity) {
+            capacity *= 2;
+            buf = (char *)realloc(buf, capacity);
+        }
+        ssize_t n = read(fd, buf + used, capacity - used);
+        if (n < 0 && errno == EINTR) continue;
+        bool final = n <= 0;
+        if (n > 0) used += (size_t)n;
+        
+        if (!checked_magic) {
+            if (used < sizeof(SCENARIO_MAGIC) && !final && memchr(buf, '\n', used) == NULL) continue;
+            checked_magic = true;
+            if (used >= sizeof(SCENARIO_MAGIC) && memcmp(buf, SCENARIO_MAGIC, sizeof(SCENARIO_MAGIC)) == 0) {
+                fprintf(stderr, "Error: Binary scenarios must be read from a file, not a pipe\n");
+                free(buf);
+                return false;
+            }
+        }
+        
+        size_t consumed = scenario_parse(sc, buf, used, final, &line_num, &stop);
+        memmove(buf, buf + consumed, used - consumed);
+        used -= consumed;
+        if (final) break;
+    }
+    if (stop && used > 0) {
+        sc->unread = buf;
+        sc->unread_len = used;
+    } else {
+        free(buf);
+    }
+    return true;
+}
+
+/* Reads a text configuration (DRONE/TASK lines, plus optional
+ * WAREHOUSE/CUSTOMER/CHARGER coordinates, up to START or end of input) or
+ * a binary scenario written by scenario_write_binary(). Regular files,
+ * including a redirected stdin, are mapped and parsed without copying.
+ * Invalid text lines are reported on stderr and skipped; returns false
+ * only for an unreadable binary scenario. */
+bool scenario_read(Scenario *sc, FILE *in) {
+    int fd = fileno(in);
+    struct stat st;
+    off_t offset = lseek(fd, 0, SEEK_CUR);
+    
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && offset >= 0 && st.st_size > offset) {
+        char *map = (char *)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            const char *data = map + offset;
+            size_t len = (size_t)(st.st_size - offset);
+            if (len >= sizeof(SCENARIO_MAGIC) && memcmp(data, SCENARIO_MAGIC, sizeof(SCENARIO_MAGIC)) == 0) {
+                munmap(map, (size_t)st.st_size);
+                return fseek(in, offset, SEEK_SET) == 0 && scenario_read_binary(sc, in);
+            }
+            madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+            int line_num = 0;
+            bool stop = false;
+            size_t consumed = scenario_parse(sc, data, len, true, &line_num, &stop);
+            munmap(map, (size_t)st.st_size);
+            /* Leave the descriptor after START for anything reading on. */
+            lseek(fd, offset + (off_t)consumed, SEEK_SET);
+            return true;
+        }
+    }
+    return scenario_read_stream(sc, fd);
+}
+
+bool scenario_load(Scenario *sc, const char *path) {
+    FILE *in = fopen(path, "rb");
+    if (in == NULL) return false;
+    bool ok = scenario_read(sc, in);
+    fclose(in);
+    return ok;
+}
+
+static void *reserve_array(void *array, int *capacity, int needed, size_t size) {
+    if (needed <= *capacity) return array;
+    *capacity = needed;
+    return realloc(array, size * (size_t)needed);
+}
+
+/* Header, one ScenarioFileLocation plus name per location (in id order),
+ * then the DroneSpec, TaskSpec and charger Point arrays as they sit in
+ * memory, so loading is a handful of reads. */
+bool scenario_write_binary(const Scenario *sc, FILE *out) {
+    ScenarioFileHeader header = {
+        .num_drones = sc->num_drones,
+        .num_tasks = sc->num_tasks,
+        .num_chargers = sc->num_chargers,
+        .num_locations = lt_count(&sc->locations)
+    };
+    memcpy(header.magic, SCENARIO_MAGIC, sizeof(header.magic));
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+    for (int i = 0; ok && i < header.num_locations; i++) {
+        const char *name = lt_name(&sc->locations, i);
+        ScenarioFileLocation loc = { .name_len = (uint32_t)strlen(name) };
+        loc.placed = lt_position(&sc->locations, i, &loc.position);
+        ok = fwrite(&loc, sizeof(loc), 1, out) == 1 && fwrite(name, 1, loc.name_len, out) == loc.name_len;
+    }
+    return ok &&
+           fwrite(sc->drones, sizeof(DroneSpec), sc->num_drones, out) == (size_t)sc->num_drones &&
+           fwrite(sc->tasks, sizeof(TaskSpec), sc->num_tasks, out) == (size_t)sc->num_tasks &&
+           fwrite(sc->chargers, sizeof(Point), sc->num_chargers, out) == (size_t)sc->num_chargers;
+}
+
+/* Appends a binary scenario to `sc`, which must have no locations yet so
+ * the stored task ids stay valid. */
+bool scenario_read_binary(Scenario *sc, FILE *in) {
+    ScenarioFileHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 ||
+        memcmp(header.magic, SCENARIO_MAGIC, sizeof(header.magic)) != 0 ||
+        header.num_drones < 0 || header.num_tasks < 0 || header.num_chargers < 0 || header.num_locations < 0 ||
+        lt_count(&sc->locations) != 0) {
+        return false;
+    }
+    
+    for (int i = 0; i < header.num_locations; i++) {
+        ScenarioFileLocation loc;
+        char name[MAX_LOCATION_LEN];
+        if (fread(&loc, sizeof(loc), 1, in) != 1 || loc.name_len >= MAX_LOCATION_LEN ||
+            fread(name, 1, loc.name_len, in) != loc.name_len) {
+            return false;
+        }
+        LocationId id = lt_intern(&sc->locations, name, loc.name_len);
+        if (id != (LocationId)i) return false;
+        if (loc.placed) lt_place(&sc->locations, id, loc.position);
+    }
+    
+    sc->drones = (DroneSpec *)reserve_array(sc->drones, &sc->drone_capacity, sc->num_drones + header.num_drones,
+                                            sizeof(DroneSpec));
+    sc->tasks = (TaskSpec *)reserve_array(sc->tasks, &sc->task_capacity, sc->num_tasks + header.num_tasks,
+                                          sizeof(TaskSpec));
+    sc->chargers = (Point *)reserve_array(sc->chargers, &sc->charger_capacity, sc->num_chargers + header.num_chargers,
+                                          sizeof(Point));
+    if (fread(sc->drones + sc->num_drones, sizeof(DroneSpec), header.num_drones, in) != (size_t)header.num_drones ||
+        fread(sc->tasks + sc->num_tasks, sizeof(TaskSpec), header.num_tasks, in) != (size_t)header.num_tasks ||
+        fread(sc->chargers + sc->num_chargers, sizeof(Point), header.num_chargers, in) != (size_t)header.num_chargers) {
+        return false;
+    }
+    for (int i = 0; i < header.num_tasks; i++) {
+        const TaskSpec *spec = &sc->tasks[sc->num_tasks + i];
+        if (spec->source >= (LocationId)header.num_locations || spec->destination >= (LocationId)header.num_locations) {
+            return false;
+        }
+    }
+    sc->num_drones += header.num_drones;
+    sc->num_tasks += header.num_tasks;
+    sc->num_chargers += header.num_chargers;
+    return true;
+}
+
+/* Adds the scenario's drones and tasks to `sim`. With `num_drones` > 0 the
+ * fleet is that size, cycling through the configured drone specs (or the
+ * default mix when the scenario has none). */
+void scenario_populate(const Scenario *sc, Simulation *sim, int num_drones) {
+    if (num_drones <= 0) num_drones = sc->num_drones;
+    
+    for (int i = 0; i < num_drones; i++) {
+        if (sc->num_drones > 0) {
+            const DroneSpec *spec = &sc->drones[i % sc->num_drones];
+            add_drone_at(sim, spec->speed, spec->battery, spec->position);
+        } else {
+            add_drone(sim, 1 + (i % 2), 80 + (i % 21));
+        }
+    }
+    /* Intern each scenario location once, then add tasks by id. */
+    int num_locations = lt_count(&sc->locations);
+    LocationId *ids = (LocationId *)malloc(sizeof(LocationId) * (num_locations > 0 ? num_locations : 1));
+    for (int i = 0; i < num_locations; i++) {
+        const char *name = lt_name(&sc->locations, i);
+        Point position;
+        ids[i] = lt_intern(&sim->locations, name, strlen(name));
+        if (lt_position(&sc->locations, i, &position)) lt_place(&sim->locations, ids[i], position);
+    }
+    for (int i = 0; i < sc->num_tasks; i++) {
+        const TaskSpec *spec = &sc->tasks[i];
+        add_task_between(sim, ids[spec->source], ids[spec->destination], spec->priority, spec->est_time);
+    }
+    free(ids);
+    for (int i = 0; i < sc->num_chargers; i++) {
+        add_charger(sim, sc->chargers[i]);
+    }
+}
+
+/* Frees everything; scenario_init() makes the scenario usable again. */
+void scenario_destroy(Scenario *sc) {
+    free(sc->drones);
+    free(sc->tasks);
+    free(sc->chargers);
+    free(sc->unread);
+    lt_destroy(&sc->locations);
+    sc->drones = NULL;
+    sc->tasks = NULL;
+    sc->chargers = NULL;
+    sc->unread = NULL;
+}
@@ -0,0 +1,74 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "drone_scheduler.h"
+
+#define SCENARIO_MAGIC "DRNSCN1"
+#define SCENARIO_READ_CHUNK (1 << 20)
+#define SCENARIO_MAX_TOKENS 100
+
+typedef struct {
+    int speed;
+    int battery;
+    Point position;
+} DroneSpec;
+
+/* Endpoints are ids in the scenario's own LocationTable. */
+typedef struct {
+    LocationId source;
+    LocationId destination;
+    int priority;
+    int est_time;
+} TaskSpec;
+
+/* A parsed configuration that can populate any number of simulations, so a
+ * sweep reads its input once. WAREHOUSE/CUSTOMER lines place names in
+ * `locations`; tasks between two placed names become located tasks. */
+typedef struct {
+    DroneSpec *drones;
+    int num_drones;
+    int drone_capacity;
+    TaskSpec *tasks;
+    int num_tasks;
+    int task_capacity;
+    LocationTable locations;
+    Point *chargers;
+    int num_chargers;
+    int charger_capacity;
+    char *unread;
+    size_t unread_len;
+} Scenario;
+
+/* Binary scenario file (see scenario_write_binary()). Host byte order. */
+typedef struct {
+    char magic[8];
+    int32_t num_drones;
+    int32_t num_tasks;
+    int32_t num_chargers;
+    int32_t num_locations;
+} ScenarioFileHeader;
+
+typedef struct {
+    int32_t placed;
+    uint32_t name_len;
+    Point position;
+} ScenarioFileLocation;
+
+void scenario_init(Scenario *sc);
+void scenario_add_drone(Scenario *sc, int speed, int battery);
+void scenario_add_drone_at(Scenario *sc, int speed, int battery, Point position);
+void scenario_add_task(Scenario *sc, const char *source, const char *dest, int priority, int est_time);
+void scenario_add_task_between(Scenario *sc, LocationId source, LocationId dest, int priority, int est_time);
+void scenario_add_location(Scenario *sc, const char *name, Point position);
+void scenario_add_charger(Scenario *sc, Point position);
+size_t scenario_parse(Scenario *sc, const char *data, size_t len, bool final, int *line_num, bool *stop);
+bool scenario_read(Scenario *sc, FILE *in);
+bool scenario_load(Scenario *sc, const char *path);
+bool scenario_write_binary(const Scenario *sc, FILE *out);
+bool scenario_read_binary(Scenario *sc, FILE *in);
+void scenario_populate(const Scenario *sc, Simulation *sim, int num_drones);
+void scenario_destroy(Scenario *sc);
+
+#endif
@@ -0,0 +1,443 @@
+#include "serve.h"
+#include "des_engine.h"
+#include "policy.h"
+#include "scenario.h"
+#include "workload.h"
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+/* One job, as its JOB line asks for it. Unset keys take the command-line
+ * defaults; a seed makes the run deterministic, as --seed does. */
+typedef struct {
+    int duration;
+    int num_charging;
+    int num_loading;
+    const SchedPolicy *policy;
+    bool deterministic;
+    unsigned long long seed;
+    bool use_workload;
+    WorkloadOptions workload;
+    SimOutput output;
+    bool quiet_setup;
+    bool full_charge;
+} ServeJob;
+
+/* The protocol, one job per connection:
+ *
+ *   JOB [duration=S] [charging=N] [loading=N] [policy=NAME] [seed=N]
+ *       [workload=SPEC] [output=text|jsonl|binary] [quiet-setup] [full-charge]
+ *   DRONE/TASK/WAREHOUSE/CUSTOMER/CHARGER lines, as in a config file
+ *   START (or a shutdown of the client's write side)
+ *
+ * The server answers with the run's event stream in the asked-for format
+ * and closes the connection, or with one "ERROR <reason>" line. Closing the
+ * connection early cancels the job at the next slice boundary. */
+
+static void serve_reply_error(int fd, const char *format, ...) {
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(line, sizeof(line) - 1, format, args);
+    va_end(args);
+    if (len < 0) return;
+    if (len > (int)sizeof(line) - 2) len = (int)sizeof(line) - 2;
+    line[len++] = '\n';
+    for (int sent = 0; sent < len;) {
+        ssize_t n = write(fd, line + sent, (size_t)(len - sent));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        sent += (int)n;
+    }
+}
+
+/* Appends the next read from `fd` to `buf`: the bytes read, 0 at the end
+ * of the input, or -1 once the client fails, stalls for longer than
+ * SERVE_READ_TIMEOUT_MS or the server starts stopping. */
+static ssize_t serve_read(SimServer *server, int fd, char **buf, size_t *used, size_t *capacity) {
+    if (*used == *capacity) {
+        *capacity *= 2;
+        *buf = (char *)realloc(*buf, *capacity);
+    }
+    struct pollfd fds[2] = {
+        { .fd = fd, .events = POLLIN },
+        { .fd = server->wake_pipe[0], .events = POLLIN }
+    };
+    for (;;) {
+        int ready = poll(fds, 2, SERVE_READ_TIMEOUT_MS);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0 || fds[1].revents != 0) return -1;
+        ssize_t n = read(fd, *buf + *used, *capacity - *used);
+        if (n < 0 && errno == EINTR) continue;
+        if (n > 0) *used += (size_t)n;
+        return n;
+    }
+}
+
+/* Fills `job` from the JOB line; false with the reason in `error`. */
+static bool serve_parse_header(char *line, ServeJob *job, char *error, size_t error_len) {
+    *job = (ServeJob){
+        .duration = 30,
+        .num_charging = 3,
+        .num_loading = 5,
+        .output = OUTPUT_TEXT
+    };
+    char *save;
+    char *word = strtok_r(line, " \t\r", &save);
+    if (word == NULL || strcmp(word, "JOB") != 0) {
+        snprintf(error, error_len, "expected a JOB line");
+        return false;
+    }
+    while ((word = strtok_r(NULL, " \t\r", &save)) != NULL) {
+        char *value = strchr(word, '=');
+        if (value != NULL) *value++ = '\0';
+
+        bool ok = true;
+        if (value == NULL) {
+            if (strcmp(word, "quiet-setup") == 0) {
+                job->quiet_setup = true;
+            } else if (strcmp(word, "full-charge") == 0) {
+                job->full_charge = true;
+            } else {
+                ok = false;
+            }
+        } else if (strcmp(word, "duration") == 0) {
+            job->duration = atoi(value);
+            ok = job->duration >= 1;
+        } else if (strcmp(word, "charging") == 0) {
+            job->num_charging = atoi(value);
+            ok = job->num_charging >= 0;
+        } else if (strcmp(word, "loading") == 0) {
+            job->num_loading = atoi(value);
+            ok = job->num_loading >= 0;
+        } else if (strcmp(word, "policy") == 0) {
+            job->policy = policy_find(value);
+            ok = job->policy != NULL;
+        } else if (strcmp(word, "seed") == 0) {
+            job->seed = strtoull(value, NULL, 10);
+            job->deterministic = true;
+        } else if (strcmp(word, "workload") == 0) {
+            ok = workload_parse(value, &job->workload);
+            job->use_workload = true;
+        } else if (strcmp(word, "output") == 0) {
+            if (strcmp(value, "text") == 0) {
+                job->output = OUTPUT_TEXT;
+            } else if (strcmp(value, "jsonl") == 0) {
+                job->output = OUTPUT_JSONL;
+            } else if (strcmp(value, "binary") == 0) {
+                job->output = OUTPUT_BINARY;
+            } else {
+                ok = false;
+            }
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            if (value != NULL) {
+                snprintf(error, error_len, "invalid %s '%s'", word, value);
+            } else {
+                snprintf(error, error_len, "unknown option '%s'", word);
+            }
+            return false;
+        }
+    }
+    if (job->use_workload && job->workload.seed == 0) job->workload.seed = job->deterministic ? job->seed : 1;
+    return true;
+}
+
+/* Reads the JOB line and the configuration after it into `job` and `sc`. */
+static bool serve_read_job(SimServer *server, int fd, ServeJob *job, Scenario *sc, char *error, size_t error_len) {
+    size_t capacity = SERVE_READ_CHUNK;
+    char *buf = (char *)malloc(capacity);
+    size_t used = 0;
+    char *newline;
+    ssize_t n = 1;
+
+    while ((newline = memchr(buf, '\n', used)) == NULL) {
+        if (n <= 0 || used >= SERVE_READ_CHUNK) {
+            snprintf(error, error_len, "%s", n < 0 ? "cannot read the job" : "expected a JOB line");
+            free(buf);
+            return false;
+        }
+        n = serve_read(server, fd, &buf, &used, &capacity);
+    }
+    *newline = '\0';
+    if (!serve_parse_header(buf, job, error, error_len)) {
+        free(buf);
+        return false;
+    }
+    size_t header_len = (size_t)(newline + 1 - buf);
+    memmove(buf, buf + header_len, used - header_len);
+    used -= header_len;
+
+    int line_num = 0;
+    bool stop = false;
+    bool final = false;
+    while (true) {
+        size_t consumed = scenario_parse(sc, buf, used, final, &line_num, &stop);
+        memmove(buf, buf + consumed, used - consumed);
+        used -= consumed;
+        if (stop || final) break;
+        n = serve_read(server, fd, &buf, &used, &capacity);
+        if (n < 0) {
+            snprintf(error, error_len, "cannot read the job");
+            free(buf);
+            return false;
+        }
+        final = n == 0;
+    }
+    free(buf);
+
+    if (sc->num_drones == 0) {
+        snprintf(error, error_len, "no drones configured");
+        return false;
+    }
+    if (sc->num_tasks == 0 && !job->use_workload) {
+        snprintf(error, error_len, "no tasks configured");
+        return false;
+    }
+    return true;
+}
+
+/* A client that closed its end has cancelled the job. */
+static bool serve_client_gone(int fd) {
+    struct pollfd pfd = { .fd = fd, .events = 0 };
+    return poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLHUP | POLLERR)) != 0;
+}
+
+static void serve_job(SimServer *server, ServeConn conn) {
+    ServeJob job;
+    Scenario sc;
+    char error[192];
+    scenario_init(&sc);
+    FILE *out = NULL;
+    bool ok = serve_read_job(server, conn.fd, &job, &sc, error, sizeof(error));
+    if (ok && (out = fdopen(conn.fd, "w")) == NULL) {
+        snprintf(error, sizeof(error), "cannot open the event stream");
+        ok = false;
+    }
+    if (!ok) {
+        serve_reply_error(conn.fd, "ERROR %s", error);
+        close(conn.fd);
+        scenario_destroy(&sc);
+        atomic_fetch_add(&server->failed, 1);
+        if (server->log != NULL) fprintf(server->log, "[Serve] Job %llu failed: %s\n", conn.id, error);
+        return;
+    }
+
+    struct timespec wall_start, wall_end;
+    clock_gettime(CLOCK_MONOTONIC, &wall_start);
+    SimOptions options = {
+        .num_drones = sc.num_drones,
+        .num_charging = job.num_charging,
+        .num_loading = job.num_loading,
+        .engine = ENGINE_DES,
+        .output = job.output,
+        .deterministic = job.deterministic,
+        .seed = job.seed,
+        .quiet_setup = job.quiet_setup,
+        .policy = job.policy,
+        .full_charge = job.full_charge,
+        .out = out
+    };
+    Simulation sim;
+    init_simulation_with_options(&sim, &options);
+    scenario_populate(&sc, &sim, 0);
+    int num_drones = sc.num_drones;
+    int num_tasks = sc.num_tasks;
+    scenario_destroy(&sc);
+    Workload workload;
+    if (job.use_workload) {
+        workload_init(&workload, &sim, &job.workload);
+        sim.workload = &workload;
+    }
+
+    /* Slices keep a cancelled job from holding its worker to the end. */
+    DesEngine des;
+    des_start(&des, &sim, job.duration);
+    long long reached = 0;
+    bool gone = false;
+    while (reached < job.duration && !(gone = serve_client_gone(conn.fd))) {
+        reached = reached + SERVE_SLICE_SECONDS < job.duration ? reached + SERVE_SLICE_SECONDS : job.duration;
+        des_run_until(&des, reached);
+    }
+    unsigned long long events = des.events_processed;
+    des_finish(&des, (int)reached);
+    if (!gone) print_statistics(&sim);
+    free_simulation(&sim);
+    if (job.use_workload) workload_destroy(&workload);
+    gone = gone || ferror(out);
+    fclose(out);
+
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+    double wall_ms = (wall_end.tv_sec - wall_start.tv_sec) * 1000.0 +
+                     (wall_end.tv_nsec - wall_start.tv_nsec) / 1e6;
+    atomic_fetch_add(gone ? &server->cancelled : &server->completed, 1);
+    if (server->log != NULL) {
+        fprintf(server->log, "[Serve] Job %llu %s: %d drones, %d tasks, %llds of %ds, %llu events in %.3f ms\n",
+                conn.id, gone ? "cancelled" : "done", num_drones, num_tasks, reached, job.duration, events, wall_ms);
+    }
+}
+
+/* Workers take jobs in arrival order; once the server is stopping they
+ * turn away whatever is still queued. */
+static void *serve_worker(void *arg) {
+    SimServer *server = (SimServer *)arg;
+
+    pthread_mutex_lock(&server->mutex);
+    while (true) {
+        while (server->count == 0 && !server->stopping) {
+            pthread_cond_wait(&server->ready, &server->mutex);
+        }
+        if (server->count == 0) break;
+        ServeConn conn = server->queue[server->head];
+        server->head = (server->head + 1) % SERVE_QUEUE_SIZE;
+        server->count--;
+        bool stopping = server->stopping;
+        pthread_mutex_unlock(&server->mutex);
+
+        if (stopping) {
+            serve_reply_error(conn.fd, "ERROR server stopping");
+            close(conn.fd);
+            atomic_fetch_add(&server->failed, 1);
+        } else {
+            serve_job(server, conn);
+        }
+        pthread_mutex_lock(&server->mutex);
+    }
+    pthread_mutex_unlock(&server->mutex);
+    return NULL;
+}
+
+static void *serve_acceptor(void *arg) {
+    SimServer *server = (SimServer *)arg;
+    struct pollfd fds[2] = {
+        { .fd = server->wake_pipe[0], .events = POLLIN },
+        { .fd = server->listen_fd, .events = POLLIN }
+    };
+
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[0].revents != 0) break;
+        if (!(fds[1].revents & POLLIN)) continue;
+
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) continue;
+        pthread_mutex_lock(&server->mutex);
+        bool full = server->count == SERVE_QUEUE_SIZE;
+        if (!full) {
+            int tail = (server->head + server->count) % SERVE_QUEUE_SIZE;
+            server->queue[tail] = (ServeConn){ .fd = fd, .id = ++server->next_job };
+            server->count++;
+            pthread_cond_signal(&server->ready);
+        }
+        pthread_mutex_unlock(&server->mutex);
+        if (full) {
+            serve_reply_error(fd, "ERROR queue full (%d jobs waiting)", SERVE_QUEUE_SIZE);
+            close(fd);
+            atomic_fetch_add(&server->rejected, 1);
+        } else {
+            atomic_fetch_add(&server->accepted, 1);
+        }
+    }
+    return NULL;
+}
+
+static int serve_listen(const char *path) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    unlink(path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 128) < 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+/* Listens on `socket_path` and starts `num_workers` workers (one per
+ * online core when < 1). Per-job lines go to `log` unless it is NULL.
+ * Writes to a client that went away must fail rather than kill the
+ * process, so SIGPIPE is ignored from here on. */
+bool serve_start(SimServer *server, const char *socket_path, int num_workers, FILE *log) {
+    server->socket_path = socket_path;
+    server->log = log;
+    server->head = 0;
+    server->count = 0;
+    server->stopping = false;
+    server->next_job = 0;
+    atomic_init(&server->accepted, 0);
+    atomic_init(&server->rejected, 0);
+    atomic_init(&server->completed, 0);
+    atomic_init(&server->cancelled, 0);
+    atomic_init(&server->failed, 0);
+
+    server->listen_fd = serve_listen(socket_path);
+    if (server->listen_fd < 0) {
+        fprintf(stderr, "Error: Cannot listen on socket '%s': %s\n", socket_path, strerror(errno));
+        return false;
+    }
+    if (pipe(server->wake_pipe) < 0) {
+        fprintf(stderr, "Error: Cannot create server pipe: %s\n", strerror(errno));
+        close(server->listen_fd);
+        unlink(socket_path);
+        return false;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    if (num_workers < 1) num_workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (num_workers < 1) num_workers = 1;
+    server->num_workers = num_workers;
+    pthread_mutex_init(&server->mutex, NULL);
+    pthread_cond_init(&server->ready, NULL);
+    server->workers = (pthread_t *)malloc(sizeof(pthread_t) * num_workers);
+    for (int i = 0; i < num_workers; i++) {
+        pthread_create(&server->workers[i], NULL, serve_worker, server);
+    }
+    pthread_create(&server->acceptor, NULL, serve_acceptor, server);
+    return true;
+}
+
+/* Stops accepting, lets running jobs finish and turns away queued ones and
+ * those still sending their configuration. */
+void serve_stop(SimServer *server) {
+    ssize_t written;
+    do {
+        written = write(server->wake_pipe[1], "", 1);
+    } while (written < 0 && errno == EINTR);
+    pthread_join(server->acceptor, NULL);
+
+    pthread_mutex_lock(&server->mutex);
+    server->stopping = true;
+    pthread_cond_broadcast(&server->ready);
+    pthread_mutex_unlock(&server->mutex);
+    for (int i = 0; i < server->num_workers; i++) {
+        pthread_join(server->workers[i], NULL);
+    }
+
+    close(server->listen_fd);
+    unlink(server->socket_path);
+    close(server->wake_pipe[0]);
+    close(server->wake_pipe[1]);
+    free(server->workers);
+    pthread_cond_destroy(&server->ready);
+    pthread_mutex_destroy(&server->mutex);
+}
@@ -0,0 +1,52 @@
+#ifndef SERVE_H
+#define SERVE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#define SERVE_QUEUE_SIZE 1024
+#define SERVE_READ_CHUNK 65536
+#define SERVE_READ_TIMEOUT_MS 10000
+#define SERVE_SLICE_SECONDS 60
+
+/* An accepted connection waiting for a worker; ids count from 1 in
+ * arrival order. */
+typedef struct {
+    int fd;
+    unsigned long long id;
+} ServeConn;
+
+/* A long-lived simulation service on a Unix socket. One thread accepts
+ * connections into a FIFO, and a pool of workers that stay up between jobs
+ * takes them off it: each connection is one job, read, run as its own
+ * discrete-event simulation and streamed back down the same connection
+ * (see serve.c for the protocol). Simulations share nothing, so
+ * `num_workers` jobs run at once and the rest wait in the queue. */
+typedef struct {
+    const char *socket_path;
+    int listen_fd;
+    int wake_pipe[2];
+    FILE *log;
+    pthread_t acceptor;
+    pthread_t *workers;
+    int num_workers;
+    pthread_mutex_t mutex;
+    pthread_cond_t ready;
+    ServeConn queue[SERVE_QUEUE_SIZE];
+    int head;
+    int count;
+    bool stopping;
+    unsigned long long next_job;
+    atomic_ullong accepted;
+    atomic_ullong rejected;
+    atomic_ullong completed;
+    atomic_ullong cancelled;
+    atomic_ullong failed;
+} SimServer;
+
+bool serve_start(SimServer *server, const char *socket_path, int num_workers, FILE *log);
+void serve_stop(SimServer *server);
+
+#endif
@@ -0,0 +1,168 @@
+#include "spatial_index.h"
+#include <math.h>
+#include <stdlib.h>
+
+double point_distance(Point a, Point b) {
+    return hypot(a.x - b.x, a.y - b.y);
+}
+
+void si_init(SpatialIndex *si, double cell_size) {
+    si->cell_size = cell_size;
+    si->buckets = NULL;
+    si->num_buckets = 0;
+    si->next = NULL;
+    si->prev = NULL;
+    si->cell_x = NULL;
+    si->cell_y = NULL;
+    si->position = NULL;
+    si->member_pos = NULL;
+    si->members = NULL;
+    si->size = 0;
+    si->capacity = 0;
+}
+
+static int si_bucket(const SpatialIndex *si, int cx, int cy) {
+    unsigned int h = (unsigned int)cx * 0x9e3779b1u ^ (unsigned int)cy * 0x85ebca77u;
+    h ^= h >> 15;
+    return (int)(h & (unsigned int)(si->num_buckets - 1));
+}
+
+static void si_link(SpatialIndex *si, int drone) {
+    int b = si_bucket(si, si->cell_x[drone], si->cell_y[drone]);
+    si->prev[drone] = -1;
+    si->next[drone] = si->buckets[b];
+    if (si->buckets[b] >= 0) si->prev[si->buckets[b]] = drone;
+    si->buckets[b] = drone;
+}
+
+static void si_unlink(SpatialIndex *si, int drone) {
+    if (si->prev[drone] >= 0) {
+        si->next[si->prev[drone]] = si->next[drone];
+    } else {
+        si->buckets[si_bucket(si, si->cell_x[drone], si->cell_y[drone])] = si->next[drone];
+    }
+    if (si->next[drone] >= 0) si->prev[si->next[drone]] = si->prev[drone];
+}
+
+/* Keeps about two buckets per drone slot; growing rehashes the members. */
+void si_reserve(SpatialIndex *si, int num_drones) {
+    if (num_drones <= si->capacity) return;
+
+    int new_capacity = si->capacity > 0 ? si->capacity : 16;
+    while (new_capacity < num_drones) new_capacity *= 2;
+
+    si->next = (int *)realloc(si->next, sizeof(int) * new_capacity);
+    si->prev = (int *)realloc(si->prev, sizeof(int) * new_capacity);
+    si->cell_x = (int *)realloc(si->cell_x, sizeof(int) * new_capacity);
+    si->cell_y = (int *)realloc(si->cell_y, sizeof(int) * new_capacity);
+    si->position = (Point *)realloc(si->position, sizeof(Point) * new_capacity);
+    si->member_pos = (int *)realloc(si->member_pos, sizeof(int) * new_capacity);
+    si->members = (int *)realloc(si->members, sizeof(int) * new_capacity);
+    for (int i = si->capacity; i < new_capacity; i++) {
+        si->member_pos[i] = -1;
+    }
+    si->capacity = new_capacity;
+
+    free(si->buckets);
+    si->num_buckets = new_capacity * 2;
+    si->buckets = (int *)malloc(sizeof(int) * si->num_buckets);
+    for (int i = 0; i < si->num_buckets; i++) {
+        si->buckets[i] = -1;
+    }
+    for (int i = 0; i < si->size; i++) {
+        si_link(si, si->members[i]);
+    }
+}
+
+void si_update(SpatialIndex *si, int drone, Point position) {
+    si_reserve(si, drone + 1);
+
+    int cx = (int)floor(position.x / si->cell_size);
+    int cy = (int)floor(position.y / si->cell_size);
+    si->position[drone] = position;
+
+    if (si->member_pos[drone] < 0) {
+        si->member_pos[drone] = si->size;
+        si->members[si->size++] = drone;
+    } else if (si->cell_x[drone] == cx && si->cell_y[drone] == cy) {
+        return;
+    } else {
+        si_unlink(si, drone);
+    }
+    si->cell_x[drone] = cx;
+    si->cell_y[drone] = cy;
+    si_link(si, drone);
+}
+
+void si_remove(SpatialIndex *si, int drone) {
+    if (!si_contains(si, drone)) return;
+
+    si_unlink(si, drone);
+    int slot = si->member_pos[drone];
+    int moved = si->members[--si->size];
+    si->members[slot] = moved;
+    si->member_pos[moved] = slot;
+    si->member_pos[drone] = -1;
+}
+
+bool si_contains(const SpatialIndex *si, int drone) {
+    return drone >= 0 && drone < si->capacity && si->member_pos[drone] >= 0;
+}
+
+/* Ties go to the lowest drone slot, so results do not depend on bucket
+ * order. */
+static void si_consider(const SpatialIndex *si, int drone, Point query, int *best, double *best_dist) {
+    double d = point_distance(si->position[drone], query);
+    if (*best < 0 || d < *best_dist || (d == *best_dist && drone < *best)) {
+        *best = drone;
+        *best_dist = d;
+    }
+}
+
+/* Returns the member closest to `query`, or -1 when empty. */
+int si_nearest(const SpatialIndex *si, Point query) {
+    if (si->size == 0) return -1;
+
+    int best = -1;
+    double best_dist = 0;
+    int qx = (int)floor(query.x / si->cell_size);
+    int qy = (int)floor(query.y / si->cell_size);
+    long long scanned = 0;
+
+    for (int r = 0; ; r++) {
+        /* Everything outside rings 0..r-1 is at least (r-1) cells away. */
+        if (best >= 0 && best_dist <= (r - 1) * si->cell_size) return best;
+        if (scanned > 4LL * si->size) break;
+
+        for (int cx = qx - r; cx <= qx + r; cx++) {
+            int step = (cx == qx - r || cx == qx + r) ? 1 : 2 * r;
+            for (int cy = qy - r; cy <= qy + r; cy += (step > 0 ? step : 1)) {
+                scanned++;
+                for (int d = si->buckets[si_bucket(si, cx, cy)]; d >= 0; d = si->next[d]) {
+                    if (si->cell_x[d] == cx && si->cell_y[d] == cy) {
+                        si_consider(si, d, query, &best, &best_dist);
+                    }
+                }
+            }
+        }
+    }
+
+    /* Members are far apart relative to the cell size: a scan is cheaper. */
+    best = -1;
+    for (int i = 0; i < si->size; i++) {
+        si_consider(si, si->members[i], query, &best, &best_dist);
+    }
+    return best;
+}
+
+void si_destroy(SpatialIndex *si) {
+    free(si->buckets);
+    free(si->next);
+    free(si->prev);
+    free(si->cell_x);
+    free(si->cell_y);
+    free(si->position);
+    free(si->member_pos);
+    free(si->members);
+    si_init(si, si->cell_size);
+}
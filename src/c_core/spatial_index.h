@@ -0,0 +1,41 @@
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <stdbool.h>
+
+typedef struct {
+    double x;
+    double y;
+} Point;
+
+double point_distance(Point a, Point b);
+
+/* Uniform grid over drone slots, hashed so the plane is unbounded. Each
+ * member sits in the bucket of its cell; a nearest query scans rings of
+ * cells outwards and stops once no unscanned cell can hold anything
+ * closer. Dense `members` makes removal O(1) and backs a linear fallback
+ * when the members are too sparse for ring search to pay off. */
+typedef struct {
+    double cell_size;
+    int *buckets;
+    int num_buckets;
+    int *next;
+    int *prev;
+    int *cell_x;
+    int *cell_y;
+    Point *position;
+    int *member_pos;
+    int *members;
+    int size;
+    int capacity;
+} SpatialIndex;
+
+void si_init(SpatialIndex *si, double cell_size);
+void si_reserve(SpatialIndex *si, int num_drones);
+void si_update(SpatialIndex *si, int drone, Point position);
+void si_remove(SpatialIndex *si, int drone);
+bool si_contains(const SpatialIndex *si, int drone);
+int si_nearest(const SpatialIndex *si, Point query);
+void si_destroy(SpatialIndex *si);
+
+#endif
@@ -0,0 +1,181 @@
+#include "sweep.h"
+#include "des_engine.h"
+#include "event_log.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct {
+    const Scenario *scenario;
+    const SweepOptions *opts;
+    SweepResult *results;
+    int count;
+    atomic_int next;
+} SweepJob;
+
+bool sweep_parse_range(const char *text, SweepRange *range) {
+    int min, max, step;
+    int fields = sscanf(text, "%d:%d:%d", &min, &max, &step);
+    if (fields < 1) return false;
+    if (fields == 1) max = min;
+    if (fields < 3) step = 1;
+    if (min < 0 || max < min || step < 1) return false;
+
+    range->min = min;
+    range->max = max;
+    range->step = step;
+    return true;
+}
+
+static int range_count(const SweepRange *range) {
+    return (range->max - range->min) / range->step + 1;
+}
+
+static int range_value(const SweepRange *range, int i) {
+    return range->min + i * range->step;
+}
+
+static int policy_count(const SweepOptions *opts) {
+    return opts->num_policies > 0 ? opts->num_policies : 1;
+}
+
+int sweep_count(const SweepOptions *opts) {
+    return policy_count(opts) * range_count(&opts->drones) * range_count(&opts->charging) * range_count(&opts->loading);
+}
+
+/* One configuration on the discrete-event engine with a silent log, so
+ * runs share nothing and need no locking between them. */
+static void sweep_run_one(const SweepJob *job, SweepResult *res) {
+    const SweepOptions *opts = job->opts;
+    struct timespec wall_start, wall_end;
+    clock_gettime(CLOCK_MONOTONIC, &wall_start);
+
+    SimOptions options = {
+        .num_drones = res->drones,
+        .num_charging = res->charging,
+        .num_loading = res->loading,
+        .engine = ENGINE_DES,
+        .output = OUTPUT_NONE,
+        .deterministic = opts->deterministic,
+        .seed = opts->seed,
+        .policy = res->policy,
+        .full_charge = opts->full_charge
+    };
+    Simulation sim;
+    init_simulation_with_options(&sim, &options);
+    scenario_populate(job->scenario, &sim, res->drones);
+    Workload workload;
+    if (opts->workload != NULL) {
+        workload_init(&workload, &sim, opts->workload);
+        sim.workload = &workload;
+    }
+    des_run_simulation(&sim, opts->duration);
+
+    Statistics *stats = &sim.stats;
+    res->total_tasks = stats->total_tasks;
+    res->completed_tasks = stats->completed_tasks;
+    res->preemptions = stats->total_preemptions;
+    res->throughput_per_hour = opts->duration > 0 ? stats->completed_tasks * 3600.0 / opts->duration : 0.0;
+
+    Histogram *done = (Histogram *)malloc(sizeof(Histogram));
+    phase_timers_merge(&stats->phases, PHASE_DELIVERY, -1, done);
+    res->mean_delivery_s = done->total > 0 ? (double)done->sum / done->total / 1e6 : 0.0;
+    res->p99_delivery_s = hist_percentile(done, 99) / 1e6;
+    free(done);
+
+    double span_us = (double)opts->duration * 1e6;
+    res->charging_utilization = (res->charging > 0 && span_us > 0) ? stats->charging_busy_us / (res->charging * span_us) : 0.0;
+    res->loading_utilization = (res->loading > 0 && span_us > 0) ? stats->loading_busy_us / (res->loading * span_us) : 0.0;
+    free_simulation(&sim);
+    if (opts->workload != NULL) workload_destroy(&workload);
+
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+    res->wall_ms = (wall_end.tv_sec - wall_start.tv_sec) * 1000.0 +
+                   (wall_end.tv_nsec - wall_start.tv_nsec) / 1e6;
+}
+
+static void *sweep_worker(void *arg) {
+    SweepJob *job = (SweepJob *)arg;
+    int i;
+    while ((i = atomic_fetch_add(&job->next, 1)) < job->count) {
+        sweep_run_one(job, &job->results[i]);
+    }
+    return NULL;
+}
+
+static void sweep_write_csv(FILE *out, const SweepResult *results, int count) {
+    fprintf(out, "policy,drones,charging,loading,tasks,completed,preemptions,throughput_per_hour,"
+                 "mean_delivery_s,p99_delivery_s,charging_utilization,loading_utilization,wall_ms\n");
+    for (int i = 0; i < count; i++) {
+        const SweepResult *r = &results[i];
+        fprintf(out, "%s,%d,%d,%d,%d,%d,%d,%.2f,%.2f,%.2f,%.4f,%.4f,%.3f\n",
+                r->policy->name, r->drones, r->charging, r->loading, r->total_tasks, r->completed_tasks, r->preemptions,
+                r->throughput_per_hour, r->mean_delivery_s, r->p99_delivery_s,
+                r->charging_utilization, r->loading_utilization, r->wall_ms);
+    }
+}
+
+static void sweep_write_json(FILE *out, const SweepResult *results, int count) {
+    fprintf(out, "[\n");
+    for (int i = 0; i < count; i++) {
+        const SweepResult *r = &results[i];
+        fprintf(out, "  {\"policy\":\"%s\",\"drones\":%d,\"charging\":%d,\"loading\":%d,\"tasks\":%d,\"completed\":%d,"
+                     "\"preemptions\":%d,\"throughput_per_hour\":%.2f,\"mean_delivery_s\":%.2f,"
+                     "\"p99_delivery_s\":%.2f,\"charging_utilization\":%.4f,\"loading_utilization\":%.4f,"
+                     "\"wall_ms\":%.3f}%s\n",
+                r->policy->name, r->drones, r->charging, r->loading, r->total_tasks, r->completed_tasks, r->preemptions,
+                r->throughput_per_hour, r->mean_delivery_s, r->p99_delivery_s,
+                r->charging_utilization, r->loading_utilization, r->wall_ms,
+                (i + 1 < count) ? "," : "");
+    }
+    fprintf(out, "]\n");
+}
+
+/* Runs every policy x drones x charging x loading combination across `threads`
+ * workers and writes one row per configuration, in sweep order. */
+int sweep_run(const Scenario *sc, const SweepOptions *opts, FILE *out) {
+    SweepJob job;
+    job.scenario = sc;
+    job.opts = opts;
+    job.count = sweep_count(opts);
+    job.results = (SweepResult *)calloc(job.count, sizeof(SweepResult));
+    atomic_init(&job.next, 0);
+
+    int i = 0;
+    for (int p = 0; p < policy_count(opts); p++) {
+        for (int d = 0; d < range_count(&opts->drones); d++) {
+            for (int c = 0; c < range_count(&opts->charging); c++) {
+                for (int l = 0; l < range_count(&opts->loading); l++) {
+                    job.results[i].policy = opts->num_policies > 0 ? opts->policies[p] : policy_default();
+                    job.results[i].drones = range_value(&opts->drones, d);
+                    job.results[i].charging = range_value(&opts->charging, c);
+                    job.results[i].loading = range_value(&opts->loading, l);
+                    i++;
+                }
+            }
+        }
+    }
+
+    int threads = opts->threads;
+    if (threads < 1) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads > job.count) threads = job.count;
+
+    pthread_t *workers = (pthread_t *)malloc(sizeof(pthread_t) * threads);
+    for (int t = 0; t < threads; t++) {
+        pthread_create(&workers[t], NULL, sweep_worker, &job);
+    }
+    for (int t = 0; t < threads; t++) {
+        pthread_join(workers[t], NULL);
+    }
+    free(workers);
+
+    if (opts->format == SWEEP_JSON) {
+        sweep_write_json(out, job.results, job.count);
+    } else {
+        sweep_write_csv(out, job.results, job.count);
+    }
+    fflush(out);
+    free(job.results);
+    return job.count;
+}
@@ -0,0 +1,57 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "scenario.h"
+#include "workload.h"
+#include "policy.h"
+
+typedef enum {
+    SWEEP_CSV,
+    SWEEP_JSON
+} SweepFormat;
+
+/* Inclusive integer range written as "n", "min:max" or "min:max:step". */
+typedef struct {
+    int min;
+    int max;
+    int step;
+} SweepRange;
+
+typedef struct {
+    SweepRange drones;
+    SweepRange charging;
+    SweepRange loading;
+    int duration;
+    int threads;
+    SweepFormat format;
+    bool deterministic;
+    unsigned long long seed;
+    const WorkloadOptions *workload;
+    const SchedPolicy *policies[POLICY_MAX];
+    int num_policies;
+    bool full_charge;
+} SweepOptions;
+
+typedef struct {
+    const SchedPolicy *policy;
+    int drones;
+    int charging;
+    int loading;
+    int total_tasks;
+    int completed_tasks;
+    int preemptions;
+    double throughput_per_hour;
+    double mean_delivery_s;
+    double p99_delivery_s;
+    double charging_utilization;
+    double loading_utilization;
+    double wall_ms;
+} SweepResult;
+
+bool sweep_parse_range(const char *text, SweepRange *range);
+int sweep_count(const SweepOptions *opts);
+int sweep_run(const Scenario *sc, const SweepOptions *opts, FILE *out);
+
+#endif
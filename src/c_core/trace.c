@@ -0,0 +1,99 @@
+#include "trace.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *const event_names[] = {
+    [EV_SCHEDULER_TICK] = "scheduler_tick",
+    [EV_ASSIGNMENT] = "assignment",
+    [EV_LOAD_COMPLETE] = "load_complete",
+    [EV_DELIVERY_END] = "delivery_end",
+    [EV_CHARGE_COMPLETE] = "charge_complete"
+};
+
+static const char *event_name(int type) {
+    if (type < 0 || type > EV_CHARGE_COMPLETE) return "unknown";
+    return event_names[type];
+}
+
+bool trace_record_open(Trace *trace, const char *path, const TraceHeader *header, const Scenario *sc) {
+    trace->replay = false;
+    trace->events = 0;
+    trace->diverged = false;
+    trace->file = fopen(path, "wb");
+    if (trace->file == NULL) return false;
+
+    TraceHeader out = *header;
+    memcpy(out.magic, TRACE_MAGIC, sizeof(out.magic));
+    fwrite(&out, sizeof(out), 1, trace->file);
+    scenario_write_binary(sc, trace->file);
+    return true;
+}
+
+/* Loads the recorded inputs into `header` and `sc`, leaving the file at
+ * the first event. */
+bool trace_replay_open(Trace *trace, const char *path, TraceHeader *header, Scenario *sc) {
+    trace->replay = true;
+    trace->events = 0;
+    trace->diverged = false;
+    trace->file = fopen(path, "rb");
+    if (trace->file == NULL) return false;
+
+    bool ok = fread(header, sizeof(*header), 1, trace->file) == 1 &&
+              memcmp(header->magic, TRACE_MAGIC, sizeof(header->magic)) == 0 &&
+              scenario_read_binary(sc, trace->file);
+    if (!ok) {
+        fclose(trace->file);
+        trace->file = NULL;
+    }
+    return ok;
+}
+
+static void trace_diverge(Trace *trace, const TraceEvent *recorded, const SimEvent *ev) {
+    trace->diverged = true;
+    if (recorded == NULL) {
+        fprintf(stderr, "Replay diverged at event %llu: trace ended, replay handled t=%lld %s drone %d\n",
+                trace->events, ev->time, event_name(ev->type), ev->drone);
+    } else if (ev == NULL) {
+        fprintf(stderr, "Replay diverged at event %llu: replay ended, trace has t=%lld %s drone %d\n",
+                trace->events, (long long)recorded->time, event_name(recorded->type), recorded->drone);
+    } else {
+        fprintf(stderr, "Replay diverged at event %llu: trace has t=%lld %s drone %d, replay handled t=%lld %s drone %d\n",
+                trace->events, (long long)recorded->time, event_name(recorded->type), recorded->drone,
+                ev->time, event_name(ev->type), ev->drone);
+    }
+}
+
+void trace_event(Trace *trace, const SimEvent *ev) {
+    TraceEvent current = {
+        .time = ev->time,
+        .type = ev->type,
+        .drone = ev->drone,
+        .generation = ev->generation
+    };
+
+    if (!trace->replay) {
+        fwrite(&current, sizeof(current), 1, trace->file);
+    } else if (!trace->diverged) {
+        TraceEvent recorded;
+        if (fread(&recorded, sizeof(recorded), 1, trace->file) != 1) {
+            trace_diverge(trace, NULL, ev);
+        } else if (memcmp(&recorded, &current, sizeof(current)) != 0) {
+            trace_diverge(trace, &recorded, ev);
+        }
+    }
+    trace->events++;
+}
+
+/* Returns false if a replay diverged, including a trace that still has
+ * events left when the run ends. */
+bool trace_close(Trace *trace) {
+    if (trace->replay && !trace->diverged) {
+        TraceEvent recorded;
+        if (fread(&recorded, sizeof(recorded), 1, trace->file) == 1) {
+            trace_diverge(trace, &recorded, NULL);
+        }
+    }
+    fclose(trace->file);
+    trace->file = NULL;
+    return !trace->diverged;
+}
@@ -0,0 +1,48 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "event_queue.h"
+#include "scenario.h"
+
+#define TRACE_MAGIC "DRNTRC4"
+
+/* A trace file is this header, the scenario in the binary scenario format
+ * (scenario_write_binary()), then one TraceEvent per event the
+ * discrete-event engine handled. Fields are in host byte order; traces are
+ * meant for the machine (or at least the architecture) that recorded them. */
+typedef struct {
+    char magic[8];
+    uint64_t seed;
+    int32_t num_charging;
+    int32_t num_loading;
+    int32_t duration;
+    int32_t reserved;
+} TraceHeader;
+
+typedef struct {
+    int64_t time;
+    int32_t type;
+    int32_t drone;
+    uint32_t generation;
+    uint32_t reserved;
+} TraceEvent;
+
+/* Recording appends every handled event. Replaying reruns the recorded
+ * inputs and checks each handled event against the file, reporting the
+ * first divergence on stderr. */
+typedef struct Trace {
+    bool replay;
+    FILE *file;
+    unsigned long long events;
+    bool diverged;
+} Trace;
+
+bool trace_record_open(Trace *trace, const char *path, const TraceHeader *header, const Scenario *sc);
+bool trace_replay_open(Trace *trace, const char *path, TraceHeader *header, Scenario *sc);
+void trace_event(Trace *trace, const SimEvent *ev);
+bool trace_close(Trace *trace);
+
+#endif
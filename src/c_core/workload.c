@@ -0,0 +1,264 @@
+#include "workload.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define WORKLOAD_MIN_SLEEP_US 1000
+#define WORKLOAD_MAX_SLEEP_US 10000
+
+static const char *process_names[] = { "poisson", "bursty", "diurnal" };
+
+static bool parse_number(const char *text, double *out) {
+    char *end;
+    *out = strtod(text, &end);
+    return end != text && *end == '\0';
+}
+
+static bool parse_count(const char *text, int *out) {
+    double value;
+    if (!parse_number(text, &value) || value != floor(value) || value < 0 || value > 1e9) return false;
+    *out = (int)value;
+    return true;
+}
+
+bool workload_parse(const char *spec, WorkloadOptions *opts) {
+    *opts = (WorkloadOptions){
+        .process = ARRIVAL_POISSON,
+        .rate = 1.0,
+        .burst = 5.0,
+        .duty = 0.1,
+        .amplitude = 0.8,
+        .mix = { 1, 1, 1 },
+        .warehouses = 5,
+        .customers = 500,
+        .skew = 1.0,
+        .min_time = 5,
+        .max_time = 30
+    };
+
+    char buf[256];
+    if (strlen(spec) >= sizeof(buf)) return false;
+    strcpy(buf, spec);
+
+    char *save = NULL;
+    char *field = strtok_r(buf, ",", &save);
+    if (field == NULL) return false;
+    int process = -1;
+    for (int i = 0; i < 3; i++) {
+        if (strcmp(field, process_names[i]) == 0) process = i;
+    }
+    if (process < 0) return false;
+    opts->process = (ArrivalProcess)process;
+
+    while ((field = strtok_r(NULL, ",", &save)) != NULL) {
+        char *value = strchr(field, '=');
+        if (value == NULL) return false;
+        *value++ = '\0';
+        bool ok;
+        if (strcmp(field, "rate") == 0) {
+            ok = parse_number(value, &opts->rate);
+        } else if (strcmp(field, "period") == 0) {
+            ok = parse_number(value, &opts->period);
+        } else if (strcmp(field, "burst") == 0) {
+            ok = parse_number(value, &opts->burst);
+        } else if (strcmp(field, "duty") == 0) {
+            ok = parse_number(value, &opts->duty);
+        } else if (strcmp(field, "amplitude") == 0) {
+            ok = parse_number(value, &opts->amplitude);
+        } else if (strcmp(field, "mix") == 0) {
+            ok = sscanf(value, "%d:%d:%d", &opts->mix[0], &opts->mix[1], &opts->mix[2]) == 3;
+        } else if (strcmp(field, "warehouses") == 0) {
+            ok = parse_count(value, &opts->warehouses);
+        } else if (strcmp(field, "customers") == 0) {
+            ok = parse_count(value, &opts->customers);
+        } else if (strcmp(field, "skew") == 0) {
+            ok = parse_number(value, &opts->skew);
+        } else if (strcmp(field, "area") == 0) {
+            ok = parse_number(value, &opts->area);
+        } else if (strcmp(field, "time") == 0) {
+            ok = sscanf(value, "%d:%d", &opts->min_time, &opts->max_time) == 2;
+        } else if (strcmp(field, "seed") == 0) {
+            char *end;
+            opts->seed = strtoull(value, &end, 10);
+            ok = end != value && *end == '\0';
+        } else {
+            ok = false;
+        }
+        if (!ok) return false;
+    }
+
+    if (opts->period == 0) opts->period = (opts->process == ARRIVAL_DIURNAL) ? 86400 : 60;
+    return opts->rate > 0 && opts->period > 0 && opts->burst >= 1 && opts->duty > 0 && opts->duty < 1 &&
+           opts->burst * opts->duty <= 1 && opts->amplitude >= 0 && opts->amplitude <= 1 &&
+           opts->mix[0] >= 0 && opts->mix[1] >= 0 && opts->mix[2] >= 0 &&
+           opts->mix[0] + opts->mix[1] + opts->mix[2] > 0 && opts->warehouses >= 1 && opts->customers >= 1 &&
+           opts->skew >= 0 && opts->area >= 0 && opts->min_time >= 1 && opts->min_time <= opts->max_time &&
+           opts->max_time <= 100;
+}
+
+/* splitmix64, mapped onto (0, 1] so log() never sees zero. */
+static double workload_uniform(Workload *wl) {
+    unsigned long long x = (wl->rng += 0x9e3779b97f4a7c15ULL);
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return ((x >> 11) + 1) * 0x1.0p-53;
+}
+
+static double workload_rate_at(const WorkloadOptions *opts, double t) {
+    switch (opts->process) {
+    case ARRIVAL_BURSTY:
+        if (fmod(t, opts->period) < opts->duty * opts->period) return opts->rate * opts->burst;
+        return opts->rate * (1.0 - opts->burst * opts->duty) / (1.0 - opts->duty);
+    case ARRIVAL_DIURNAL:
+        return opts->rate * (1.0 + opts->amplitude * sin(2.0 * M_PI * t / opts->period));
+    default:
+        return opts->rate;
+    }
+}
+
+/* Draws candidates at the peak rate and keeps each with probability
+ * rate(t) / peak, which leaves a Poisson process of rate rate(t). */
+static void workload_schedule(Workload *wl) {
+    double t = wl->next_arrival;
+    for (;;) {
+        t -= log(workload_uniform(wl)) / wl->peak_rate;
+        if (wl->opts.process == ARRIVAL_POISSON) break;
+        if (workload_uniform(wl) * wl->peak_rate <= workload_rate_at(&wl->opts, t)) break;
+    }
+    wl->next_arrival = t;
+}
+
+static LocationId workload_place(Workload *wl, const char *name) {
+    LocationId id = lt_intern(&wl->sim->locations, name, strlen(name));
+    if (wl->opts.area > 0) {
+        Point position = { workload_uniform(wl) * wl->opts.area, workload_uniform(wl) * wl->opts.area };
+        if (!lt_position(&wl->sim->locations, id, NULL)) lt_place(&wl->sim->locations, id, position);
+    }
+    return id;
+}
+
+/* Interns (and with an `area`, places) the locations up front; names a
+ * config already placed keep their coordinates. */
+void workload_init(Workload *wl, Simulation *sim, const WorkloadOptions *opts) {
+    wl->sim = sim;
+    wl->opts = *opts;
+    wl->rng = opts->seed;
+    wl->generated = 0;
+    wl->mix_total = opts->mix[0] + opts->mix[1] + opts->mix[2];
+    atomic_init(&wl->running, false);
+
+    char name[MAX_LOCATION_LEN];
+    wl->warehouse_ids = (LocationId *)malloc(sizeof(LocationId) * opts->warehouses);
+    for (int i = 0; i < opts->warehouses; i++) {
+        snprintf(name, sizeof(name), "Warehouse %d", i + 1);
+        wl->warehouse_ids[i] = workload_place(wl, name);
+    }
+    wl->customer_ids = (LocationId *)malloc(sizeof(LocationId) * opts->customers);
+    wl->customer_cdf = (double *)malloc(sizeof(double) * opts->customers);
+    double total = 0;
+    for (int i = 0; i < opts->customers; i++) {
+        snprintf(name, sizeof(name), "Customer %d", i + 1);
+        wl->customer_ids[i] = workload_place(wl, name);
+        total += pow(i + 1, -opts->skew);
+        wl->customer_cdf[i] = total;
+    }
+    for (int i = 0; i < opts->customers; i++) wl->customer_cdf[i] /= total;
+
+    wl->peak_rate = opts->process == ARRIVAL_BURSTY ? opts->rate * opts->burst :
+                    opts->process == ARRIVAL_DIURNAL ? opts->rate * (1.0 + opts->amplitude) : opts->rate;
+    wl->next_arrival = 0;
+    workload_schedule(wl);
+}
+
+/* Seconds from the start of the run to the next arrival. */
+double workload_next_arrival(const Workload *wl) {
+    return wl->next_arrival;
+}
+
+static int workload_customer(Workload *wl) {
+    double u = workload_uniform(wl);
+    int lo = 0, hi = wl->opts.customers - 1;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (wl->customer_cdf[mid] < u) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* Queues every arrival due before `until` seconds; returns how many. */
+int workload_advance(Workload *wl, double until) {
+    const WorkloadOptions *opts = &wl->opts;
+    int count = 0;
+    while (wl->next_arrival < until) {
+        int warehouse = (int)(workload_uniform(wl) * opts->warehouses) % opts->warehouses;
+        int customer = workload_customer(wl);
+        int pick = (int)(workload_uniform(wl) * wl->mix_total) % wl->mix_total;
+        int priority = pick < opts->mix[0] ? 1 : pick < opts->mix[0] + opts->mix[1] ? 2 : 3;
+        int span = opts->max_time - opts->min_time + 1;
+        int est_time = opts->min_time + (int)(workload_uniform(wl) * span) % span;
+
+        add_task_between(wl->sim, wl->warehouse_ids[warehouse], wl->customer_ids[customer], priority, est_time);
+        count++;
+        workload_schedule(wl);
+    }
+    wl->generated += (unsigned long long)count;
+    return count;
+}
+
+static long long workload_clock_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+/* Releases due arrivals against the wall clock. Sleeps are clamped, so
+ * arrivals go out in batches of at least 1 ms and a stop is seen within
+ * 10 ms. */
+static void *workload_thread(void *arg) {
+    Workload *wl = (Workload *)arg;
+    long long start = workload_clock_us();
+    while (atomic_load(&wl->running)) {
+        double now = (workload_clock_us() - start) / 1e6;
+        workload_advance(wl, now);
+        long long wait_us = (long long)((wl->next_arrival - now) * 1e6);
+        if (wait_us < WORKLOAD_MIN_SLEEP_US) wait_us = WORKLOAD_MIN_SLEEP_US;
+        if (wait_us > WORKLOAD_MAX_SLEEP_US) wait_us = WORKLOAD_MAX_SLEEP_US;
+        usleep((useconds_t)wait_us);
+    }
+    double elapsed = (workload_clock_us() - start) / 1e6;
+    workload_report(wl, elapsed);
+    return NULL;
+}
+
+void workload_start(Workload *wl) {
+    atomic_store(&wl->running, true);
+    pthread_create(&wl->thread, NULL, workload_thread, wl);
+}
+
+void workload_stop(Workload *wl) {
+    atomic_store(&wl->running, false);
+    pthread_join(wl->thread, NULL);
+}
+
+void workload_report(const Workload *wl, double elapsed) {
+    log_event(wl->sim, "[Workload] %s arrivals: %llu tasks in %.0f s (%.2f/s, configured mean %.2f/s)",
+              process_names[wl->opts.process], wl->generated, elapsed,
+              elapsed > 0 ? wl->generated / elapsed : 0.0, wl->opts.rate);
+}
+
+void workload_destroy(Workload *wl) {
+    free(wl->warehouse_ids);
+    free(wl->customer_ids);
+    free(wl->customer_cdf);
+    wl->warehouse_ids = NULL;
+    wl->customer_ids = NULL;
+    wl->customer_cdf = NULL;
+}
@@ -0,0 +1,66 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "drone_scheduler.h"
+
+typedef enum {
+    ARRIVAL_POISSON,
+    ARRIVAL_BURSTY,
+    ARRIVAL_DIURNAL
+} ArrivalProcess;
+
+/* Written "process[,key=value...]", e.g.
+ * "diurnal,rate=50,mix=1:2:1,customers=5000,skew=1.1". `rate` is the mean
+ * arrivals per second; bursty cycles spend `duty` of each `period` at
+ * `burst` times the mean and the rest below it, and diurnal swings by
+ * `amplitude` around the mean over one `period`. */
+typedef struct {
+    ArrivalProcess process;
+    double rate;
+    double period;
+    double burst;
+    double duty;
+    double amplitude;
+    int mix[3];
+    int warehouses;
+    int customers;
+    double skew;
+    double area;
+    int min_time;
+    int max_time;
+    unsigned long long seed;
+} WorkloadOptions;
+
+/* Seeded task generator for one simulation. Arrivals follow the process by
+ * thinning a Poisson stream at the peak rate; warehouses are picked
+ * uniformly and customers by a Zipf law of exponent `skew`. The engine
+ * drives it: virtual-clock arrival events for the discrete-event engine, a
+ * feeder thread for the threads engine. */
+typedef struct Workload {
+    Simulation *sim;
+    WorkloadOptions opts;
+    unsigned long long rng;
+    double peak_rate;
+    double next_arrival;
+    LocationId *warehouse_ids;
+    LocationId *customer_ids;
+    double *customer_cdf;
+    int mix_total;
+    unsigned long long generated;
+    pthread_t thread;
+    atomic_bool running;
+} Workload;
+
+bool workload_parse(const char *spec, WorkloadOptions *opts);
+void workload_init(Workload *wl, Simulation *sim, const WorkloadOptions *opts);
+double workload_next_arrival(const Workload *wl);
+int workload_advance(Workload *wl, double until);
+void workload_start(Workload *wl);
+void workload_stop(Workload *wl);
+void workload_report(const Workload *wl, double elapsed);
+void workload_destroy(Workload *wl);
+
+#endif
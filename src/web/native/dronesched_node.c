@@ -0,0 +1,450 @@
+#define NAPI_VERSION 8
+#include <node_api.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dronesched.h"
+
+/* Node binding of libdronesched: a `Simulation` class whose methods map
+ * one to one onto the dsched_* calls. Runs happen on the calling (main)
+ * thread, so keep each call's slice of virtual time short enough for the
+ * event loop, or use a worker thread per simulation. */
+
+#define MAX_ARGS 4
+#define EVENT_BATCH 1024
+
+typedef struct {
+    DschedSim *sim;
+} Handle;
+
+static const char *const drone_states[] = { "idle", "loading", "delivering", "charging", "preempted" };
+
+static bool check(napi_env env, int status) {
+    if (status >= 0) return true;
+    napi_throw_error(env, NULL, dsched_strerror(status));
+    return false;
+}
+
+/* Fetches `this`'s simulation and up to MAX_ARGS arguments (missing ones
+ * are undefined); throws and returns NULL once the simulation was closed. */
+static DschedSim *unwrap(napi_env env, napi_callback_info info, napi_value *argv) {
+    napi_value self;
+    size_t argc = MAX_ARGS;
+    Handle *handle = NULL;
+    if (napi_get_cb_info(env, info, argv != NULL ? &argc : NULL, argv, &self, NULL) != napi_ok ||
+        napi_unwrap(env, self, (void **)&handle) != napi_ok) {
+        return NULL;
+    }
+    if (handle->sim == NULL) {
+        napi_throw_error(env, NULL, "simulation is closed");
+        return NULL;
+    }
+    return handle->sim;
+}
+
+static bool get_int(napi_env env, napi_value value, int *out) {
+    if (napi_get_value_int32(env, value, out) == napi_ok) return true;
+    napi_throw_type_error(env, NULL, "expected a number");
+    return false;
+}
+
+static bool get_double(napi_env env, napi_value value, double fallback, double *out) {
+    napi_valuetype type;
+    napi_typeof(env, value, &type);
+    if (type == napi_undefined) {
+        *out = fallback;
+        return true;
+    }
+    if (napi_get_value_double(env, value, out) == napi_ok) return true;
+    napi_throw_type_error(env, NULL, "expected a number");
+    return false;
+}
+
+/* A copy of a JS string; the caller frees it. */
+static char *get_string(napi_env env, napi_value value, size_t *len) {
+    size_t length;
+    if (napi_get_value_string_utf8(env, value, NULL, 0, &length) != napi_ok) {
+        napi_throw_type_error(env, NULL, "expected a string");
+        return NULL;
+    }
+    char *text = (char *)malloc(length + 1);
+    napi_get_value_string_utf8(env, value, text, length + 1, &length);
+    if (len != NULL) *len = length;
+    return text;
+}
+
+static bool get_option(napi_env env, napi_value options, const char *name, napi_value *out) {
+    bool has = false;
+    if (napi_has_named_property(env, options, name, &has) != napi_ok || !has) return false;
+    napi_get_named_property(env, options, name, out);
+    napi_valuetype type;
+    napi_typeof(env, *out, &type);
+    return type != napi_undefined && type != napi_null;
+}
+
+static void set_int(napi_env env, napi_value obj, const char *name, long long value) {
+    napi_value v;
+    napi_create_int64(env, value, &v);
+    napi_set_named_property(env, obj, name, v);
+}
+
+static void set_double(napi_env env, napi_value obj, const char *name, double value) {
+    napi_value v;
+    napi_create_double(env, value, &v);
+    napi_set_named_property(env, obj, name, v);
+}
+
+static void set_string(napi_env env, napi_value obj, const char *name, const char *value) {
+    napi_value v;
+    napi_create_string_utf8(env, value != NULL ? value : "", NAPI_AUTO_LENGTH, &v);
+    napi_set_named_property(env, obj, name, v);
+}
+
+static napi_value undefined(napi_env env) {
+    napi_value v;
+    napi_get_undefined(env, &v);
+    return v;
+}
+
+static void finalize(napi_env env, void *data, void *hint) {
+    Handle *handle = (Handle *)data;
+    dsched_destroy(handle->sim);
+    free(handle);
+}
+
+/* new Simulation({ chargingStations, loadingBays, seed, policy, fullCharge,
+ * events, restore }): `events` buffers events for events(), `restore`
+ * resumes a checkpoint file instead of starting empty. */
+static napi_value sim_new(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value options, self;
+    napi_get_cb_info(env, info, &argc, &options, &self, NULL);
+
+    DschedOptions opts;
+    dsched_options_init(&opts);
+    napi_value v;
+    char *policy = NULL;
+    char *restore = NULL;
+    bool events = false;
+    bool full_charge = false;
+    bool ok = true;
+    if (get_option(env, options, "chargingStations", &v)) ok = ok && get_int(env, v, &opts.num_charging);
+    if (get_option(env, options, "loadingBays", &v)) ok = ok && get_int(env, v, &opts.num_loading);
+    if (ok && get_option(env, options, "seed", &v)) {
+        int64_t seed;
+        bool lossless;
+        if (napi_get_value_bigint_uint64(env, v, (uint64_t *)&opts.seed, &lossless) != napi_ok) {
+            ok = napi_get_value_int64(env, v, &seed) == napi_ok;
+            opts.seed = (unsigned long long)seed;
+            if (!ok) napi_throw_type_error(env, NULL, "seed must be a number or BigInt");
+        }
+    }
+    if (ok && get_option(env, options, "policy", &v)) ok = (policy = get_string(env, v, NULL)) != NULL;
+    if (ok && get_option(env, options, "restore", &v)) ok = (restore = get_string(env, v, NULL)) != NULL;
+    if (get_option(env, options, "fullCharge", &v)) napi_get_value_bool(env, v, &full_charge);
+    if (get_option(env, options, "events", &v)) napi_get_value_bool(env, v, &events);
+    opts.policy = policy;
+    opts.full_charge = full_charge;
+
+    DschedSim *sim = NULL;
+    int status = DSCHED_OK;
+    if (ok) status = restore != NULL ? dsched_restore(restore, &opts, &sim) : dsched_create(&opts, &sim);
+    free(policy);
+    free(restore);
+    if (!ok || !check(env, status)) return NULL;
+
+    if (events) dsched_buffer_events(sim, 1);
+    Handle *handle = (Handle *)malloc(sizeof(Handle));
+    handle->sim = sim;
+    napi_wrap(env, self, handle, finalize, NULL, NULL);
+    return self;
+}
+
+static napi_value sim_load_config(napi_env env, napi_callback_info info) {
+    napi_value argv[MAX_ARGS];
+    DschedSim *sim = unwrap(env, info, argv);
+    size_t len;
+    char *text = sim != NULL ? get_string(env, argv[0], &len) : NULL;
+    if (text == NULL) return NULL;
+    int status = dsched_load_config(sim, text, len);
+    free(text);
+    return check(env, status) ? undefined(env) : NULL;
+}
+
+static napi_value sim_set_workload(napi_env env, napi_callback_info info) {
+    napi_value argv[MAX_ARGS];
+    DschedSim *sim = unwrap(env, info, argv);
+    char *spec = sim != NULL ? get_string(env, argv[0], NULL) : NULL;
+    if (spec == NULL) return NULL;
+    int status = dsched_set_workload(sim, spec);
+    free(spec);
+    return check(env, status) ? undefined(env) : NULL;
+}
+
+/* addDrone(speed, battery[, x, y]) */
+static napi_value sim_add_drone(napi_env env, napi_callback_info info) {
+    napi_value argv[MAX_ARGS];
+    DschedSim *sim = unwrap(env, info, argv);
+    int speed, battery;
+    double x, y;
+    if (sim == NULL || !get_int(env, argv[0], &speed) || !get_int(env, argv[1], &battery) ||
+        !get_double(env, argv[2], 0, &x) || !get_double(env, argv[3], 0, &y)) {
+        return NULL;
+    }
+    return check(env, dsched_add_drone_at(sim, speed, battery, x, y)) ? undefined(env) : NULL;
+}
+
+static napi_value sim_place(napi_env env, napi_callback_info info) {
+    napi_value argv[MAX_ARGS];
+    DschedSim *sim = unwrap(env, info, argv);
+    double x, y;
+    char *name = sim != NULL ? get_string(env, argv[0], NULL) : NULL;
+    if (name == NULL) return NULL;
+    int status = DSCHED_EINVAL;
+    bool ok = get_double(env, argv[1], 0, &x) && get_double(env, argv[2], 0, &y);
+    if (ok) status = dsched_place(sim, name, x, y);
+    free(name);
+    return ok && check(env, status) ? undefined(env) : NULL;
+}
+
+static napi_value sim_add_charger(napi_env env, napi_callback_info info) {
+    napi_value argv[MAX_ARGS];
+    DschedSim *sim = unwrap(env, info, argv);
+    double x, y;
+    if (sim == NULL || !get_double(env, argv[0], 0, &x) || !get_double(env, argv[1], 0, &y)) return NULL;
+    return check(env, dsched_add_charger(sim, x, y)) ? undefined(env) : NULL;
+}
+
+/* addTask(source, destination, priority, estimatedTime) */
+static napi_value sim_add_task(napi_env env, napi_callback_info info) {
+    napi_value argv[MAX_ARGS];
+    DschedSim *sim = unwrap(env, info, argv);
+    int priority, est_time;
+    if (sim == NULL || !get_int(env, argv[2], &priority) || !get_int(env, argv[3], &est_time)) return NULL;
+    char *source = get_string(env, argv[0], NULL);
+    char *dest = source != NULL ? get_string(env, argv[1], NULL) : NULL;
+    int status = DSCHED_EINVAL;
+    if (dest != NULL) status = dsched_add_task(sim, source, dest, priority, est_time);
+    free(source);
+    free(dest);
+    return dest != NULL && check(env, status) ? undefined(env) : NULL;
+}
+
+static napi_value sim_run_until(napi_env env, napi_callback_info info) {
+    napi_value argv[MAX_ARGS];
+    DschedSim *sim = unwrap(env, info, argv);
+    int64_t time;
+    if (sim == NULL) return NULL;
+    if (napi_get_value_int64(env, argv[0], &time) != napi_ok) {
+        napi_throw_type_error(env, NULL, "expected a number");
+        return NULL;
+    }
+    return check(env, dsched_run_until(sim, time)) ? undefined(env) : NULL;
+}
+
+/* Returns false once nothing is left to happen. */
+static napi_value sim_step(napi_env env, napi_callback_info info) {
+    DschedSim *sim = unwrap(env, info, NULL);
+    if (sim == NULL) return NULL;
+    int status = dsched_step(sim);
+    if (!check(env, status)) return NULL;
+    napi_value result;
+    napi_get_boolean(env, status > 0, &result);
+    return result;
+}
+
+static napi_value sim_finish(napi_env env, napi_callback_info info) {
+    DschedSim *sim = unwrap(env, info, NULL);
+    return sim != NULL && check(env, dsched_finish(sim)) ? undefined(env) : NULL;
+}
+
+static napi_value sim_now(napi_env env, napi_callback_info info) {
+    DschedSim *sim = unwrap(env, info, NULL);
+    if (sim == NULL) return NULL;
+    napi_value result;
+    napi_create_int64(env, dsched_now(sim), &result);
+    return result;
+}
+
+static napi_value sim_save(napi_env env, napi_callback_info info) {
+    napi_value argv[MAX_ARGS];
+    DschedSim *sim = unwrap(env, info, argv);
+    char *path = sim != NULL ? get_string(env, argv[0], NULL) : NULL;
+    if (path == NULL) return NULL;
+    int status = dsched_save(sim, path);
+    free(path);
+    return check(env, status) ? undefined(env) : NULL;
+}
+
+static napi_value sim_stats(napi_env env, napi_callback_info info) {
+    DschedSim *sim = unwrap(env, info, NULL);
+    DschedStats stats;
+    if (sim == NULL || !check(env, dsched_stats(sim, &stats))) return NULL;
+
+    napi_value obj;
+    napi_create_object(env, &obj);
+    set_int(env, obj, "time", stats.time);
+    set_int(env, obj, "totalTasks", stats.total_tasks);
+    set_int(env, obj, "completedTasks", stats.completed_tasks);
+    set_int(env, obj, "queuedTasks", stats.queued_tasks);
+    set_int(env, obj, "preemptions", stats.preemptions);
+    set_int(env, obj, "chargingStationUses", stats.charging_station_uses);
+    set_int(env, obj, "loadingBayUses", stats.loading_bay_uses);
+    set_double(env, obj, "meanDeliverySeconds", stats.mean_delivery_seconds);
+    set_int(env, obj, "queueWaitP50Us", stats.queue_wait_p50_us);
+    set_int(env, obj, "queueWaitP99Us", stats.queue_wait_p99_us);
+    set_int(env, obj, "completionP50Us", stats.completion_p50_us);
+    set_int(env, obj, "completionP99Us", stats.completion_p99_us);
+    set_double(env, obj, "chargingUtilization", stats.charging_utilization);
+    set_double(env, obj, "loadingUtilization", stats.loading_utilization);
+    set_int(env, obj, "eventsProcessed", (long long)stats.events_processed);
+    return obj;
+}
+
+static napi_value sim_drones(napi_env env, napi_callback_info info) {
+    DschedSim *sim = unwrap(env, info, NULL);
+    if (sim == NULL) return NULL;
+    int count = dsched_num_drones(sim);
+    napi_value list;
+    napi_create_array_with_length(env, count, &list);
+    for (int i = 0; i < count; i++) {
+        DschedDrone drone;
+        dsched_drone(sim, i, &drone);
+        napi_value obj;
+        napi_create_object(env, &obj);
+        set_int(env, obj, "id", drone.id);
+        set_string(env, obj, "state", drone_states[drone.state]);
+        set_int(env, obj, "battery", drone.battery);
+        set_int(env, obj, "speed", drone.speed);
+        set_int(env, obj, "task", drone.task);
+        set_int(env, obj, "tasksCompleted", drone.tasks_completed);
+        set_int(env, obj, "preemptions", drone.preemptions);
+        set_double(env, obj, "x", drone.x);
+        set_double(env, obj, "y", drone.y);
+        napi_set_element(env, list, i, obj);
+    }
+    return list;
+}
+
+/* The object `--output jsonl` prints for the same event, minus the pickup
+ * and drop-off coordinates, so the UI can take either. */
+static napi_value event_object(napi_env env, DschedSim *sim, const DschedEvent *ev) {
+    napi_value obj;
+    napi_create_object(env, &obj);
+    set_int(env, obj, "time", ev->time);
+    set_string(env, obj, "clock", "virtual");
+    set_string(env, obj, "event", dsched_event_name(ev->type));
+
+    switch (ev->type) {
+        case DSCHED_EVENT_DRONE_ADDED:
+            set_int(env, obj, "drone", ev->drone);
+            set_int(env, obj, "speed", ev->value);
+            set_int(env, obj, "battery", ev->battery);
+            break;
+        case DSCHED_EVENT_TASK_ADDED:
+            set_int(env, obj, "task", ev->task);
+            set_int(env, obj, "priority", ev->priority);
+            set_int(env, obj, "est_time", ev->value);
+            set_string(env, obj, "source", dsched_location_name(sim, ev->source));
+            set_string(env, obj, "destination", dsched_location_name(sim, ev->destination));
+            break;
+        case DSCHED_EVENT_PREEMPTION:
+            set_int(env, obj, "drone", ev->drone);
+            set_int(env, obj, "task", ev->task);
+            set_int(env, obj, "priority", ev->priority);
+            set_int(env, obj, "for_task", ev->aux);
+            break;
+        case DSCHED_EVENT_DISPATCH_BATCH:
+            set_int(env, obj, "count", ev->value);
+            break;
+        case DSCHED_EVENT_LOADING:
+            set_int(env, obj, "drone", ev->drone);
+            set_int(env, obj, "task", ev->task);
+            set_int(env, obj, "priority", ev->priority);
+            set_string(env, obj, "source", dsched_location_name(sim, ev->source));
+            set_string(env, obj, "destination", dsched_location_name(sim, ev->destination));
+            break;
+        case DSCHED_EVENT_ASSIGNED:
+            set_int(env, obj, "drone", ev->drone);
+            set_int(env, obj, "task", ev->task);
+            set_int(env, obj, "priority", ev->priority);
+            break;
+        case DSCHED_EVENT_TASK_COMPLETED:
+        case DSCHED_EVENT_DELIVERY_START:
+            set_int(env, obj, "drone", ev->drone);
+            set_int(env, obj, "task", ev->task);
+            set_int(env, obj, "priority", ev->priority);
+            set_int(env, obj, "battery", ev->battery);
+            set_int(env, obj, "seconds", ev->value);
+            if (ev->type == DSCHED_EVENT_DELIVERY_START) set_int(env, obj, "drain_rate", ev->aux);
+            break;
+        case DSCHED_EVENT_BATTERY_CRITICAL:
+        case DSCHED_EVENT_CHARGE_START:
+        case DSCHED_EVENT_CHARGE_END:
+            set_int(env, obj, "drone", ev->drone);
+            set_int(env, obj, "battery", ev->battery);
+            break;
+        default:
+            set_int(env, obj, "drone", ev->drone);
+            break;
+    }
+    return obj;
+}
+
+/* Drains the events buffered since the last call. */
+static napi_value sim_events(napi_env env, napi_callback_info info) {
+    DschedSim *sim = unwrap(env, info, NULL);
+    if (sim == NULL) return NULL;
+    napi_value list;
+    napi_create_array(env, &list);
+    DschedEvent *batch = (DschedEvent *)malloc(sizeof(DschedEvent) * EVENT_BATCH);
+    uint32_t index = 0;
+    int count;
+    while ((count = dsched_poll_events(sim, batch, EVENT_BATCH)) > 0) {
+        for (int i = 0; i < count; i++) {
+            napi_set_element(env, list, index++, event_object(env, sim, &batch[i]));
+        }
+    }
+    free(batch);
+    return list;
+}
+
+/* Frees the simulation now rather than at garbage collection. */
+static napi_value sim_close(napi_env env, napi_callback_info info) {
+    napi_value self;
+    Handle *handle;
+    napi_get_cb_info(env, info, NULL, NULL, &self, NULL);
+    if (napi_unwrap(env, self, (void **)&handle) != napi_ok) return NULL;
+    dsched_destroy(handle->sim);
+    handle->sim = NULL;
+    return undefined(env);
+}
+
+static napi_value init(napi_env env, napi_value exports) {
+    napi_property_descriptor methods[] = {
+        { "loadConfig", NULL, sim_load_config, NULL, NULL, NULL, napi_default, NULL },
+        { "setWorkload", NULL, sim_set_workload, NULL, NULL, NULL, napi_default, NULL },
+        { "addDrone", NULL, sim_add_drone, NULL, NULL, NULL, napi_default, NULL },
+        { "place", NULL, sim_place, NULL, NULL, NULL, napi_default, NULL },
+        { "addCharger", NULL, sim_add_charger, NULL, NULL, NULL, napi_default, NULL },
+        { "addTask", NULL, sim_add_task, NULL, NULL, NULL, napi_default, NULL },
+        { "runUntil", NULL, sim_run_until, NULL, NULL, NULL, napi_default, NULL },
+        { "step", NULL, sim_step, NULL, NULL, NULL, napi_default, NULL },
+        { "finish", NULL, sim_finish, NULL, NULL, NULL, napi_default, NULL },
+        { "now", NULL, sim_now, NULL, NULL, NULL, napi_default, NULL },
+        { "save", NULL, sim_save, NULL, NULL, NULL, napi_default, NULL },
+        { "stats", NULL, sim_stats, NULL, NULL, NULL, napi_default, NULL },
+        { "drones", NULL, sim_drones, NULL, NULL, NULL, napi_default, NULL },
+        { "events", NULL, sim_events, NULL, NULL, NULL, napi_default, NULL },
+        { "close", NULL, sim_close, NULL, NULL, NULL, napi_default, NULL }
+    };
+    napi_value cls, version;
+    napi_define_class(env, "Simulation", NAPI_AUTO_LENGTH, sim_new, NULL,
+                      sizeof(methods) / sizeof(methods[0]), methods, &cls);
+    napi_set_named_property(env, exports, "Simulation", cls);
+    napi_create_int32(env, dsched_api_version(), &version);
+    napi_set_named_property(env, exports, "apiVersion", version);
+    return exports;
+}
+
+NAPI_MODULE(dronesched, init)
@@ -0,0 +1,50 @@
+// In-process access to the simulator through libdronesched, for queries
+// that are too frequent to pay for a process and a text stream each.
+// Build with `npm run build:native`; until then `available` is false and
+// callers should fall back to spawning drone_scheduler.
+const path = require('path');
+
+let native = null;
+let loadError = null;
+try {
+    native = require(path.join(__dirname, 'dronesched.node'));
+} catch (err) {
+    loadError = err;
+}
+
+const Simulation = native && class Simulation extends native.Simulation {
+    // Resumes a checkpoint written by save() or `drone_scheduler --checkpoint`.
+    static restore(file, options = {}) {
+        return new Simulation({ ...options, restore: file });
+    }
+};
+
+// Runs one what-if to `duration` virtual seconds and returns its statistics
+// and final fleet; with `events` set, also every event in the order the
+// `--output jsonl` stream would list them. `drones` and `tasks` use the same
+// shapes as POST /api/start; `config` takes config-file lines instead.
+function runWhatIf({ drones = [], tasks = [], config = '', workload, duration = 40,
+                     charging = 3, loading = 5, seed = 0, policy, fullCharge = false, events = false }) {
+    const sim = new Simulation({ chargingStations: charging, loadingBays: loading, seed, policy, fullCharge, events });
+    try {
+        if (config) sim.loadConfig(config);
+        if (workload) sim.setWorkload(workload);
+        for (const drone of drones) sim.addDrone(drone.speed, drone.battery, drone.x, drone.y);
+        for (const task of tasks) sim.addTask(task.warehouse, task.customer, task.priority, task.estimatedTime);
+        sim.runUntil(duration);
+        sim.finish();
+        const result = { stats: sim.stats(), drones: sim.drones() };
+        if (events) result.events = sim.events();
+        return result;
+    } finally {
+        sim.close();
+    }
+}
+
+module.exports = {
+    available: native !== null,
+    loadError,
+    apiVersion: native ? native.apiVersion : null,
+    Simulation,
+    runWhatIf
+};
@@ -1,7 +1,11 @@
 const express = require('express');
 const cors = require('cors');
 const { spawn } = require('child_process');
+const net = require('net');
 const path = require('path');
+const fs = require('fs');
+const os = require('os');
+const dronesched = require('../native');
 
 const app = express();
 const PORT = 5000;
@@ -10,13 +14,31 @@ app.use(cors());
 app.use(express.json());
 app.use(express.static(path.join(__dirname, '../../../public')));
 
+const executablePath = path.join(__dirname, '../../c_core/drone_scheduler');
+
 let simulationProcess = null;
 let clients = [];
 
+// The simulator rewrites this file with Prometheus-format metrics every second.
+const metricsPath = path.join(os.tmpdir(), `drone-sim-metrics-${process.pid}.prom`);
+
+function broadcast(message) {
+    const payload = `data: ${JSON.stringify(message)}\n\n`;
+    clients.forEach(client => {
+        if (!client.finished) {
+            client.write(payload);
+        }
+    });
+}
+
 app.get('/api/status', (req, res) => {
+    const active = [...jobs.values()].filter(job => job.finished === null);
     res.json({ 
         running: simulationProcess !== null,
-        clients: clients.length
+        clients: clients.length,
+        service: serviceReady,
+        jobsQueued: active.filter(job => job.status === 'queued').length,
+        jobsRunning: active.filter(job => job.status === 'running').length
     });
 });
 
@@ -39,11 +61,12 @@ app.post('/api/start', (req, res) => {
         '--charging', charging.toString(),
         '--loading', loading.toString(),
         '--duration', duration.toString(),
-        '--config', 'stdin'
+        '--config', 'stdin',
+        '--live',
+        '--metrics', metricsPath,
+        '--output', 'jsonl'
     ];
 
-    const executablePath = path.join(__dirname, '../../c_core/drone_scheduler');
-    
     simulationProcess = spawn(executablePath, args);
     
     let configInput = '';
@@ -57,42 +80,382 @@ app.post('/api/start', (req, res) => {
     
     configInput += 'START\n';
     
+    // stdin stays open: /api/tasks keeps feeding the running simulation.
+    simulationProcess.stdin.on('error', (err) => {
+        console.error(`Simulation stdin: ${err.message}`);
+    });
     simulationProcess.stdin.write(configInput);
-    simulationProcess.stdin.end();
     
+    // The simulator writes one JSON event per line; chunks can split a line,
+    // so hold the trailing fragment until the rest arrives.
+    let pending = '';
+    simulationProcess.stdout.setEncoding('utf8');
     simulationProcess.stdout.on('data', (data) => {
-        const output = data.toString();
-        console.log(output);
-        
-        clients.forEach(client => {
-            if (!client.finished) {
-                client.write(`data: ${JSON.stringify({ type: 'log', data: output })}\n\n`);
+        pending += data;
+        const lines = pending.split('\n');
+        pending = lines.pop();
+
+        lines.forEach(line => {
+            if (line.length === 0) return;
+            let message;
+            try {
+                message = { type: 'event', event: JSON.parse(line) };
+            } catch (err) {
+                message = { type: 'log', data: line };
             }
+            broadcast(message);
         });
     });
 
     simulationProcess.stderr.on('data', (data) => {
         console.error(`Error: ${data}`);
-        clients.forEach(client => {
-            if (!client.finished) {
-                client.write(`data: ${JSON.stringify({ type: 'error', data: data.toString() })}\n\n`);
-            }
-        });
+        broadcast({ type: 'error', data: data.toString() });
     });
 
     simulationProcess.on('close', (code) => {
         console.log(`Simulation process exited with code ${code}`);
-        clients.forEach(client => {
-            if (!client.finished) {
-                client.write(`data: ${JSON.stringify({ type: 'complete', code })}\n\n`);
-            }
-        });
+        broadcast({ type: 'complete', code });
         simulationProcess = null;
+        fs.unlink(metricsPath, () => {});
     });
 
     res.json({ success: true, message: 'Simulation started' });
 });
 
+// A config line is whitespace separated, so names must stay on one line.
+function isName(value) {
+    return typeof value === 'string' && value.trim().length > 0 && !/[\r\n]/.test(value);
+}
+
+function inRange(value, min, max) {
+    return Number.isInteger(value) && value >= min && value <= max;
+}
+
+app.post('/api/tasks', (req, res) => {
+    if (!simulationProcess) {
+        return res.status(400).json({ error: 'No simulation running' });
+    }
+
+    const { drones = [], tasks = [] } = req.body;
+    if (!Array.isArray(drones) || !Array.isArray(tasks) || drones.length + tasks.length === 0) {
+        return res.status(400).json({ error: 'Send at least one drone or task' });
+    }
+
+    let input = '';
+    for (const drone of drones) {
+        if (!inRange(drone.speed, 1, 3) || !inRange(drone.battery, 20, 100)) {
+            return res.status(400).json({ error: 'Drones need speed 1-3 and battery 20-100' });
+        }
+        input += `DRONE ${drone.speed} ${drone.battery}\n`;
+    }
+    for (const task of tasks) {
+        if (!isName(task.warehouse) || !isName(task.customer) ||
+            !inRange(task.priority, 1, 3) || !inRange(task.estimatedTime, 1, 100)) {
+            return res.status(400).json({ error: 'Tasks need a warehouse, customer, priority 1-3 and time 1-100' });
+        }
+        input += `TASK ${task.warehouse} ${task.customer} ${task.priority} ${task.estimatedTime}\n`;
+    }
+
+    simulationProcess.stdin.write(input);
+    res.json({ success: true, drones: drones.length, tasks: tasks.length });
+});
+
+// Checks a one-off scenario as /api/whatif and /api/jobs take it; returns
+// what is wrong with it, or null.
+function scenarioError({ drones, tasks, charging, loading, duration }) {
+    if (!Array.isArray(drones) || !Array.isArray(tasks) || drones.length === 0 || tasks.length === 0) {
+        return 'At least one drone and one task are required';
+    }
+    if (!inRange(charging, 0, 1000) || !inRange(loading, 0, 1000) || !inRange(duration, 1, 7 * 86400)) {
+        return 'Need charging and loading 0-1000 and duration 1-604800';
+    }
+    for (const drone of drones) {
+        if (!inRange(drone.speed, 1, 3) || !inRange(drone.battery, 20, 100)) {
+            return 'Drones need speed 1-3 and battery 20-100';
+        }
+    }
+    for (const task of tasks) {
+        if (!isName(task.warehouse) || !isName(task.customer) ||
+            !inRange(task.priority, 1, 3) || !inRange(task.estimatedTime, 1, 100)) {
+            return 'Tasks need a warehouse, customer, priority 1-3 and time 1-100';
+        }
+    }
+    return null;
+}
+
+// What-if queries run in-process through libdronesched: no process to start
+// and no text to parse, so they can be fired as often as the UI likes. They
+// need the addon (`npm run build:native`) and are independent of the live
+// simulation above.
+app.post('/api/whatif', (req, res) => {
+    if (!dronesched.available) {
+        return res.status(503).json({ error: 'Native simulator not built (npm run build:native)' });
+    }
+
+    const { drones = [], tasks = [], charging = 3, loading = 5, duration = 40,
+            policy, seed = 0, fullCharge = false, events = false } = req.body;
+    const error = scenarioError({ drones, tasks, charging, loading, duration });
+    if (error) {
+        return res.status(400).json({ error });
+    }
+
+    try {
+        res.json(dronesched.runWhatIf({ drones, tasks, charging, loading, duration,
+                                        policy, seed, fullCharge, events: events === true }));
+    } catch (err) {
+        res.status(400).json({ error: err.message });
+    }
+});
+
+// Scenario jobs run concurrently on one long-lived `drone_scheduler --serve`:
+// a queue in front of a pool of worker threads (one per core), so planners
+// can submit many runs at once instead of taking turns on the live
+// simulation above. Each job is one connection to the service's socket and
+// has its own event stream at /api/jobs/:id/stream.
+const servicePath = path.join(os.tmpdir(), `drone-sim-service-${process.pid}.sock`);
+const MAX_FINISHED_JOBS = 200;
+const MAX_JOB_BACKLOG = 100000;
+
+let service = null;
+let serviceReady = false;
+let waitingJobs = [];
+const jobs = new Map();
+let nextJobId = 1;
+
+function startService() {
+    serviceReady = false;
+    service = spawn(executablePath, ['--serve', servicePath]);
+
+    let pending = '';
+    service.stderr.setEncoding('utf8');
+    service.stderr.on('data', (data) => {
+        pending += data;
+        const lines = pending.split('\n');
+        pending = lines.pop();
+        lines.forEach(line => {
+            if (!serviceReady && line.startsWith('[Serve] Listening')) {
+                serviceReady = true;
+                waitingJobs.forEach(connectJob);
+                waitingJobs = [];
+            } else if (!line.startsWith('[Serve]')) {
+                console.error(`Simulation service: ${line}`);
+            }
+        });
+    });
+    service.on('error', (err) => {
+        console.error(`Simulation service: ${err.message}`);
+    });
+    // Jobs on a service that dies fail with their connections; new ones
+    // wait for the replacement.
+    service.on('close', (code) => {
+        console.error(`Simulation service exited with code ${code}, restarting`);
+        service = null;
+        serviceReady = false;
+        setTimeout(startService, 1000);
+    });
+}
+
+function jobSummary(job) {
+    return {
+        id: job.id,
+        status: job.status,
+        submitted: job.submitted,
+        started: job.started,
+        finished: job.finished,
+        events: job.events,
+        completedTasks: job.completedTasks,
+        error: job.error
+    };
+}
+
+// Messages are kept so a stream opened late still sees the run; past
+// MAX_JOB_BACKLOG only the latest are, and `dropped` counts the rest.
+function publish(job, message) {
+    const payload = `data: ${JSON.stringify(message)}\n\n`;
+    job.backlog.push(payload);
+    if (job.backlog.length > 2 * MAX_JOB_BACKLOG) {
+        job.dropped += job.backlog.length - MAX_JOB_BACKLOG;
+        job.backlog = job.backlog.slice(-MAX_JOB_BACKLOG);
+    }
+    job.clients.forEach(client => client.write(payload));
+}
+
+function finishJob(job, status, error) {
+    if (job.finished !== null) return;
+    job.status = status;
+    job.error = error || null;
+    job.finished = Date.now();
+    job.socket = null;
+    publish(job, { type: 'complete', status, error: job.error });
+    job.clients.forEach(client => client.end());
+    job.clients = [];
+
+    const finished = [...jobs.values()].filter(other => other.finished !== null);
+    for (let i = 0; i < finished.length - MAX_FINISHED_JOBS; i++) {
+        jobs.delete(finished[i].id);
+    }
+}
+
+// The service answers with the jsonl event stream and closes, or with one
+// ERROR line.
+function connectJob(job) {
+    const socket = net.createConnection(servicePath);
+    job.socket = socket;
+    socket.setEncoding('utf8');
+    socket.on('connect', () => socket.write(job.input));
+
+    let pending = '';
+    socket.on('data', (data) => {
+        if (job.status === 'queued') {
+            job.status = 'running';
+            job.started = Date.now();
+        }
+        pending += data;
+        const lines = pending.split('\n');
+        pending = lines.pop();
+
+        lines.forEach(line => {
+            if (line.length === 0) return;
+            if (line.startsWith('ERROR ')) {
+                job.error = line.slice(6);
+                return;
+            }
+            let message;
+            try {
+                const event = JSON.parse(line);
+                job.events++;
+                if (event.event === 'task_completed') job.completedTasks++;
+                message = { type: 'event', event };
+            } catch (err) {
+                message = { type: 'log', data: line };
+            }
+            publish(job, message);
+        });
+    });
+    socket.on('error', (err) => {
+        job.error = job.error || err.message;
+    });
+    socket.on('close', () => {
+        finishJob(job, job.error ? 'failed' : 'done', job.error);
+    });
+}
+
+app.post('/api/jobs', (req, res) => {
+    const { drones = [], tasks = [], charging = 3, loading = 5, duration = 40,
+            policy, seed, fullCharge = false, workload } = req.body;
+    const error = scenarioError({ drones, tasks, charging, loading, duration });
+    if (error) {
+        return res.status(400).json({ error });
+    }
+    if ((policy !== undefined && !/^[a-z-]+$/.test(policy)) ||
+        (seed !== undefined && !inRange(seed, 0, Number.MAX_SAFE_INTEGER)) ||
+        (workload !== undefined && (typeof workload !== 'string' || !/^[a-z0-9.,=:]+$/i.test(workload)))) {
+        return res.status(400).json({ error: 'Need a policy name, a non-negative integer seed and a workload spec' });
+    }
+
+    let header = `JOB duration=${duration} charging=${charging} loading=${loading} output=jsonl`;
+    if (policy !== undefined) header += ` policy=${policy}`;
+    if (seed !== undefined) header += ` seed=${seed}`;
+    if (workload !== undefined) header += ` workload=${workload}`;
+    if (fullCharge === true) header += ' full-charge';
+
+    let input = `${header}\n`;
+    drones.forEach(drone => {
+        input += `DRONE ${drone.speed} ${drone.battery}\n`;
+    });
+    tasks.forEach(task => {
+        input += `TASK ${task.warehouse} ${task.customer} ${task.priority} ${task.estimatedTime}\n`;
+    });
+    input += 'START\n';
+
+    const job = {
+        id: String(nextJobId++),
+        status: 'queued',
+        submitted: Date.now(),
+        started: null,
+        finished: null,
+        events: 0,
+        completedTasks: 0,
+        error: null,
+        input,
+        socket: null,
+        backlog: [],
+        dropped: 0,
+        clients: []
+    };
+    jobs.set(job.id, job);
+    if (serviceReady) {
+        connectJob(job);
+    } else {
+        waitingJobs.push(job);
+    }
+    res.status(202).json(jobSummary(job));
+});
+
+app.get('/api/jobs', (req, res) => {
+    res.json([...jobs.values()].map(jobSummary));
+});
+
+app.get('/api/jobs/:id', (req, res) => {
+    const job = jobs.get(req.params.id);
+    if (!job) {
+        return res.status(404).json({ error: 'No such job' });
+    }
+    res.json(jobSummary(job));
+});
+
+app.get('/api/jobs/:id/stream', (req, res) => {
+    const job = jobs.get(req.params.id);
+    if (!job) {
+        return res.status(404).json({ error: 'No such job' });
+    }
+
+    res.setHeader('Content-Type', 'text/event-stream');
+    res.setHeader('Cache-Control', 'no-cache');
+    res.setHeader('Connection', 'keep-alive');
+
+    res.write(`data: ${JSON.stringify({ type: 'connected', job: job.id, dropped: job.dropped })}\n\n`);
+    job.backlog.forEach(payload => res.write(payload));
+    if (job.finished !== null) {
+        return res.end();
+    }
+
+    job.clients.push(res);
+    req.on('close', () => {
+        job.clients = job.clients.filter(client => client !== res);
+    });
+});
+
+// Closing the connection cancels the job; the service stops it at its next
+// slice and frees the worker.
+app.delete('/api/jobs/:id', (req, res) => {
+    const job = jobs.get(req.params.id);
+    if (!job) {
+        return res.status(404).json({ error: 'No such job' });
+    }
+    if (job.finished !== null) {
+        return res.status(400).json({ error: `Job already ${job.status}` });
+    }
+
+    waitingJobs = waitingJobs.filter(other => other !== job);
+    if (job.socket) job.socket.destroy();
+    finishJob(job, 'cancelled');
+    res.json(jobSummary(job));
+});
+
+app.get('/api/metrics', (req, res) => {
+    if (!simulationProcess) {
+        return res.status(503).type('text/plain').send('No simulation running\n');
+    }
+
+    fs.readFile(metricsPath, 'utf8', (err, text) => {
+        if (err) {
+            return res.status(503).type('text/plain').send('Metrics not available yet\n');
+        }
+        res.type('text/plain; version=0.0.4').send(text);
+    });
+});
+
 app.post('/api/stop', (req, res) => {
     if (!simulationProcess) {
         return res.status(400).json({ error: 'No simulation running' });
@@ -123,6 +486,11 @@ app.get('/', (req, res) => {
     res.sendFile(path.join(__dirname, '../../../public/index.html'));
 });
 
+startService();
+process.on('exit', () => {
+    if (service) service.kill();
+});
+
 app.listen(PORT, '0.0.0.0', () => {
     console.log(`Server running on http://0.0.0.0:${PORT}`);
 });